@@ -3,35 +3,52 @@ import express from 'express';
 import mongoSanitize from 'express-mongo-sanitize';
 import { CreateRoomUseCase } from './application/use-cases/create-room.usecase';
 import { CreateUserUseCase } from './application/use-cases/create-user.usecase';
+import { AbortUploadSessionUseCase } from './application/use-cases/abort-upload-session.usecase';
+import { AppendUploadChunkUseCase } from './application/use-cases/append-upload-chunk.usecase';
+import { AttachThumbnailsUseCase } from './application/use-cases/attach-thumbnails.usecase';
+import { CommitDeltaUploadUseCase } from './application/use-cases/commit-delta-upload.usecase';
+import { CompleteUploadSessionUseCase } from './application/use-cases/complete-upload-session.usecase';
+import { CreateUploadSessionUseCase } from './application/use-cases/create-upload-session.usecase';
 import { DeleteMediaUseCase } from './application/use-cases/delete-media.usecase';
+import { FindDuplicateMediaUseCase } from './application/use-cases/find-duplicate-media.usecase';
+import { FindMissingChunksUseCase } from './application/use-cases/find-missing-chunks.usecase';
 import { GetMediaByIdUseCase } from './application/use-cases/get-media-by-id.usecase';
 import { GetPublicRoomsUseCase } from './application/use-cases/get-public-rooms.usecase';
+import { GetUploadSessionUseCase } from './application/use-cases/get-upload-session.usecase';
 import { GetUserMediaUseCase } from './application/use-cases/get-user-media.usecase';
 import { IncreaseStorageUseCase } from './application/use-cases/increase-storage.usecase';
 import { LoginUseCase } from './application/use-cases/login.usecase';
 import { LogoutUseCase } from './application/use-cases/logout.usecase';
+import { PresignUploadPartsUseCase } from './application/use-cases/presign-upload-parts.usecase';
 import { RefreshTokenUseCase } from './application/use-cases/refresh-token.usecase';
+import { StoreDeltaChunkUseCase } from './application/use-cases/store-delta-chunk.usecase';
+import { UploadMediaBatchUseCase } from './application/use-cases/upload-media-batch.usecase';
 import { UploadMediaUseCase } from './application/use-cases/upload-media.usecase';
 import { HTTP_STATUS } from './infrastructure/constants/http-status';
 import { BcryptPasswordService } from './infrastructure/crypto/bcrypt-password.service';
 import { MediaRepository } from './infrastructure/db/mongoose/repositories/media.repository';
+import { UploadSessionRepository } from './infrastructure/db/mongoose/repositories/upload-session.repository';
 import { RoomRepository } from './infrastructure/db/mongoose/repositories/room.repository';
 import { TokenRepository } from './infrastructure/db/mongoose/repositories/token.repository';
 import { UserRepository } from './infrastructure/db/mongoose/repositories/user.repository';
 import { AuthService } from './infrastructure/services/auth.service';
 import { LoggingService } from './infrastructure/services/logging.service';
 import { RoomStateService } from './infrastructure/services/room-state.service';
+import { LocalChunkStore } from './infrastructure/services/local-chunk-store.service';
 import { S3UploadService } from './infrastructure/services/s3-upload.service';
 import { SocketService } from './infrastructure/services/socket.service';
 import { StoragePricingService } from './infrastructure/services/storage-pricing.service';
 import { StorageService } from './infrastructure/services/storage.service';
 import { StripeService } from './infrastructure/services/stripe.service';
 import { ThumbnailService } from './infrastructure/services/thumbnail.service';
+import { UploadStagingService } from './infrastructure/services/upload-staging.service';
 
 import { AuthController } from './interface/http/controllers/auth.controller';
+import { DeltaSyncController } from './interface/http/controllers/delta-sync.controller';
 import { MediaController } from './interface/http/controllers/media.controller';
 import { RoomController } from './interface/http/controllers/room.controller';
 import { StorageController } from './interface/http/controllers/storage.controller';
+import { UploadSessionController } from './interface/http/controllers/upload-session.controller';
 import { UserController } from './interface/http/controllers/user.controller';
 import { globalErrorHandler, requestIdMiddleware } from './interface/http/middlewares';
 import { helmetConfig, rateLimiterConfig } from './interface/http/middlewares/configurations';
@@ -61,12 +78,24 @@ const authService = new AuthService();
 const roomStateService = new RoomStateService();
 const s3UploadService = new S3UploadService();
 const thumbnailService = new ThumbnailService(s3UploadService);
+const uploadStagingService = new UploadStagingService();
+// Clients send large files straight to object storage unless DIRECT_UPLOADS=false
+const directUploadService = process.env.DIRECT_UPLOADS === 'false' ? undefined : s3UploadService;
+// Chunks of synced files, so changed files are rebuilt from what is already
+// here. They must outlive restarts, so delta sync is off unless CHUNK_STORE_DIR is set.
+const chunkStore = process.env.CHUNK_STORE_DIR
+	? new LocalChunkStore(process.env.CHUNK_STORE_DIR)
+	: undefined;
+if (!chunkStore) {
+	loggingService.warn('CHUNK_STORE_DIR is not set; delta sync is disabled');
+}
 
 // 2. Initialize repositories
 const userRepository = new UserRepository();
 const tokenRepository = new TokenRepository();
 const mediaRepository = new MediaRepository();
 const roomRepository = new RoomRepository();
+const uploadSessionRepository = new UploadSessionRepository();
 
 // 2.5. Initialize storage services (after repositories)
 const storageService = new StorageService(mediaRepository, userRepository, loggingService);
@@ -96,9 +125,64 @@ const uploadMediaUseCase = new UploadMediaUseCase(
 	storageService,
 	loggingService,
 );
+const uploadMediaBatchUseCase = new UploadMediaBatchUseCase(
+	mediaRepository,
+	s3UploadService,
+	thumbnailService,
+	storageService,
+	loggingService,
+);
 const getUserMediaUseCase = new GetUserMediaUseCase(mediaRepository, loggingService);
 const getMediaByIdUseCase = new GetMediaByIdUseCase(mediaRepository, loggingService);
-const deleteMediaUseCase = new DeleteMediaUseCase(mediaRepository, s3UploadService, loggingService);
+const deleteMediaUseCase = new DeleteMediaUseCase(
+	mediaRepository,
+	s3UploadService,
+	loggingService,
+	chunkStore,
+);
+const findDuplicateMediaUseCase = new FindDuplicateMediaUseCase(mediaRepository, loggingService);
+const createUploadSessionUseCase = new CreateUploadSessionUseCase(
+	uploadSessionRepository,
+	storageService,
+	loggingService,
+	directUploadService,
+);
+const getUploadSessionUseCase = new GetUploadSessionUseCase(
+	uploadSessionRepository,
+	loggingService,
+	s3UploadService,
+);
+const appendUploadChunkUseCase = new AppendUploadChunkUseCase(
+	uploadSessionRepository,
+	uploadStagingService,
+	loggingService,
+);
+const completeUploadSessionUseCase = new CompleteUploadSessionUseCase(
+	uploadSessionRepository,
+	uploadStagingService,
+	mediaRepository,
+	s3UploadService,
+	thumbnailService,
+	storageService,
+	loggingService,
+	s3UploadService,
+);
+const abortUploadSessionUseCase = new AbortUploadSessionUseCase(
+	uploadSessionRepository,
+	uploadStagingService,
+	loggingService,
+	s3UploadService,
+);
+const presignUploadPartsUseCase = new PresignUploadPartsUseCase(
+	uploadSessionRepository,
+	s3UploadService,
+	loggingService,
+);
+const attachThumbnailsUseCase = new AttachThumbnailsUseCase(
+	mediaRepository,
+	thumbnailService,
+	loggingService,
+);
 const increaseStorageUseCase = new IncreaseStorageUseCase(
 	userRepository,
 	storagePricingService,
@@ -119,8 +203,51 @@ const mediaController = new MediaController(
 	getUserMediaUseCase,
 	getMediaByIdUseCase,
 	deleteMediaUseCase,
+	findDuplicateMediaUseCase,
+	uploadMediaBatchUseCase,
+	attachThumbnailsUseCase,
+	loggingService,
+);
+const uploadSessionController = new UploadSessionController(
+	createUploadSessionUseCase,
+	getUploadSessionUseCase,
+	appendUploadChunkUseCase,
+	completeUploadSessionUseCase,
+	abortUploadSessionUseCase,
+	presignUploadPartsUseCase,
 	loggingService,
 );
+const deltaSyncController = chunkStore
+	? new DeltaSyncController(
+			new FindMissingChunksUseCase(chunkStore, loggingService),
+			new StoreDeltaChunkUseCase(chunkStore, storageService, loggingService),
+			new CommitDeltaUploadUseCase(
+				chunkStore,
+				uploadStagingService,
+				mediaRepository,
+				s3UploadService,
+				thumbnailService,
+				storageService,
+				loggingService,
+			),
+			loggingService,
+		)
+	: undefined;
+if (chunkStore) {
+	// Chunks of syncs that never committed, and of media whose release
+	// failed, would otherwise stay forever
+	setInterval(
+		() => {
+			chunkStore
+				.expirePending(StoreDeltaChunkUseCase.PENDING_TTL_MS)
+				.then(() => chunkStore.sweepUnreferenced())
+				.catch((error) => {
+					loggingService.error('Failed to expire delta chunks', error);
+				});
+		},
+		60 * 60 * 1000,
+	).unref();
+}
 const storageController = new StorageController(
 	storageService,
 	storagePricingService,
@@ -145,7 +272,10 @@ app.use(mongoSanitize());
 app.use('/api/v1/users', createUserRoutes(userController, authService));
 app.use('/api/v1/auth', createAuthRoutes(authController, authService));
 app.use('/api/v1/rooms', createRoomRoutes(roomController, authService, loggingService));
-app.use('/api/v1/media', createMediaRoutes(mediaController, authService));
+app.use(
+	'/api/v1/media',
+	createMediaRoutes(mediaController, authService, uploadSessionController, deltaSyncController),
+);
 app.use('/api/v1/storage', createStorageRoutes(storageController, authService));
 
 // 404 handler for undefined routes
@@ -168,6 +298,14 @@ app.use('*', (_req, res) => {
 			'POST /api/v1/rooms/create',
 			'GET /api/v1/rooms/:roomCode',
 			'POST /api/v1/media/upload',
+			'POST /api/v1/media/upload-batch',
+			'POST /api/v1/media/dedupe-check',
+			'POST /api/v1/media/uploads',
+			'GET /api/v1/media/uploads/:sessionId',
+			'PUT /api/v1/media/uploads/:sessionId/chunks',
+			'POST /api/v1/media/uploads/:sessionId/parts',
+			'POST /api/v1/media/uploads/:sessionId/complete',
+			'DELETE /api/v1/media/uploads/:sessionId',
 			'GET /api/v1/media/my-media',
 			'GET /api/v1/media/:id',
 			'DELETE /api/v1/media/:id',
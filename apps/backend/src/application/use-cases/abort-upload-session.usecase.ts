@@ -0,0 +1,61 @@
+import { IUploadSessionRepository } from '../../domain/repositories/iupload-session.repository';
+import { IDirectUploadService } from '../../domain/services/idirect-upload.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IUploadStagingService } from '../../domain/services/iupload-staging.service';
+
+export interface AbortUploadSessionInput {
+	sessionId: string;
+	userId: string;
+}
+
+export interface AbortUploadSessionResult {
+	success: boolean;
+	message: string;
+}
+
+export class AbortUploadSessionUseCase {
+	constructor(
+		private readonly uploadSessionRepository: IUploadSessionRepository,
+		private readonly uploadStagingService: IUploadStagingService,
+		private readonly loggingService: ILoggingService,
+		private readonly directUploadService?: IDirectUploadService,
+	) {}
+
+	async execute(input: AbortUploadSessionInput): Promise<AbortUploadSessionResult> {
+		const session = await this.uploadSessionRepository.findById(input.sessionId);
+
+		if (!session || !session.belongsTo(input.userId)) {
+			return { success: false, message: 'Upload session not found' };
+		}
+
+		await this.uploadSessionRepository.updateStatus(session.id, 'aborted');
+		if (session.isDirect()) {
+			await this.abortDirectUpload(session.storageKey, session.storageUploadId);
+		} else {
+			await this.uploadStagingService.discard(session.id);
+		}
+
+		this.loggingService.info('Upload session aborted', {
+			sessionId: session.id,
+			userId: input.userId,
+			receivedBytes: session.receivedBytes,
+		});
+
+		return { success: true, message: 'Upload session aborted' };
+	}
+
+	private async abortDirectUpload(key: string, uploadId: string): Promise<void> {
+		if (!this.directUploadService) {
+			return;
+		}
+		try {
+			await this.directUploadService.abortMultipartUpload(key, uploadId);
+		} catch (error) {
+			// Storage expires incomplete uploads on its own; the session is aborted either way
+			this.loggingService.warn('Failed to abort multipart upload in storage', {
+				key,
+				error: error instanceof Error ? error.message : 'Unknown error',
+			});
+		}
+	}
+}
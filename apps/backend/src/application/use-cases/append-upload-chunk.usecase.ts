@@ -0,0 +1,106 @@
+import { Readable } from 'stream';
+import { UploadSession } from '../../domain/entities/upload-session.entity';
+import { IUploadSessionRepository } from '../../domain/repositories/iupload-session.repository';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IUploadStagingService } from '../../domain/services/iupload-staging.service';
+
+export interface AppendUploadChunkInput {
+	sessionId: string;
+	userId: string;
+	offset: number;
+	chunk: Readable;
+}
+
+export interface AppendUploadChunkResult {
+	success: boolean;
+	message: string;
+	receivedBytes: number;
+	offsetMismatch?: boolean;
+	wrongMode?: boolean;
+	session?: UploadSession;
+}
+
+export class AppendUploadChunkUseCase {
+	// Upper bound on a single chunk request
+	static readonly MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+
+	constructor(
+		private readonly uploadSessionRepository: IUploadSessionRepository,
+		private readonly uploadStagingService: IUploadStagingService,
+		private readonly loggingService: ILoggingService,
+	) {}
+
+	async execute(input: AppendUploadChunkInput): Promise<AppendUploadChunkResult> {
+		const session = await this.uploadSessionRepository.findById(input.sessionId);
+
+		if (!session || !session.belongsTo(input.userId)) {
+			return { success: false, message: 'Upload session not found', receivedBytes: 0 };
+		}
+
+		if (!session.isActive()) {
+			return {
+				success: false,
+				message: 'Upload session is no longer active',
+				receivedBytes: session.receivedBytes,
+			};
+		}
+
+		if (session.isDirect()) {
+			return {
+				success: false,
+				message: 'Parts of a direct upload go to storage, not here',
+				receivedBytes: 0,
+				wrongMode: true,
+			};
+		}
+
+		// Only the next unacknowledged byte may be written; the client resumes from receivedBytes
+		if (!UploadSession.validateOffset(input.offset, session)) {
+			return {
+				success: false,
+				message: 'Offset does not match received bytes',
+				receivedBytes: session.receivedBytes,
+				offsetMismatch: true,
+			};
+		}
+
+		const maxBytes = Math.min(session.getRemainingBytes(), AppendUploadChunkUseCase.MAX_CHUNK_SIZE);
+		const written = await this.uploadStagingService.writeChunk(
+			session.id,
+			input.offset,
+			input.chunk,
+			maxBytes,
+		);
+
+		const updated = await this.uploadSessionRepository.advanceOffset(
+			session.id,
+			input.offset,
+			input.offset + written,
+		);
+
+		if (!updated) {
+			// Another request acknowledged this range first
+			const current = await this.uploadSessionRepository.findById(session.id);
+			return {
+				success: false,
+				message: 'Offset does not match received bytes',
+				receivedBytes: current?.receivedBytes ?? session.receivedBytes,
+				offsetMismatch: true,
+			};
+		}
+
+		this.loggingService.debug('Upload chunk stored', {
+			sessionId: session.id,
+			offset: input.offset,
+			bytes: written,
+			receivedBytes: updated.receivedBytes,
+		});
+
+		return {
+			success: true,
+			message: 'Chunk stored',
+			receivedBytes: updated.receivedBytes,
+			session: updated,
+		};
+	}
+}
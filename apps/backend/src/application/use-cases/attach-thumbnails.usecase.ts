@@ -0,0 +1,66 @@
+import { Media } from '../../domain/entities/media.entity';
+import { IMediaRepository } from '../../domain/repositories/imedia.repository';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IThumbnailService } from '../../domain/services/ithumbnail.service';
+
+export interface AttachThumbnailsInput {
+	mediaId: string;
+	userId: string;
+	thumbnails: Buffer[]; // JPEG, made by the client
+}
+
+export interface AttachThumbnailsResult {
+	media: Media;
+	thumbnails: string[];
+}
+
+// JPEG files start with an SOI marker followed by another marker
+const isJpeg = (data: Buffer) => data.length > 3 && data[0] === 0xff && data[1] === 0xd8 && data[2] === 0xff;
+
+export class AttachThumbnailsUseCase {
+	static readonly MAX_THUMBNAILS = 4;
+	static readonly MAX_THUMBNAIL_SIZE = 512 * 1024; // 512KB
+
+	constructor(
+		private readonly mediaRepository: IMediaRepository,
+		private readonly thumbnailService: IThumbnailService,
+		private readonly loggingService: ILoggingService,
+	) {}
+
+	async execute(input: AttachThumbnailsInput): Promise<AttachThumbnailsResult> {
+		const media = await this.mediaRepository.findById(input.mediaId);
+		if (!media || media.uploadedBy !== input.userId) {
+			throw new Error('Media not found');
+		}
+
+		// Only images: video thumbnails still come from the server's own frames
+		if (!media.mimeType.startsWith('image/')) {
+			throw new Error('Thumbnails can only be attached to images');
+		}
+
+		// Sent again after a lost response, or the media already has some
+		if (media.thumbnails.length > 0) {
+			return { media, thumbnails: media.thumbnails };
+		}
+
+		if (input.thumbnails.length === 0 || input.thumbnails.some((data) => !isJpeg(data))) {
+			throw new Error('Thumbnails must be JPEG images');
+		}
+
+		// Stored as sent; the server never decodes them
+		const thumbnails = await this.thumbnailService.storeThumbnails(input.thumbnails, media.filename);
+		const updated = await this.mediaRepository.update(media.id, { thumbnails });
+		if (!updated) {
+			throw new Error('Media not found');
+		}
+
+		this.loggingService.info('Client thumbnails attached', {
+			mediaId: media.id,
+			userId: input.userId,
+			thumbnailCount: thumbnails.length,
+			bytes: input.thumbnails.reduce((sum, data) => sum + data.length, 0),
+		});
+
+		return { media: updated, thumbnails };
+	}
+}
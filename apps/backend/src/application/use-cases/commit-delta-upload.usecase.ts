@@ -0,0 +1,131 @@
+import { v4 as uuidv4 } from 'uuid';
+import { Media } from '../../domain/entities/media.entity';
+import { IMediaRepository } from '../../domain/repositories/imedia.repository';
+import { ChunkRef, IChunkStore } from '../../domain/services/ichunk-store.service';
+import { IFileUploadService } from '../../domain/services/ifile-upload.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IStorageService } from '../../domain/services/istorage.service';
+import { IThumbnailService } from '../../domain/services/ithumbnail.service';
+import { IUploadStagingService } from '../../domain/services/iupload-staging.service';
+
+export interface CommitDeltaUploadInput {
+	userId: string;
+	fileName: string;
+	mimeType: string;
+	fileSize: number;
+	title?: string;
+	description?: string;
+	contentHash?: string;
+	duration?: number;
+	chunks: ChunkRef[];
+}
+
+export interface CommitDeltaUploadResult {
+	success: boolean;
+	message: string;
+	media?: Media;
+	missing?: string[];
+}
+
+export class CommitDeltaUploadUseCase {
+	constructor(
+		private readonly chunkStore: IChunkStore,
+		private readonly uploadStagingService: IUploadStagingService,
+		private readonly mediaRepository: IMediaRepository,
+		private readonly fileUploadService: IFileUploadService,
+		private readonly thumbnailService: IThumbnailService,
+		private readonly storageService: IStorageService,
+		private readonly loggingService: ILoggingService,
+	) {}
+
+	async execute(input: CommitDeltaUploadInput): Promise<CommitDeltaUploadResult> {
+		if (
+			!input.mimeType.startsWith('video/') &&
+			!input.mimeType.startsWith('audio/') &&
+			!input.mimeType.startsWith('image/')
+		) {
+			throw new Error('Unsupported file type');
+		}
+
+		const total = input.chunks.reduce((sum, chunk) => sum + chunk.size, 0);
+		if (total !== input.fileSize) {
+			throw new Error('Chunk sizes do not add up to the file size');
+		}
+
+		// The client checked before sending, but chunks may have been sent by
+		// a request that failed since; it sends these and commits again
+		const missing = await this.chunkStore.findMissing(input.userId, [
+			...new Set(input.chunks.map((chunk) => chunk.hash)),
+		]);
+		if (missing.length > 0) {
+			return { success: false, message: 'Some chunks have not been uploaded', missing };
+		}
+
+		const storageCheck = await this.storageService.canUserUpload(input.userId, input.fileSize);
+		if (!storageCheck.canUpload) {
+			throw new Error(
+				`Storage limit exceeded. You would exceed your limit by ${storageCheck.wouldExceedBy} bytes.`,
+			);
+		}
+
+		// The new version is rebuilt from chunks the server already holds
+		const stagingId = `delta-${uuidv4()}`;
+		const stagedPath = this.uploadStagingService.getStagedFilePath(stagingId);
+		try {
+			const written = await this.chunkStore.assemble(input.userId, input.chunks, stagedPath);
+			if (written !== input.fileSize) {
+				throw new Error('Chunk sizes do not add up to the file size');
+			}
+
+			const uploadResult = await this.fileUploadService.uploadFileFromPath(
+				stagedPath,
+				input.fileName,
+				input.mimeType,
+			);
+
+			let thumbnails: string[] = [];
+			if (input.mimeType.startsWith('video/')) {
+				try {
+					thumbnails = await this.thumbnailService.generateThumbnailsFromPath(
+						stagedPath,
+						input.fileName,
+						input.mimeType,
+					);
+				} catch (thumbnailError) {
+					this.loggingService.warn('Failed to generate thumbnails, continuing without them', {
+						fileName: input.fileName,
+						error: thumbnailError instanceof Error ? thumbnailError.message : 'Unknown error',
+					});
+				}
+			}
+
+			const media = await this.mediaRepository.create({
+				title: input.title || input.fileName,
+				description: input.description || '',
+				filename: uploadResult.key.split('/').pop() || input.fileName,
+				originalName: input.fileName,
+				mimeType: input.mimeType,
+				size: input.fileSize,
+				duration: input.duration || 0,
+				url: uploadResult.url,
+				s3Key: uploadResult.key,
+				uploadedBy: input.userId,
+				thumbnails,
+				contentHash: input.contentHash,
+			});
+
+			await this.chunkStore.saveManifest(input.userId, media.id, input.chunks);
+
+			this.loggingService.info('Delta upload committed', {
+				mediaId: media.id,
+				userId: input.userId,
+				fileSize: input.fileSize,
+				chunks: input.chunks.length,
+			});
+
+			return { success: true, message: 'Media uploaded successfully', media };
+		} finally {
+			await this.uploadStagingService.discard(stagingId);
+		}
+	}
+}
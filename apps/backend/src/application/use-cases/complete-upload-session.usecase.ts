@@ -0,0 +1,251 @@
+import { Media } from '../../domain/entities/media.entity';
+import { UploadSession } from '../../domain/entities/upload-session.entity';
+import { IMediaRepository } from '../../domain/repositories/imedia.repository';
+import { IUploadSessionRepository } from '../../domain/repositories/iupload-session.repository';
+import { IDirectUploadService } from '../../domain/services/idirect-upload.service';
+import { IFileUploadService } from '../../domain/services/ifile-upload.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IStorageService } from '../../domain/services/istorage.service';
+import { IThumbnailService } from '../../domain/services/ithumbnail.service';
+import { IUploadStagingService } from '../../domain/services/iupload-staging.service';
+
+export interface CompleteUploadSessionInput {
+	sessionId: string;
+	userId: string;
+	duration?: number;
+}
+
+export interface CompleteUploadSessionResult {
+	success: boolean;
+	message: string;
+	media?: Media;
+	receivedBytes?: number;
+	inProgress?: boolean; // another complete of the session is still running
+}
+
+export class CompleteUploadSessionUseCase {
+	constructor(
+		private readonly uploadSessionRepository: IUploadSessionRepository,
+		private readonly uploadStagingService: IUploadStagingService,
+		private readonly mediaRepository: IMediaRepository,
+		private readonly fileUploadService: IFileUploadService,
+		private readonly thumbnailService: IThumbnailService,
+		private readonly storageService: IStorageService,
+		private readonly loggingService: ILoggingService,
+		private readonly directUploadService?: IDirectUploadService,
+	) {}
+
+	async execute(input: CompleteUploadSessionInput): Promise<CompleteUploadSessionResult> {
+		const session = await this.uploadSessionRepository.findById(input.sessionId);
+
+		if (!session || !session.belongsTo(input.userId)) {
+			return { success: false, message: 'Upload session not found' };
+		}
+
+		// A repeated complete, e.g. after the first response was lost, gets the
+		// media the first one made
+		if (session.status === 'completed' && session.mediaId) {
+			const media = await this.mediaRepository.findById(session.mediaId);
+			if (media) {
+				return { success: true, message: 'Media uploaded successfully', media };
+			}
+		}
+
+		if (session.status === 'completing') {
+			return this.alreadyCompleting();
+		}
+
+		if (!session.isActive()) {
+			return { success: false, message: 'Upload session is no longer active' };
+		}
+
+		if (!session.isDirect() && !session.isFullyReceived()) {
+			return {
+				success: false,
+				message: 'Upload is incomplete',
+				receivedBytes: session.receivedBytes,
+			};
+		}
+
+		// Claimed before anything is copied, so concurrent completes of one
+		// session cannot both store the file and create media for it
+		const claimed = await this.uploadSessionRepository.transitionStatus(
+			session.id,
+			'active',
+			'completing',
+		);
+		if (!claimed) {
+			return this.alreadyCompleting();
+		}
+
+		try {
+			const result = session.isDirect()
+				? await this.completeDirect(session, input)
+				: await this.completeStaged(session, input);
+			if (!result.success) {
+				await this.reopen(session);
+			}
+			return result;
+		} catch (error) {
+			await this.reopen(session);
+			throw error;
+		}
+	}
+
+	private async completeStaged(
+		session: UploadSession,
+		input: CompleteUploadSessionInput,
+	): Promise<CompleteUploadSessionResult> {
+		// Usage may have grown since the session was opened
+		const storageCheck = await this.storageService.canUserUpload(input.userId, session.totalSize);
+		if (!storageCheck.canUpload) {
+			await this.abandon(session);
+			throw new Error(
+				`Storage limit exceeded. You would exceed your limit by ${storageCheck.wouldExceedBy} bytes.`,
+			);
+		}
+
+		const stagedPath = this.uploadStagingService.getStagedFilePath(session.id);
+		const uploadResult = await this.fileUploadService.uploadFileFromPath(
+			stagedPath,
+			session.fileName,
+			session.mimeType,
+		);
+
+		let thumbnails: string[] = [];
+		if (session.mimeType.startsWith('video/')) {
+			try {
+				thumbnails = await this.thumbnailService.generateThumbnailsFromPath(
+					stagedPath,
+					session.fileName,
+					session.mimeType,
+				);
+			} catch (thumbnailError) {
+				this.loggingService.warn('Failed to generate thumbnails, continuing without them', {
+					sessionId: session.id,
+					error: thumbnailError instanceof Error ? thumbnailError.message : 'Unknown error',
+				});
+			}
+		}
+
+		const media = await this.mediaRepository.create({
+			title: session.title || session.fileName,
+			description: session.description,
+			filename: uploadResult.key.split('/').pop() || session.fileName,
+			originalName: session.fileName,
+			mimeType: session.mimeType,
+			size: session.totalSize,
+			duration: input.duration || 0,
+			url: uploadResult.url,
+			s3Key: uploadResult.key,
+			uploadedBy: input.userId,
+			thumbnails,
+			contentHash: session.contentHash || undefined,
+		});
+
+		await this.uploadSessionRepository.markCompleted(session.id, media.id);
+		await this.uploadStagingService.discard(session.id);
+
+		this.loggingService.info('Chunked upload completed', {
+			sessionId: session.id,
+			mediaId: media.id,
+			totalSize: session.totalSize,
+		});
+
+		return { success: true, message: 'Media uploaded successfully', media };
+	}
+
+	private async completeDirect(
+		session: UploadSession,
+		input: CompleteUploadSessionInput,
+	): Promise<CompleteUploadSessionResult> {
+		if (!this.directUploadService) {
+			throw new Error('Direct uploads are not available');
+		}
+
+		// Storage is the only witness of what the client sent; every part must
+		// be there with exactly the length the session laid out
+		const parts = await this.directUploadService.listParts(
+			session.storageKey,
+			session.storageUploadId,
+		);
+		const partCount = session.getPartCount();
+		const receivedBytes = parts.reduce((sum, part) => sum + part.size, 0);
+		const complete =
+			parts.length === partCount &&
+			parts.every(
+				(part, i) => part.partNumber === i + 1 && part.size === session.getPartLength(i + 1),
+			);
+		if (!complete) {
+			return { success: false, message: 'Upload is incomplete', receivedBytes };
+		}
+
+		const storageCheck = await this.storageService.canUserUpload(input.userId, session.totalSize);
+		if (!storageCheck.canUpload) {
+			await this.abandon(session);
+			throw new Error(
+				`Storage limit exceeded. You would exceed your limit by ${storageCheck.wouldExceedBy} bytes.`,
+			);
+		}
+
+		const stored = await this.directUploadService.completeMultipartUpload(
+			session.storageKey,
+			session.storageUploadId,
+			parts,
+		);
+		if (stored.size !== session.totalSize) {
+			await this.fileUploadService.deleteFile(stored.key);
+			await this.uploadSessionRepository.updateStatus(session.id, 'aborted');
+			throw new Error('Stored object does not match the upload session size');
+		}
+
+		// This server never holds the bytes, so there are no server-side thumbnails
+		const media = await this.mediaRepository.create({
+			title: session.title || session.fileName,
+			description: session.description,
+			filename: stored.key.split('/').pop() || session.fileName,
+			originalName: session.fileName,
+			mimeType: session.mimeType,
+			size: session.totalSize,
+			duration: input.duration || 0,
+			url: stored.url,
+			s3Key: stored.key,
+			uploadedBy: input.userId,
+			thumbnails: [],
+			contentHash: session.contentHash || undefined,
+		});
+
+		await this.uploadSessionRepository.markCompleted(session.id, media.id);
+
+		this.loggingService.info('Direct upload completed', {
+			sessionId: session.id,
+			mediaId: media.id,
+			totalSize: session.totalSize,
+			parts: partCount,
+		});
+
+		return { success: true, message: 'Media uploaded successfully', media };
+	}
+
+	private alreadyCompleting(): CompleteUploadSessionResult {
+		return {
+			success: false,
+			message: 'Upload session is already being completed',
+			inProgress: true,
+		};
+	}
+
+	// Open for chunks and completes again; a session aborted meanwhile stays aborted
+	private async reopen(session: UploadSession): Promise<void> {
+		await this.uploadSessionRepository.transitionStatus(session.id, 'completing', 'active');
+	}
+
+	private async abandon(session: UploadSession): Promise<void> {
+		await this.uploadSessionRepository.updateStatus(session.id, 'aborted');
+		if (session.isDirect()) {
+			await this.directUploadService?.abortMultipartUpload(session.storageKey, session.storageUploadId);
+		} else {
+			await this.uploadStagingService.discard(session.id);
+		}
+	}
+}
@@ -0,0 +1,95 @@
+import { UploadSession, UploadSessionMode } from '../../domain/entities/upload-session.entity';
+import { IUploadSessionRepository } from '../../domain/repositories/iupload-session.repository';
+import { IDirectUploadService } from '../../domain/services/idirect-upload.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IStorageService } from '../../domain/services/istorage.service';
+
+export interface CreateUploadSessionInput {
+	userId: string;
+	fileName: string;
+	mimeType: string;
+	totalSize: number;
+	title?: string;
+	description?: string;
+	contentHash?: string;
+	mode?: UploadSessionMode;
+	partSize?: number;
+}
+
+export interface CreateUploadSessionResult {
+	session: UploadSession;
+}
+
+export class CreateUploadSessionUseCase {
+	constructor(
+		private readonly uploadSessionRepository: IUploadSessionRepository,
+		private readonly storageService: IStorageService,
+		private readonly loggingService: ILoggingService,
+		// Without it only staged sessions can be opened
+		private readonly directUploadService?: IDirectUploadService,
+	) {}
+
+	async execute(input: CreateUploadSessionInput): Promise<CreateUploadSessionResult> {
+		if (
+			!input.mimeType.startsWith('video/') &&
+			!input.mimeType.startsWith('audio/') &&
+			!input.mimeType.startsWith('image/')
+		) {
+			throw new Error('Unsupported file type');
+		}
+
+		// Reject before any bytes are sent rather than after the whole file arrives
+		const storageCheck = await this.storageService.canUserUpload(input.userId, input.totalSize);
+		if (!storageCheck.canUpload) {
+			this.loggingService.warn('Upload session rejected due to storage limit', {
+				userId: input.userId,
+				totalSize: input.totalSize,
+				remainingSpace: storageCheck.remainingSpace,
+			});
+			throw new Error(
+				`Storage limit exceeded. You would exceed your limit by ${storageCheck.wouldExceedBy} bytes.`,
+			);
+		}
+
+		const mode = input.mode || 'staged';
+		let direct: { storageKey: string; storageUploadId: string; partSize: number } | undefined;
+		if (mode === 'direct') {
+			if (!this.directUploadService) {
+				throw new Error('Direct uploads are not available');
+			}
+			// The client sends parts to storage itself; this server only keeps the bookkeeping
+			const upload = await this.directUploadService.createMultipartUpload(
+				input.fileName,
+				input.mimeType,
+			);
+			direct = {
+				storageKey: upload.key,
+				storageUploadId: upload.uploadId,
+				partSize: UploadSession.choosePartSize(input.totalSize, input.partSize),
+			};
+		}
+
+		const session = await this.uploadSessionRepository.create({
+			userId: input.userId,
+			fileName: input.fileName,
+			mimeType: input.mimeType,
+			totalSize: input.totalSize,
+			title: input.title || input.fileName,
+			description: input.description || '',
+			contentHash: input.contentHash,
+			mode,
+			...direct,
+			expiresAt: new Date(Date.now() + UploadSession.DEFAULT_TTL_MS),
+		});
+
+		this.loggingService.info('Upload session created', {
+			sessionId: session.id,
+			userId: input.userId,
+			fileName: input.fileName,
+			totalSize: input.totalSize,
+			mode,
+		});
+
+		return { session };
+	}
+}
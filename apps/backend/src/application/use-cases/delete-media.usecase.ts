@@ -1,4 +1,5 @@
 import { IMediaRepository } from '../../domain/repositories/imedia.repository';
+import { IChunkStore } from '../../domain/services/ichunk-store.service';
 import { IFileUploadService } from '../../domain/services/ifile-upload.service';
 import { ILoggingService } from '../../domain/services/ilogging.service';
 
@@ -17,6 +18,7 @@ export class DeleteMediaUseCase {
 		private mediaRepository: IMediaRepository,
 		private fileUploadService: IFileUploadService,
 		private loggingService: ILoggingService,
+		private chunkStore?: IChunkStore,
 	) {}
 
 	async execute(input: DeleteMediaInput): Promise<DeleteMediaResult> {
@@ -70,6 +72,19 @@ export class DeleteMediaUseCase {
 				};
 			}
 
+			// Chunks kept for delta sync of this file; the hourly sweep gets
+			// whatever a failure here leaves behind
+			if (this.chunkStore) {
+				try {
+					await this.chunkStore.releaseManifest(userId, mediaId);
+				} catch (chunkError) {
+					this.loggingService.warn('Failed to release delta chunks of deleted media', {
+						mediaId,
+						error: chunkError instanceof Error ? chunkError.message : 'Unknown error',
+					});
+				}
+			}
+
 			this.loggingService.info('Media deleted successfully', {
 				mediaId,
 				title: media.title,
@@ -0,0 +1,41 @@
+import { Media } from '../../domain/entities/media.entity';
+import { IMediaRepository } from '../../domain/repositories/imedia.repository';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+
+export interface FindDuplicateMediaInput {
+	userId: string;
+	contentHash: string;
+	fileSize: number;
+}
+
+export interface FindDuplicateMediaResult {
+	exists: boolean;
+	media?: Media;
+}
+
+export class FindDuplicateMediaUseCase {
+	constructor(
+		private mediaRepository: IMediaRepository,
+		private loggingService: ILoggingService,
+	) {}
+
+	async execute(input: FindDuplicateMediaInput): Promise<FindDuplicateMediaResult> {
+		const { userId, contentHash, fileSize } = input;
+
+		// Lookups are scoped to the caller's own media: the hash is client supplied,
+		// so a match must never expose or reference another user's object
+		const media = await this.mediaRepository.findByContentHash(userId, contentHash, fileSize);
+
+		if (!media) {
+			return { exists: false };
+		}
+
+		this.loggingService.info('Duplicate media found, upload can be skipped', {
+			mediaId: media.id,
+			userId,
+			fileSize,
+		});
+
+		return { exists: true, media };
+	}
+}
@@ -0,0 +1,34 @@
+import { IChunkStore } from '../../domain/services/ichunk-store.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+
+export interface FindMissingChunksInput {
+	userId: string;
+	hashes: string[];
+}
+
+export interface FindMissingChunksResult {
+	missing: string[];
+}
+
+export class FindMissingChunksUseCase {
+	// Bounds the lookups a single request can ask for
+	static readonly MAX_HASHES_PER_REQUEST = 1000;
+
+	constructor(
+		private readonly chunkStore: IChunkStore,
+		private readonly loggingService: ILoggingService,
+	) {}
+
+	async execute(input: FindMissingChunksInput): Promise<FindMissingChunksResult> {
+		const hashes = [...new Set(input.hashes)];
+		const missing = await this.chunkStore.findMissing(input.userId, hashes);
+
+		this.loggingService.debug('Delta chunks checked', {
+			userId: input.userId,
+			checked: hashes.length,
+			missing: missing.length,
+		});
+
+		return { missing };
+	}
+}
@@ -0,0 +1,46 @@
+import { UploadSession } from '../../domain/entities/upload-session.entity';
+import { IUploadSessionRepository } from '../../domain/repositories/iupload-session.repository';
+import { IDirectUploadService, UploadedPart } from '../../domain/services/idirect-upload.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+
+export interface GetUploadSessionInput {
+	sessionId: string;
+	userId: string;
+}
+
+export interface GetUploadSessionResult {
+	success: boolean;
+	session?: UploadSession;
+	uploadedParts?: UploadedPart[]; // direct sessions: what storage holds so far
+}
+
+export class GetUploadSessionUseCase {
+	constructor(
+		private readonly uploadSessionRepository: IUploadSessionRepository,
+		private readonly loggingService: ILoggingService,
+		private readonly directUploadService?: IDirectUploadService,
+	) {}
+
+	async execute(input: GetUploadSessionInput): Promise<GetUploadSessionResult> {
+		const session = await this.uploadSessionRepository.findById(input.sessionId);
+
+		if (!session || !session.belongsTo(input.userId)) {
+			this.loggingService.info('Upload session not found', {
+				sessionId: input.sessionId,
+				userId: input.userId,
+			});
+			return { success: false };
+		}
+
+		// Parts never pass through here, so only storage knows how far a direct upload got
+		if (session.isDirect() && session.isActive() && this.directUploadService) {
+			const uploadedParts = await this.directUploadService.listParts(
+				session.storageKey,
+				session.storageUploadId,
+			);
+			return { success: true, session, uploadedParts };
+		}
+
+		return { success: true, session };
+	}
+}
@@ -0,0 +1,82 @@
+import { IUploadSessionRepository } from '../../domain/repositories/iupload-session.repository';
+import { IDirectUploadService, PresignedPart } from '../../domain/services/idirect-upload.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+
+export interface PresignUploadPartsInput {
+	sessionId: string;
+	userId: string;
+	partNumbers: number[];
+}
+
+export interface PresignUploadPartsResult {
+	success: boolean;
+	message: string;
+	parts?: PresignedPart[];
+	expiresAt?: Date;
+	notFound?: boolean;
+}
+
+export class PresignUploadPartsUseCase {
+	// Bounds the signing work a single request can ask for
+	static readonly MAX_PARTS_PER_REQUEST = 100;
+	static readonly URL_TTL_SECONDS = 60 * 60;
+
+	constructor(
+		private readonly uploadSessionRepository: IUploadSessionRepository,
+		private readonly directUploadService: IDirectUploadService,
+		private readonly loggingService: ILoggingService,
+	) {}
+
+	async execute(input: PresignUploadPartsInput): Promise<PresignUploadPartsResult> {
+		const session = await this.uploadSessionRepository.findById(input.sessionId);
+
+		if (!session || !session.belongsTo(input.userId)) {
+			return { success: false, message: 'Upload session not found', notFound: true };
+		}
+
+		if (!session.isActive()) {
+			return { success: false, message: 'Upload session is no longer active', notFound: true };
+		}
+
+		if (!session.isDirect()) {
+			return { success: false, message: 'Upload session is not a direct upload' };
+		}
+
+		const partNumbers = [...new Set(input.partNumbers)];
+		if (partNumbers.length === 0 || partNumbers.length > PresignUploadPartsUseCase.MAX_PARTS_PER_REQUEST) {
+			return {
+				success: false,
+				message: `Between 1 and ${PresignUploadPartsUseCase.MAX_PARTS_PER_REQUEST} parts per request`,
+			};
+		}
+
+		const partCount = session.getPartCount();
+		if (partNumbers.some((n) => !Number.isInteger(n) || n < 1 || n > partCount)) {
+			return { success: false, message: `Part numbers must be between 1 and ${partCount}` };
+		}
+
+		// URLs never outlive the session they belong to
+		const sessionLeft = Math.floor((session.expiresAt.getTime() - Date.now()) / 1000);
+		const expiresIn = Math.max(1, Math.min(PresignUploadPartsUseCase.URL_TTL_SECONDS, sessionLeft));
+
+		const parts = await this.directUploadService.presignParts(
+			session.storageKey,
+			session.storageUploadId,
+			partNumbers,
+			expiresIn,
+		);
+
+		this.loggingService.debug('Upload part URLs signed', {
+			sessionId: session.id,
+			parts: partNumbers.length,
+			expiresIn,
+		});
+
+		return {
+			success: true,
+			message: 'Part URLs signed',
+			parts,
+			expiresAt: new Date(Date.now() + expiresIn * 1000),
+		};
+	}
+}
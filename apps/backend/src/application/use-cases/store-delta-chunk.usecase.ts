@@ -0,0 +1,54 @@
+import { Readable } from 'stream';
+import { IChunkStore } from '../../domain/services/ichunk-store.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IStorageService } from '../../domain/services/istorage.service';
+
+export interface StoreDeltaChunkInput {
+	userId: string;
+	hash: string;
+	chunk: Readable;
+}
+
+export interface StoreDeltaChunkResult {
+	size: number;
+}
+
+export class StoreDeltaChunkUseCase {
+	// Clients cut chunks at 4MB; this leaves room for other chunk sizes
+	static readonly MAX_CHUNK_SIZE = 16 * 1024 * 1024;
+	// Chunks no commit has claimed are removed after this long
+	static readonly PENDING_TTL_MS = 24 * 60 * 60 * 1000;
+
+	constructor(
+		private readonly chunkStore: IChunkStore,
+		private readonly storageService: IStorageService,
+		private readonly loggingService: ILoggingService,
+	) {}
+
+	async execute(input: StoreDeltaChunkInput): Promise<StoreDeltaChunkResult> {
+		// Chunks waiting for a commit count against the user's storage, so they
+		// cannot pile up past it; only the chunks in flight can go over
+		const pendingBytes = await this.chunkStore.getPendingBytes(input.userId);
+		const storageCheck = await this.storageService.canUserUpload(input.userId, pendingBytes);
+		if (!storageCheck.canUpload) {
+			throw new Error(
+				`Storage limit exceeded. You would exceed your limit by ${storageCheck.wouldExceedBy} bytes.`,
+			);
+		}
+
+		const size = await this.chunkStore.putChunk(
+			input.userId,
+			input.hash,
+			input.chunk,
+			StoreDeltaChunkUseCase.MAX_CHUNK_SIZE,
+		);
+
+		this.loggingService.debug('Delta chunk stored', {
+			userId: input.userId,
+			hash: input.hash,
+			size,
+		});
+
+		return { size };
+	}
+}
@@ -0,0 +1,179 @@
+import { Media } from '../../domain/entities/media.entity';
+import { CreateMediaData, IMediaRepository } from '../../domain/repositories/imedia.repository';
+import { IFileUploadService } from '../../domain/services/ifile-upload.service';
+import { ILoggingService } from '../../domain/services/ilogging.service';
+import { IStorageService } from '../../domain/services/istorage.service';
+import { IThumbnailService } from '../../domain/services/ithumbnail.service';
+
+export interface BatchFileEntry {
+	name: string;
+	size: number;
+	mimeType: string;
+	title?: string;
+	contentHash?: string;
+	duration?: number;
+}
+
+export interface UploadMediaBatchInput {
+	uploadedBy: string;
+	files: BatchFileEntry[];
+	/** Reads the next file body, in the order of files */
+	readFile: (entry: BatchFileEntry) => Promise<Buffer>;
+}
+
+export interface BatchFileResult {
+	index: number;
+	originalName: string;
+	success: boolean;
+	media?: Media;
+	error?: string;
+}
+
+export interface UploadMediaBatchResult {
+	results: BatchFileResult[];
+}
+
+export class UploadMediaBatchUseCase {
+	static readonly MAX_FILES = 500;
+	static readonly MAX_FILE_SIZE = 16 * 1024 * 1024;
+	static readonly MAX_BATCH_SIZE = 256 * 1024 * 1024;
+	// Storage uploads in flight while the next files are read from the request
+	static readonly UPLOAD_CONCURRENCY = 4;
+
+	constructor(
+		private readonly mediaRepository: IMediaRepository,
+		private readonly fileUploadService: IFileUploadService,
+		private readonly thumbnailService: IThumbnailService,
+		private readonly storageService: IStorageService,
+		private readonly loggingService: ILoggingService,
+	) {}
+
+	async execute(input: UploadMediaBatchInput): Promise<UploadMediaBatchResult> {
+		const totalSize = input.files.reduce((sum, file) => sum + file.size, 0);
+
+		// One quota check for the whole batch rather than one per file
+		const storageCheck = await this.storageService.canUserUpload(input.uploadedBy, totalSize);
+		if (!storageCheck.canUpload) {
+			this.loggingService.warn('Batch upload rejected due to storage limit', {
+				userId: input.uploadedBy,
+				fileCount: input.files.length,
+				totalSize,
+				remainingSpace: storageCheck.remainingSpace,
+			});
+			throw new Error(
+				`Storage limit exceeded. You would exceed your limit by ${storageCheck.wouldExceedBy} bytes.`,
+			);
+		}
+
+		const results: BatchFileResult[] = input.files.map((file, index) => ({
+			index,
+			originalName: file.name,
+			success: false,
+		}));
+		const records: (CreateMediaData | undefined)[] = new Array(input.files.length);
+		const inFlight = new Set<Promise<void>>();
+
+		let media: Media[];
+		try {
+			for (let index = 0; index < input.files.length; index++) {
+				const entry = input.files[index];
+				// Bodies arrive in order, so each file must be read even if an earlier one failed
+				const data = await input.readFile(entry);
+
+				const task = this.storeFile(entry, data, input.uploadedBy)
+					.then((record) => {
+						records[index] = record;
+					})
+					.catch((error) => {
+						results[index].error = error instanceof Error ? error.message : 'Upload failed';
+					})
+					.finally(() => {
+						inFlight.delete(task);
+					});
+				inFlight.add(task);
+
+				if (inFlight.size >= UploadMediaBatchUseCase.UPLOAD_CONCURRENCY) {
+					await Promise.race(inFlight);
+				}
+			}
+			await Promise.all(inFlight);
+
+			// A single database write creates the records for every stored file
+			const stored = records
+				.map((record, index) => ({ record, index }))
+				.filter((item): item is { record: CreateMediaData; index: number } => !!item.record);
+			media = await this.mediaRepository.createMany(stored.map((item) => item.record));
+			media.forEach((created, i) => {
+				const result = results[stored[i].index];
+				result.success = true;
+				result.media = created;
+			});
+		} catch (error) {
+			// The client sends the whole batch again, so nothing stored this time may stay
+			await Promise.all(inFlight);
+			await this.discardStored(records);
+			throw error;
+		}
+
+		this.loggingService.info('Batch upload completed', {
+			userId: input.uploadedBy,
+			fileCount: input.files.length,
+			storedCount: media.length,
+			totalSize,
+		});
+
+		return { results };
+	}
+
+	private async discardStored(records: (CreateMediaData | undefined)[]): Promise<void> {
+		const keys = records
+			.filter((record): record is CreateMediaData => !!record)
+			.map((record) => record.s3Key);
+		const outcomes = await Promise.allSettled(
+			keys.map((key) => this.fileUploadService.deleteFile(key)),
+		);
+		outcomes.forEach((outcome, i) => {
+			if (outcome.status === 'rejected') {
+				this.loggingService.warn('Failed to delete a file of a failed batch', {
+					key: keys[i],
+					error: outcome.reason instanceof Error ? outcome.reason.message : 'Unknown error',
+				});
+			}
+		});
+	}
+
+	private async storeFile(
+		entry: BatchFileEntry,
+		data: Buffer,
+		uploadedBy: string,
+	): Promise<CreateMediaData> {
+		const uploadResult = await this.fileUploadService.uploadFile(data, entry.name, entry.mimeType);
+
+		let thumbnails: string[] = [];
+		if (entry.mimeType.startsWith('video/')) {
+			try {
+				thumbnails = await this.thumbnailService.generateThumbnails(data, entry.name, entry.mimeType);
+			} catch (thumbnailError) {
+				this.loggingService.warn('Failed to generate thumbnails, continuing without them', {
+					originalName: entry.name,
+					error: thumbnailError instanceof Error ? thumbnailError.message : 'Unknown error',
+				});
+			}
+		}
+
+		return {
+			title: entry.title || entry.name,
+			description: '',
+			filename: uploadResult.key.split('/').pop() || entry.name,
+			originalName: entry.name,
+			mimeType: entry.mimeType,
+			size: entry.size,
+			duration: entry.duration || 0,
+			url: uploadResult.url,
+			s3Key: uploadResult.key,
+			uploadedBy,
+			thumbnails,
+			contentHash: entry.contentHash,
+		};
+	}
+}
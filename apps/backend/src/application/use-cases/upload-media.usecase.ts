@@ -15,6 +15,7 @@ export interface UploadMediaInput {
 	duration: number;
 	uploadedBy: string;
 	generateThumbnails?: boolean;
+	contentHash?: string;
 }
 
 export interface UploadMediaResult {
@@ -95,6 +96,7 @@ export class UploadMediaUseCase {
 				s3Key: uploadResult.key,
 				uploadedBy: input.uploadedBy,
 				thumbnails,
+				contentHash: input.contentHash,
 			};
 
 			const media = await this.mediaRepository.create(mediaData);
@@ -14,6 +14,7 @@ export class Media {
 		public readonly thumbnails: string[] = [],
 		public readonly createdAt: Date = new Date(),
 		public readonly updatedAt: Date = new Date(),
+		public readonly contentHash: string = '', // BLAKE2b-256 hex digest supplied by the client
 	) {}
 
 	// Business logic methods
@@ -33,6 +34,7 @@ export class Media {
 			this.thumbnails,
 			this.createdAt,
 			new Date(),
+			this.contentHash,
 		);
 	}
 
@@ -62,6 +64,10 @@ export class Media {
 		return size > 0 && size <= maxSize;
 	}
 
+	static validateContentHash(contentHash: string): boolean {
+		return /^[a-f0-9]{64}$/.test(contentHash);
+	}
+
 	static validateMimeType(mimeType: string): boolean {
 		const allowedTypes = [
 			'video/mp4',
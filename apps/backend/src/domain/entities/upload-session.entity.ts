@@ -0,0 +1,83 @@
+// completing: claimed by one complete request, which is copying the file out
+export type UploadSessionStatus = 'active' | 'completing' | 'completed' | 'aborted';
+
+// staged: chunks are sent to this server and staged on disk
+// direct: parts go straight to object storage through presigned URLs
+export type UploadSessionMode = 'staged' | 'direct';
+
+export class UploadSession {
+	constructor(
+		public readonly id: string,
+		public readonly userId: string,
+		public readonly fileName: string,
+		public readonly mimeType: string,
+		public readonly totalSize: number,
+		public readonly receivedBytes: number = 0,
+		public readonly status: UploadSessionStatus = 'active',
+		public readonly title: string = '',
+		public readonly description: string = '',
+		public readonly expiresAt: Date = new Date(Date.now() + UploadSession.DEFAULT_TTL_MS),
+		public readonly createdAt: Date = new Date(),
+		public readonly updatedAt: Date = new Date(),
+		public readonly contentHash: string = '',
+		public readonly mode: UploadSessionMode = 'staged',
+		public readonly storageKey: string = '',
+		public readonly storageUploadId: string = '',
+		public readonly partSize: number = 0,
+		public readonly mediaId: string = '', // set once completed
+	) {}
+
+	// Sessions are kept for a day so interrupted clients can resume
+	static readonly DEFAULT_TTL_MS = 24 * 60 * 60 * 1000;
+
+	// Object storage multipart limits (S3 and compatible stores)
+	static readonly MIN_PART_SIZE = 5 * 1024 * 1024;
+	static readonly MAX_PART_SIZE = 5 * 1024 * 1024 * 1024;
+	static readonly MAX_PARTS = 10000;
+	static readonly DEFAULT_PART_SIZE = 16 * 1024 * 1024;
+
+	// Business logic methods
+	isActive(): boolean {
+		return this.status === 'active' && new Date() <= this.expiresAt;
+	}
+
+	isFullyReceived(): boolean {
+		return this.receivedBytes >= this.totalSize;
+	}
+
+	getRemainingBytes(): number {
+		return Math.max(0, this.totalSize - this.receivedBytes);
+	}
+
+	belongsTo(userId: string): boolean {
+		return this.userId === userId;
+	}
+
+	isDirect(): boolean {
+		return this.mode === 'direct';
+	}
+
+	getPartCount(): number {
+		return this.partSize > 0 ? Math.max(1, Math.ceil(this.totalSize / this.partSize)) : 0;
+	}
+
+	getPartLength(partNumber: number): number {
+		const start = (partNumber - 1) * this.partSize;
+		return Math.max(0, Math.min(this.partSize, this.totalSize - start));
+	}
+
+	/**
+	 * Part size for a direct upload: the requested size within the storage
+	 * limits, grown as needed so the file fits in MAX_PARTS parts
+	 */
+	static choosePartSize(totalSize: number, requested?: number): number {
+		const wanted = Math.max(requested || UploadSession.DEFAULT_PART_SIZE, UploadSession.MIN_PART_SIZE);
+		const needed = Math.ceil(totalSize / UploadSession.MAX_PARTS);
+		return Math.min(Math.max(wanted, needed), UploadSession.MAX_PART_SIZE);
+	}
+
+	// Validation methods
+	static validateOffset(offset: number, session: UploadSession): boolean {
+		return Number.isInteger(offset) && offset === session.receivedBytes;
+	}
+}
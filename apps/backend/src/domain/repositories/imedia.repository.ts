@@ -1,19 +1,30 @@
 import { Media } from '../entities/media.entity';
 
+export interface CreateMediaData {
+	title: string;
+	description: string;
+	filename: string;
+	originalName: string;
+	mimeType: string;
+	size: number;
+	duration: number;
+	url: string;
+	s3Key: string;
+	uploadedBy: string;
+	thumbnails?: string[];
+	contentHash?: string;
+}
+
 export interface IMediaRepository {
-	create(media: {
-		title: string;
-		description: string;
-		filename: string;
-		originalName: string;
-		mimeType: string;
-		size: number;
-		duration: number;
-		url: string;
-		s3Key: string;
-		uploadedBy: string;
-	}): Promise<Media>;
+	create(media: CreateMediaData): Promise<Media>;
+	/**
+	 * Insert several media records in a single database write
+	 * @param media - Records to insert
+	 * @returns The created media, in input order
+	 */
+	createMany(media: CreateMediaData[]): Promise<Media[]>;
 	findById(id: string): Promise<Media | null>;
+	findByContentHash(userId: string, contentHash: string, size: number): Promise<Media | null>;
 	findByUserId(userId: string): Promise<Media[]>;
 	findByMimeType(mimeType: string): Promise<Media[]>;
 	update(id: string, updates: Partial<Media>): Promise<Media | null>;
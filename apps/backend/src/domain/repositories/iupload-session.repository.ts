@@ -0,0 +1,40 @@
+import {
+	UploadSession,
+	UploadSessionMode,
+	UploadSessionStatus,
+} from '../entities/upload-session.entity';
+
+export interface IUploadSessionRepository {
+	create(session: {
+		userId: string;
+		fileName: string;
+		mimeType: string;
+		totalSize: number;
+		title: string;
+		description: string;
+		contentHash?: string;
+		mode?: UploadSessionMode;
+		storageKey?: string;
+		storageUploadId?: string;
+		partSize?: number;
+		expiresAt: Date;
+	}): Promise<UploadSession>;
+	findById(id: string): Promise<UploadSession | null>;
+	/**
+	 * Advance the acknowledged offset only if it still equals expectedOffset,
+	 * so two concurrent writers can never both acknowledge the same range.
+	 */
+	advanceOffset(id: string, expectedOffset: number, newOffset: number): Promise<UploadSession | null>;
+	/**
+	 * Move the session from one status to another only if it is still in the
+	 * first, so of two concurrent requests exactly one wins the transition.
+	 */
+	transitionStatus(
+		id: string,
+		from: UploadSessionStatus,
+		to: UploadSessionStatus,
+	): Promise<UploadSession | null>;
+	markCompleted(id: string, mediaId: string): Promise<UploadSession | null>;
+	updateStatus(id: string, status: UploadSessionStatus): Promise<UploadSession | null>;
+	delete(id: string): Promise<boolean>;
+}
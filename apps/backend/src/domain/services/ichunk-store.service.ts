@@ -0,0 +1,64 @@
+import { Readable } from 'stream';
+
+export interface ChunkRef {
+	hash: string; // SHA-256 of the chunk bytes, hex encoded
+	size: number;
+}
+
+/**
+ * Content-addressed store of file chunks, kept per user, from which new
+ * versions of a file are rebuilt so clients only send the chunks that changed
+ */
+export interface IChunkStore {
+	/**
+	 * Hashes from the list that the user's store does not hold, in list order
+	 */
+	findMissing(userId: string, hashes: string[]): Promise<string[]>;
+
+	/**
+	 * Store one chunk. Nothing is stored unless the bytes hash to `hash`;
+	 * otherwise it throws 'Chunk content does not match its hash'.
+	 * @param data - Stream of chunk bytes (not buffered in memory)
+	 * @param maxBytes - Upper bound on bytes accepted from the stream
+	 * @returns Size of the stored chunk
+	 */
+	putChunk(userId: string, hash: string, data: Readable, maxBytes: number): Promise<number>;
+
+	/**
+	 * Write the chunks one after another into a new file
+	 * @returns Number of bytes written
+	 */
+	assemble(userId: string, chunks: ChunkRef[], targetPath: string): Promise<number>;
+
+	/**
+	 * Record which chunks make up a stored media file. Its chunks stop being
+	 * pending, since the media file now counts against the user's storage.
+	 */
+	saveManifest(userId: string, mediaId: string, chunks: ChunkRef[]): Promise<void>;
+
+	/**
+	 * Forget a media file's manifest and remove the chunks no other manifest
+	 * of the user lists, e.g. once the media is deleted
+	 * @returns Number of chunks removed
+	 */
+	releaseManifest(userId: string, mediaId: string): Promise<number>;
+
+	/**
+	 * Remove stored chunks that no manifest lists, e.g. left behind when a
+	 * release failed
+	 * @returns Number of chunks removed
+	 */
+	sweepUnreferenced(): Promise<number>;
+
+	/**
+	 * Bytes of the user's chunks that no saved manifest lists yet
+	 */
+	getPendingBytes(userId: string): Promise<number>;
+
+	/**
+	 * Remove pending chunks stored more than maxAgeMs ago, left by syncs that
+	 * never committed
+	 * @returns Number of files removed
+	 */
+	expirePending(maxAgeMs: number): Promise<number>;
+}
@@ -0,0 +1,53 @@
+export interface UploadedPart {
+	partNumber: number;
+	size: number;
+	etag: string;
+}
+
+export interface PresignedPart {
+	partNumber: number;
+	url: string;
+}
+
+/**
+ * Multipart uploads that clients send straight to object storage through
+ * presigned URLs, so file bytes never pass through this server
+ */
+export interface IDirectUploadService {
+	/**
+	 * Open a multipart upload for a new object
+	 * @returns The object key and the storage-side upload ID
+	 */
+	createMultipartUpload(filename: string, mimeType: string): Promise<{ key: string; uploadId: string }>;
+
+	/**
+	 * Sign one PUT URL per part number
+	 * @param expiresIn - Seconds the URLs stay valid
+	 */
+	presignParts(
+		key: string,
+		uploadId: string,
+		partNumbers: number[],
+		expiresIn: number,
+	): Promise<PresignedPart[]>;
+
+	/**
+	 * Parts storage has received so far, in part number order
+	 */
+	listParts(key: string, uploadId: string): Promise<UploadedPart[]>;
+
+	/**
+	 * Assemble the parts into the final object
+	 * @returns Location of the object and its size as stored
+	 */
+	completeMultipartUpload(
+		key: string,
+		uploadId: string,
+		parts: UploadedPart[],
+	): Promise<{ url: string; key: string; bucket: string; size: number }>;
+
+	/**
+	 * Discard the upload and every part received for it
+	 */
+	abortMultipartUpload(key: string, uploadId: string): Promise<void>;
+}
@@ -8,6 +8,15 @@ export interface IFileUploadService {
 		key: string;
 		bucket: string;
 	}>;
+	uploadFileFromPath(
+		filePath: string,
+		filename: string,
+		mimeType: string,
+	): Promise<{
+		url: string;
+		key: string;
+		bucket: string;
+	}>;
 	deleteFile(key: string): Promise<boolean>;
 	getSignedUrl(key: string, expiresIn?: number): Promise<string>;
 }
@@ -1,3 +1,9 @@
 export interface IThumbnailService {
 	generateThumbnails(videoBuffer: Buffer, filename: string, mimeType: string): Promise<string[]>;
+	generateThumbnailsFromPath(videoPath: string, filename: string, mimeType: string): Promise<string[]>;
+	/**
+	 * Store thumbnails that were made elsewhere (JPEG), without decoding them
+	 * @returns URLs of the stored thumbnails, in input order
+	 */
+	storeThumbnails(thumbnails: Buffer[], filename: string): Promise<string[]>;
 }
@@ -0,0 +1,25 @@
+import { Readable } from 'stream';
+
+export interface IUploadStagingService {
+	/**
+	 * Write a chunk of an upload session at the given byte offset
+	 * @param sessionId - The upload session ID
+	 * @param offset - Byte offset of the chunk within the file
+	 * @param chunk - Stream of chunk bytes (not buffered in memory)
+	 * @param maxBytes - Upper bound on bytes accepted from the stream
+	 * @returns Number of bytes written
+	 */
+	writeChunk(sessionId: string, offset: number, chunk: Readable, maxBytes: number): Promise<number>;
+
+	/**
+	 * Get the local path of the staged file for a session
+	 * @param sessionId - The upload session ID
+	 */
+	getStagedFilePath(sessionId: string): string;
+
+	/**
+	 * Remove all staged data for a session
+	 * @param sessionId - The upload session ID
+	 */
+	discard(sessionId: string): Promise<void>;
+}
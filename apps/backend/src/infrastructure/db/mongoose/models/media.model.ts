@@ -12,6 +12,7 @@ export interface IMediaDocument extends Document {
 	s3Key: string;
 	uploadedBy: string;
 	thumbnails: string[];
+	contentHash?: string;
 	createdAt: Date;
 	updatedAt: Date;
 }
@@ -68,6 +69,10 @@ const mediaSchema = new Schema<IMediaDocument>(
 			type: [String],
 			required: false,
 		},
+		contentHash: {
+			type: String,
+			required: false,
+		},
 	},
 	{
 		timestamps: true,
@@ -79,5 +84,6 @@ mediaSchema.index({ title: 'text', description: 'text' }); // Text search
 mediaSchema.index({ mimeType: 1 });
 mediaSchema.index({ createdAt: -1 });
 mediaSchema.index({ size: 1 });
+mediaSchema.index({ uploadedBy: 1, contentHash: 1 }, { sparse: true }); // Per-user dedupe lookups
 
 export const MediaModel = mongoose.model<IMediaDocument>('Media', mediaSchema);
@@ -0,0 +1,105 @@
+import mongoose, { Document, Schema } from 'mongoose';
+
+export interface IUploadSessionDocument extends Document {
+	userId: string;
+	fileName: string;
+	mimeType: string;
+	totalSize: number;
+	receivedBytes: number;
+	status: 'active' | 'completing' | 'completed' | 'aborted';
+	title: string;
+	description: string;
+	contentHash?: string;
+	mode: 'staged' | 'direct';
+	storageKey?: string;
+	storageUploadId?: string;
+	partSize?: number;
+	mediaId?: string;
+	expiresAt: Date;
+	createdAt: Date;
+	updatedAt: Date;
+}
+
+const uploadSessionSchema = new Schema<IUploadSessionDocument>(
+	{
+		userId: {
+			type: String,
+			required: true,
+			index: true,
+		},
+		fileName: {
+			type: String,
+			required: true,
+		},
+		mimeType: {
+			type: String,
+			required: true,
+		},
+		totalSize: {
+			type: Number,
+			required: true,
+			min: 0,
+		},
+		receivedBytes: {
+			type: Number,
+			default: 0,
+			min: 0,
+		},
+		status: {
+			type: String,
+			enum: ['active', 'completing', 'completed', 'aborted'],
+			default: 'active',
+		},
+		title: {
+			type: String,
+			required: false,
+			maxlength: 100,
+		},
+		description: {
+			type: String,
+			required: false,
+			maxlength: 500,
+		},
+		contentHash: {
+			type: String,
+			required: false,
+		},
+		mode: {
+			type: String,
+			enum: ['staged', 'direct'],
+			default: 'staged',
+		},
+		storageKey: {
+			type: String,
+			required: false,
+		},
+		storageUploadId: {
+			type: String,
+			required: false,
+		},
+		partSize: {
+			type: Number,
+			required: false,
+			min: 0,
+		},
+		mediaId: {
+			type: String,
+			required: false,
+		},
+		expiresAt: {
+			type: Date,
+			required: true,
+		},
+	},
+	{
+		timestamps: true,
+	},
+);
+
+// TTL index: abandoned sessions are removed by MongoDB
+uploadSessionSchema.index({ expiresAt: 1 }, { expireAfterSeconds: 0 });
+
+export const UploadSessionModel = mongoose.model<IUploadSessionDocument>(
+	'UploadSession',
+	uploadSessionSchema,
+);
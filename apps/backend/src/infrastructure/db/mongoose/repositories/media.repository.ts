@@ -21,6 +21,37 @@ export class MediaRepository implements IMediaRepository {
 			media.thumbnails || [],
 			media.createdAt,
 			media.updatedAt,
+			media.contentHash || '',
+		);
+	}
+
+	async createMany(mediaData: Omit<Media, 'id' | 'createdAt' | 'updatedAt'>[]): Promise<Media[]> {
+		if (mediaData.length === 0) {
+			return [];
+		}
+
+		// One round trip for the whole batch instead of one per file
+		const media = await MediaModel.insertMany(mediaData);
+
+		return media.map(
+			(m) =>
+				new Media(
+					(m._id as any).toString(),
+					m.title,
+					m.description,
+					m.filename,
+					m.originalName,
+					m.mimeType,
+					m.size,
+					m.duration,
+					m.url,
+					m.s3Key,
+					m.uploadedBy,
+					m.thumbnails || [],
+					m.createdAt,
+					m.updatedAt,
+					m.contentHash || '',
+				),
 		);
 	}
 
@@ -43,6 +74,7 @@ export class MediaRepository implements IMediaRepository {
 			media.thumbnails || [],
 			media.createdAt,
 			media.updatedAt,
+			media.contentHash || '',
 		);
 	}
 
@@ -66,6 +98,7 @@ export class MediaRepository implements IMediaRepository {
 					m.thumbnails || [],
 					m.createdAt,
 					m.updatedAt,
+					m.contentHash || '',
 				),
 		);
 	}
@@ -90,10 +123,34 @@ export class MediaRepository implements IMediaRepository {
 					m.thumbnails || [],
 					m.createdAt,
 					m.updatedAt,
+					m.contentHash || '',
 				),
 		);
 	}
 
+	async findByContentHash(userId: string, contentHash: string, size: number): Promise<Media | null> {
+		const media = await MediaModel.findOne({ uploadedBy: userId, contentHash, size }).exec();
+		if (!media) return null;
+
+		return new Media(
+			(media._id as any).toString(),
+			media.title,
+			media.description,
+			media.filename,
+			media.originalName,
+			media.mimeType,
+			media.size,
+			media.duration,
+			media.url,
+			media.s3Key,
+			media.uploadedBy,
+			media.thumbnails || [],
+			media.createdAt,
+			media.updatedAt,
+			media.contentHash || '',
+		);
+	}
+
 	async update(id: string, updates: Partial<Media>): Promise<Media | null> {
 		const media = await MediaModel.findByIdAndUpdate(
 			id,
@@ -118,6 +175,7 @@ export class MediaRepository implements IMediaRepository {
 			media.thumbnails || [],
 			media.createdAt,
 			media.updatedAt,
+			media.contentHash || '',
 		);
 	}
 
@@ -151,6 +209,7 @@ export class MediaRepository implements IMediaRepository {
 					m.thumbnails || [],
 					m.createdAt,
 					m.updatedAt,
+					m.contentHash || '',
 				),
 		);
 	}
@@ -0,0 +1,112 @@
+import {
+	UploadSession,
+	UploadSessionMode,
+	UploadSessionStatus,
+} from '../../../../domain/entities/upload-session.entity';
+import { IUploadSessionRepository } from '../../../../domain/repositories/iupload-session.repository';
+import { IUploadSessionDocument, UploadSessionModel } from '../models/upload-session.model';
+
+export class UploadSessionRepository implements IUploadSessionRepository {
+	async create(sessionData: {
+		userId: string;
+		fileName: string;
+		mimeType: string;
+		totalSize: number;
+		title: string;
+		description: string;
+		contentHash?: string;
+		mode?: UploadSessionMode;
+		storageKey?: string;
+		storageUploadId?: string;
+		partSize?: number;
+		expiresAt: Date;
+	}): Promise<UploadSession> {
+		const session = await UploadSessionModel.create(sessionData);
+		return this.toEntity(session);
+	}
+
+	async findById(id: string): Promise<UploadSession | null> {
+		const session = await UploadSessionModel.findById(id).exec();
+		if (!session) return null;
+
+		return this.toEntity(session);
+	}
+
+	async advanceOffset(
+		id: string,
+		expectedOffset: number,
+		newOffset: number,
+	): Promise<UploadSession | null> {
+		const session = await UploadSessionModel.findOneAndUpdate(
+			{ _id: id, status: 'active', receivedBytes: expectedOffset },
+			{ receivedBytes: newOffset },
+			{ new: true },
+		).exec();
+
+		if (!session) return null;
+
+		return this.toEntity(session);
+	}
+
+	async transitionStatus(
+		id: string,
+		from: UploadSessionStatus,
+		to: UploadSessionStatus,
+	): Promise<UploadSession | null> {
+		const session = await UploadSessionModel.findOneAndUpdate(
+			{ _id: id, status: from },
+			{ status: to },
+			{ new: true },
+		).exec();
+
+		if (!session) return null;
+
+		return this.toEntity(session);
+	}
+
+	async markCompleted(id: string, mediaId: string): Promise<UploadSession | null> {
+		const session = await UploadSessionModel.findByIdAndUpdate(
+			id,
+			{ status: 'completed', mediaId },
+			{ new: true },
+		).exec();
+		if (!session) return null;
+
+		return this.toEntity(session);
+	}
+
+	async updateStatus(id: string, status: UploadSessionStatus): Promise<UploadSession | null> {
+		const session = await UploadSessionModel.findByIdAndUpdate(id, { status }, { new: true }).exec();
+		if (!session) return null;
+
+		return this.toEntity(session);
+	}
+
+	async delete(id: string): Promise<boolean> {
+		const result = await UploadSessionModel.findByIdAndDelete(id).exec();
+		return !!result;
+	}
+
+	private toEntity(session: IUploadSessionDocument): UploadSession {
+		return new UploadSession(
+			(session._id as any).toString(),
+			session.userId,
+			session.fileName,
+			session.mimeType,
+			session.totalSize,
+			session.receivedBytes,
+			session.status,
+			session.title || '',
+			session.description || '',
+			session.expiresAt,
+			session.createdAt,
+			session.updatedAt,
+			session.contentHash || '',
+			session.mode || 'staged',
+			session.storageKey || '',
+			session.storageUploadId || '',
+			session.partSize || 0,
+			session.mediaId || '',
+		);
+	}
+}
@@ -0,0 +1,277 @@
+import { createHash, randomBytes } from 'crypto';
+import { createReadStream, createWriteStream, promises as fs } from 'fs';
+import { join } from 'path';
+import { Readable, Transform } from 'stream';
+import { pipeline } from 'stream/promises';
+import { ChunkRef, IChunkStore } from '../../domain/services/ichunk-store.service';
+
+const HASH_PATTERN = /^[a-f0-9]{64}$/;
+const ID_PATTERN = /^[A-Za-z0-9_-]+$/;
+const SHARD_PATTERN = /^[a-f0-9]{2}$/;
+
+// Chunks on local disk, one file per chunk named by its hash. A new chunk
+// waits in <root>/<userId>/pending/<hash> until a saved manifest lists it,
+// then moves to <root>/<userId>/<first two hash digits>/<hash>, where it
+// stays while any manifest in <root>/<userId>/manifests lists it.
+export class LocalChunkStore implements IChunkStore {
+	// Pending bytes per user, counted from disk once and kept up to date after
+	private readonly pendingBytes = new Map<string, number>();
+
+	constructor(private readonly rootDir: string) {}
+
+	async findMissing(userId: string, hashes: string[]): Promise<string[]> {
+		const present = await Promise.all(hashes.map((hash) => this.locate(userId, hash)));
+		return hashes.filter((_hash, i) => !present[i]);
+	}
+
+	async putChunk(userId: string, hash: string, data: Readable, maxBytes: number): Promise<number> {
+		// A chunk a manifest already lists is replaced where it is; any other
+		// waits for a commit
+		const committed = this.chunkPath(userId, hash);
+		const isCommitted = await this.exists(committed);
+		const target = isCommitted ? committed : this.pendingPath(userId, hash);
+		await fs.mkdir(join(target, '..'), { recursive: true });
+		await this.getPendingBytes(userId); // counted before this chunk lands, not after
+
+		let size = 0;
+		const digest = createHash('sha256');
+		const hasher = new Transform({
+			transform(block: Buffer, _encoding, callback) {
+				size += block.length;
+				if (size > maxBytes) {
+					callback(new Error('Chunk exceeds the maximum chunk size'));
+					return;
+				}
+				digest.update(block);
+				callback(null, block);
+			},
+		});
+
+		// Written aside and renamed into place, so a chunk file is always whole
+		const temp = `${target}.${randomBytes(6).toString('hex')}.tmp`;
+		try {
+			await pipeline(data, hasher, createWriteStream(temp));
+			if (digest.digest('hex') !== hash) {
+				throw new Error('Chunk content does not match its hash');
+			}
+			const replaced = isCommitted ? null : await fs.stat(target).catch(() => null);
+			await fs.rename(temp, target);
+			if (!isCommitted) {
+				this.addPending(userId, size - (replaced?.size || 0));
+			}
+		} catch (error) {
+			await fs.rm(temp, { force: true });
+			throw error;
+		}
+		return size;
+	}
+
+	async assemble(userId: string, chunks: ChunkRef[], targetPath: string): Promise<number> {
+		const sources = await Promise.all(
+			chunks.map(async (chunk) => ({ ...chunk, path: await this.locate(userId, chunk.hash) })),
+		);
+		for (const source of sources) {
+			const stats = source.path ? await fs.stat(source.path).catch(() => null) : null;
+			if (!stats || stats.size !== source.size) {
+				throw new Error(`Chunk ${source.hash} is missing or damaged`);
+			}
+		}
+
+		let written = 0;
+		async function* concatenate() {
+			for (const source of sources) {
+				for await (const block of createReadStream(source.path!)) {
+					written += (block as Buffer).length;
+					yield block as Buffer;
+				}
+			}
+		}
+		await pipeline(Readable.from(concatenate()), createWriteStream(targetPath));
+		return written;
+	}
+
+	async saveManifest(userId: string, mediaId: string, chunks: ChunkRef[]): Promise<void> {
+		const path = this.manifestPath(userId, mediaId);
+		await fs.mkdir(join(path, '..'), { recursive: true });
+		await fs.writeFile(path, JSON.stringify({ chunks }));
+
+		// The media file's size is on the user's storage from now on
+		for (const hash of new Set(chunks.map((chunk) => chunk.hash))) {
+			const pending = this.pendingPath(userId, hash);
+			const stats = await fs.stat(pending).catch(() => null);
+			if (!stats) {
+				continue;
+			}
+			const committed = this.chunkPath(userId, hash);
+			await fs.mkdir(join(committed, '..'), { recursive: true });
+			await fs.rename(pending, committed);
+			this.addPending(userId, -stats.size);
+		}
+	}
+
+	async releaseManifest(userId: string, mediaId: string): Promise<number> {
+		const path = this.manifestPath(userId, mediaId);
+		const chunks = await this.readManifest(path);
+		if (!chunks) {
+			return 0;
+		}
+		await fs.rm(path, { force: true });
+
+		// Other versions of the file, or other files, may share chunks with it
+		const referenced = await this.referencedHashes(userId);
+		let removed = 0;
+		for (const hash of new Set(chunks.map((chunk) => chunk.hash))) {
+			if (!referenced.has(hash)) {
+				await fs.rm(this.chunkPath(userId, hash), { force: true });
+				removed++;
+			}
+		}
+		return removed;
+	}
+
+	async sweepUnreferenced(): Promise<number> {
+		// A chunk moved in by a commit while the manifests were read is newer
+		// than this and kept for the next sweep
+		const startedAt = Date.now();
+		const users = await fs.readdir(this.rootDir).catch(() => [] as string[]);
+		let removed = 0;
+		for (const userId of users.filter((name) => ID_PATTERN.test(name))) {
+			const referenced = await this.referencedHashes(userId);
+			const shards = await fs.readdir(this.userDir(userId)).catch(() => [] as string[]);
+			for (const shard of shards.filter((name) => SHARD_PATTERN.test(name))) {
+				const dir = join(this.userDir(userId), shard);
+				for (const name of await fs.readdir(dir).catch(() => [] as string[])) {
+					if (!HASH_PATTERN.test(name) || referenced.has(name)) {
+						continue;
+					}
+					const stats = await fs.stat(join(dir, name)).catch(() => null);
+					if (stats && stats.ctimeMs < startedAt) {
+						await fs.rm(join(dir, name), { force: true });
+						removed++;
+					}
+				}
+			}
+		}
+		return removed;
+	}
+
+	async getPendingBytes(userId: string): Promise<number> {
+		const cached = this.pendingBytes.get(userId);
+		if (cached !== undefined) {
+			return cached;
+		}
+
+		const dir = this.pendingDir(userId);
+		const names = await fs.readdir(dir).catch(() => [] as string[]);
+		const sizes = await Promise.all(
+			names
+				.filter((name) => HASH_PATTERN.test(name))
+				.map(async (name) => (await fs.stat(join(dir, name)).catch(() => null))?.size || 0),
+		);
+		const total = sizes.reduce((sum, size) => sum + size, 0);
+		this.pendingBytes.set(userId, total);
+		return total;
+	}
+
+	async expirePending(maxAgeMs: number): Promise<number> {
+		const cutoff = Date.now() - maxAgeMs;
+		const users = await fs.readdir(this.rootDir).catch(() => [] as string[]);
+		let removed = 0;
+		for (const userId of users.filter((name) => ID_PATTERN.test(name))) {
+			const dir = this.pendingDir(userId);
+			const names = await fs.readdir(dir).catch(() => [] as string[]);
+			for (const name of names) {
+				// Temp files of writes that never finished go the same way
+				const stats = await fs.stat(join(dir, name)).catch(() => null);
+				if (stats && stats.mtimeMs <= cutoff) {
+					await fs.rm(join(dir, name), { force: true });
+					removed++;
+				}
+			}
+			this.pendingBytes.delete(userId); // counted again on next use
+		}
+		return removed;
+	}
+
+	private async referencedHashes(userId: string): Promise<Set<string>> {
+		const dir = join(this.userDir(userId), 'manifests');
+		const names = await fs.readdir(dir).catch(() => [] as string[]);
+		const referenced = new Set<string>();
+		for (const name of names.filter((entry) => entry.endsWith('.json'))) {
+			for (const chunk of (await this.readManifest(join(dir, name))) || []) {
+				referenced.add(chunk.hash);
+			}
+		}
+		return referenced;
+	}
+
+	private async readManifest(path: string): Promise<ChunkRef[] | null> {
+		try {
+			return (JSON.parse(await fs.readFile(path, 'utf8')) as { chunks: ChunkRef[] }).chunks;
+		} catch (error) {
+			if ((error as NodeJS.ErrnoException).code === 'ENOENT') {
+				return null;
+			}
+			throw error;
+		}
+	}
+
+	private addPending(userId: string, delta: number): void {
+		const current = this.pendingBytes.get(userId);
+		if (current !== undefined) {
+			this.pendingBytes.set(userId, Math.max(0, current + delta));
+		}
+	}
+
+	private async locate(userId: string, hash: string): Promise<string | null> {
+		for (const path of [this.chunkPath(userId, hash), this.pendingPath(userId, hash)]) {
+			if (await this.exists(path)) {
+				return path;
+			}
+		}
+		return null;
+	}
+
+	private async exists(path: string): Promise<boolean> {
+		try {
+			await fs.access(path);
+			return true;
+		} catch {
+			return false;
+		}
+	}
+
+	private chunkPath(userId: string, hash: string): string {
+		return join(this.userDir(userId), this.checkHash(hash).slice(0, 2), hash);
+	}
+
+	private pendingPath(userId: string, hash: string): string {
+		return join(this.pendingDir(userId), this.checkHash(hash));
+	}
+
+	private manifestPath(userId: string, mediaId: string): string {
+		return join(this.userDir(userId), 'manifests', `${this.checkId(mediaId)}.json`);
+	}
+
+	private pendingDir(userId: string): string {
+		return join(this.userDir(userId), 'pending');
+	}
+
+	private userDir(userId: string): string {
+		return join(this.rootDir, this.checkId(userId));
+	}
+
+	private checkHash(hash: string): string {
+		if (!HASH_PATTERN.test(hash)) {
+			throw new Error('Invalid chunk hash');
+		}
+		return hash;
+	}
+
+	private checkId(id: string): string {
+		if (!ID_PATTERN.test(id)) {
+			throw new Error('Invalid ID');
+		}
+		return id;
+	}
+}
@@ -1,19 +1,49 @@
 import AWS from 'aws-sdk';
+import { createReadStream } from 'fs';
+import {
+	IDirectUploadService,
+	PresignedPart,
+	UploadedPart,
+} from '../../domain/services/idirect-upload.service';
 import { IFileUploadService } from '../../domain/services/ifile-upload.service';
 
-export class S3UploadService implements IFileUploadService {
+export class S3UploadService implements IFileUploadService, IDirectUploadService {
 	private s3: AWS.S3;
+	// Signs URLs for clients, which may reach storage under another host than this server
+	private presigner: AWS.S3;
 	private bucket: string;
+	private endpoint?: string;
 
 	constructor() {
 		this.bucket = process.env.S3_BUCKET || 'shared-media-streaming';
-		this.s3 = new AWS.S3({
+		// S3_ENDPOINT points at an S3-compatible store such as MinIO instead of AWS
+		this.endpoint = process.env.S3_ENDPOINT || undefined;
+		this.s3 = this.createClient(this.endpoint);
+		const publicEndpoint = process.env.S3_PUBLIC_ENDPOINT || undefined;
+		this.presigner =
+			publicEndpoint && publicEndpoint !== this.endpoint
+				? this.createClient(publicEndpoint)
+				: this.s3;
+	}
+
+	private createClient(endpoint?: string): AWS.S3 {
+		return new AWS.S3({
 			accessKeyId: process.env.S3_USER_KEY,
 			secretAccessKey: process.env.S3_SECRET,
 			region: process.env.S3_REGION || 'us-east-1',
+			// Compatible stores address buckets by path rather than by host name
+			...(endpoint ? { endpoint, s3ForcePathStyle: true } : {}),
+			signatureVersion: 'v4',
 		});
 	}
 
+	private objectUrl(key: string): string {
+		if (this.endpoint) {
+			return `${this.endpoint.replace(/\/+$/, '')}/${this.bucket}/${key}`;
+		}
+		return `https://${this.bucket}.s3.${process.env.S3_REGION || 'us-east-1'}.amazonaws.com/${key}`;
+	}
+
 	async uploadFile(
 		file: Buffer,
 		filename: string,
@@ -35,10 +65,36 @@ export class S3UploadService implements IFileUploadService {
 
 		await this.s3.upload(uploadParams).promise();
 
-		const url = `https://${this.bucket}.s3.${process.env.S3_REGION || 'us-east-1'}.amazonaws.com/${key}`;
+		return {
+			url: this.objectUrl(key),
+			key,
+			bucket: this.bucket,
+		};
+	}
+
+	async uploadFileFromPath(
+		filePath: string,
+		filename: string,
+		mimeType: string,
+	): Promise<{
+		url: string;
+		key: string;
+		bucket: string;
+	}> {
+		const key = `uploads/media/${Date.now()}-${filename}`;
+
+		// Stream from disk; the SDK splits large bodies into multipart parts
+		const uploadParams: AWS.S3.PutObjectRequest = {
+			Bucket: this.bucket,
+			Key: key,
+			Body: createReadStream(filePath),
+			ContentType: mimeType,
+		};
+
+		await this.s3.upload(uploadParams).promise();
 
 		return {
-			url,
+			url: this.objectUrl(key),
 			key,
 			bucket: this.bucket,
 		};
@@ -82,9 +138,7 @@ export class S3UploadService implements IFileUploadService {
 
 		await this.s3.upload(uploadParams).promise();
 
-		const url = `https://${this.bucket}.s3.${process.env.S3_REGION || 'us-east-1'}.amazonaws.com/${key}`;
-
-		return url;
+		return this.objectUrl(key);
 	}
 
 	async deleteThumbnail(thumbnailUrl: string): Promise<boolean> {
@@ -105,4 +159,113 @@ export class S3UploadService implements IFileUploadService {
 			return false;
 		}
 	}
+
+	async createMultipartUpload(
+		filename: string,
+		mimeType: string,
+	): Promise<{ key: string; uploadId: string }> {
+		const key = `uploads/media/${Date.now()}-${filename}`;
+
+		const result = await this.s3
+			.createMultipartUpload({
+				Bucket: this.bucket,
+				Key: key,
+				ContentType: mimeType,
+			})
+			.promise();
+
+		if (!result.UploadId) {
+			throw new Error('Storage did not return a multipart upload ID');
+		}
+		return { key, uploadId: result.UploadId };
+	}
+
+	async presignParts(
+		key: string,
+		uploadId: string,
+		partNumbers: number[],
+		expiresIn: number,
+	): Promise<PresignedPart[]> {
+		return Promise.all(
+			partNumbers.map(async (partNumber) => ({
+				partNumber,
+				url: await this.presigner.getSignedUrlPromise('uploadPart', {
+					Bucket: this.bucket,
+					Key: key,
+					UploadId: uploadId,
+					PartNumber: partNumber,
+					Expires: expiresIn,
+				}),
+			})),
+		);
+	}
+
+	async listParts(key: string, uploadId: string): Promise<UploadedPart[]> {
+		const parts: UploadedPart[] = [];
+		let marker: number | undefined;
+
+		// At most 1000 parts per page
+		for (;;) {
+			const page = await this.s3
+				.listParts({
+					Bucket: this.bucket,
+					Key: key,
+					UploadId: uploadId,
+					PartNumberMarker: marker,
+				})
+				.promise();
+
+			for (const part of page.Parts || []) {
+				parts.push({
+					partNumber: part.PartNumber || 0,
+					size: part.Size || 0,
+					etag: part.ETag || '',
+				});
+			}
+
+			if (!page.IsTruncated || page.NextPartNumberMarker === undefined) {
+				break;
+			}
+			marker = page.NextPartNumberMarker;
+		}
+
+		return parts.sort((a, b) => a.partNumber - b.partNumber);
+	}
+
+	async completeMultipartUpload(
+		key: string,
+		uploadId: string,
+		parts: UploadedPart[],
+	): Promise<{ url: string; key: string; bucket: string; size: number }> {
+		await this.s3
+			.completeMultipartUpload({
+				Bucket: this.bucket,
+				Key: key,
+				UploadId: uploadId,
+				MultipartUpload: {
+					Parts: parts.map((part) => ({ PartNumber: part.partNumber, ETag: part.etag })),
+				},
+			})
+			.promise();
+
+		// Size as stored, not as the client announced it
+		const head = await this.s3.headObject({ Bucket: this.bucket, Key: key }).promise();
+
+		return {
+			url: this.objectUrl(key),
+			key,
+			bucket: this.bucket,
+			size: head.ContentLength || 0,
+		};
+	}
+
+	async abortMultipartUpload(key: string, uploadId: string): Promise<void> {
+		await this.s3
+			.abortMultipartUpload({
+				Bucket: this.bucket,
+				Key: key,
+				UploadId: uploadId,
+			})
+			.promise();
+	}
 }
@@ -22,12 +22,6 @@ export class ThumbnailService implements IThumbnailService {
 			// Create temporary file paths
 			const tempDir = tmpdir();
 			const videoPath = join(tempDir, `temp_${Date.now()}_${filename}`);
-			const thumbnailDir = join(tempDir, `thumbnails_${Date.now()}`);
-
-			// Create thumbnail directory if it doesn't exist
-			if (!existsSync(thumbnailDir)) {
-				mkdirSync(thumbnailDir, { recursive: true });
-			}
 
 			// Write video buffer to temp file
 			writeFileSync(videoPath, videoBuffer);
@@ -37,7 +31,7 @@ export class ThumbnailService implements IThumbnailService {
 			console.log(`Video file size: ${videoBuffer.length} bytes`);
 
 			// Generate thumbnails at different timestamps
-			const thumbnails = await this.generateThumbnailsWithFFmpeg(videoPath, thumbnailDir, filename);
+			const thumbnails = await this.generateThumbnailsFromPath(videoPath, filename, mimeType);
 
 			// Clean up temp files
 			try {
@@ -53,6 +47,40 @@ export class ThumbnailService implements IThumbnailService {
 		}
 	}
 
+	async generateThumbnailsFromPath(
+		videoPath: string,
+		filename: string,
+		mimeType: string,
+	): Promise<string[]> {
+		// Only generate thumbnails for video files
+		if (!mimeType.startsWith('video/')) {
+			return [];
+		}
+
+		try {
+			const thumbnailDir = join(tmpdir(), `thumbnails_${Date.now()}`);
+
+			// Create thumbnail directory if it doesn't exist
+			if (!existsSync(thumbnailDir)) {
+				mkdirSync(thumbnailDir, { recursive: true });
+			}
+
+			// The video is read straight from disk, no in-memory copy is needed
+			return await this.generateThumbnailsWithFFmpeg(videoPath, thumbnailDir, filename);
+		} catch (error) {
+			console.error('Failed to generate thumbnails:', error);
+			return [];
+		}
+	}
+
+	async storeThumbnails(thumbnails: Buffer[], filename: string): Promise<string[]> {
+		return Promise.all(
+			thumbnails.map((thumbnail, i) =>
+				this.s3UploadService.uploadThumbnail(thumbnail, `thumb_${i}_${filename}.jpg`),
+			),
+		);
+	}
+
 	private async generateThumbnailsWithFFmpeg(
 		videoPath: string,
 		thumbnailDir: string,
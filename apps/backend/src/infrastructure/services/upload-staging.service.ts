@@ -0,0 +1,62 @@
+import { createWriteStream, promises as fs } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import { Readable, Transform } from 'stream';
+import { pipeline } from 'stream/promises';
+import { IUploadStagingService } from '../../domain/services/iupload-staging.service';
+
+export class UploadStagingService implements IUploadStagingService {
+	private readonly stagingDir: string;
+
+	constructor(stagingDir?: string) {
+		this.stagingDir =
+			stagingDir || process.env.UPLOAD_STAGING_DIR || join(tmpdir(), 'upload-staging');
+	}
+
+	async writeChunk(
+		sessionId: string,
+		offset: number,
+		chunk: Readable,
+		maxBytes: number,
+	): Promise<number> {
+		await fs.mkdir(this.stagingDir, { recursive: true });
+
+		let written = 0;
+		const limiter = new Transform({
+			transform(data: Buffer, _encoding, callback) {
+				written += data.length;
+				if (written > maxBytes) {
+					callback(new Error('Chunk exceeds remaining upload size'));
+					return;
+				}
+				callback(null, data);
+			},
+		});
+
+		// Positional write: the first chunk creates the file, later chunks patch it in place
+		const target = createWriteStream(this.getStagedFilePath(sessionId), {
+			flags: offset === 0 ? 'w' : 'r+',
+			start: offset,
+		});
+
+		await pipeline(chunk, limiter, target);
+		return written;
+	}
+
+	getStagedFilePath(sessionId: string): string {
+		if (!/^[A-Za-z0-9_-]+$/.test(sessionId)) {
+			throw new Error('Invalid upload session ID');
+		}
+		return join(this.stagingDir, `${sessionId}.part`);
+	}
+
+	async discard(sessionId: string): Promise<void> {
+		try {
+			await fs.unlink(this.getStagedFilePath(sessionId));
+		} catch (error) {
+			if ((error as NodeJS.ErrnoException).code !== 'ENOENT') {
+				throw error;
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+import { Readable, Transform } from 'stream';
+import { createGunzip, createInflate } from 'zlib';
+
+// Content codings accepted on streamed request bodies. Offsets and sizes in
+// the upload protocol always refer to the decoded bytes.
+export const SUPPORTED_CONTENT_ENCODINGS = ['identity', 'deflate', 'gzip'];
+
+const normalize = (encoding: string | undefined): string =>
+	(encoding || 'identity').trim().toLowerCase();
+
+export const isSupportedContentEncoding = (encoding: string | undefined): boolean =>
+	SUPPORTED_CONTENT_ENCODINGS.includes(normalize(encoding));
+
+const pipeThrough = (source: Readable, decoder: Transform): Readable => {
+	// A plain pipe rather than pipeline(): corrupt input must not destroy the
+	// request, whose socket still carries the error response
+	source.on('error', (error) => decoder.destroy(error));
+	decoder.on('error', () => {
+		source.unpipe(decoder);
+		source.resume();
+	});
+	return source.pipe(decoder);
+};
+
+/**
+ * Returns a stream of the decoded body. Errors on either side surface on the
+ * returned stream, so a consumer's pipeline fails on corrupt input.
+ */
+export const decodeContentEncoding = (source: Readable, encoding: string | undefined): Readable => {
+	switch (normalize(encoding)) {
+		case 'deflate':
+			return pipeThrough(source, createInflate());
+		case 'gzip':
+			return pipeThrough(source, createGunzip());
+		default:
+			return source;
+	}
+};
+
+export const isContentDecodingError = (error: unknown): boolean => {
+	const code = (error as NodeJS.ErrnoException | undefined)?.code;
+	return typeof code === 'string' && code.startsWith('Z_');
+};
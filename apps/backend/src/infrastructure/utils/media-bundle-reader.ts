@@ -0,0 +1,50 @@
+import { Readable } from 'stream';
+
+export const MEDIA_BUNDLE_CONTENT_TYPE = 'application/vnd.media-bundle';
+
+/**
+ * Reads a media bundle, the body the upload client sends to batch many small
+ * files into one request:
+ *
+ *   [uint32 big-endian manifest length][manifest JSON][file 1]...[file N]
+ *
+ * The manifest lists each file with its size, so file bodies follow back to
+ * back without separators. Bytes are pulled from the stream as they are
+ * needed; at most one file is held in memory by the reader.
+ */
+export class MediaBundleReader {
+	private readonly source: AsyncIterator<Buffer>;
+	private pending: Buffer[] = [];
+	private pendingBytes = 0;
+
+	constructor(stream: Readable) {
+		this.source = stream[Symbol.asyncIterator]();
+	}
+
+	async readManifest(maxBytes: number): Promise<unknown> {
+		const length = (await this.readExactly(4)).readUInt32BE(0);
+		if (length === 0 || length > maxBytes) {
+			throw new Error('Invalid bundle manifest length');
+		}
+		return JSON.parse((await this.readExactly(length)).toString('utf8'));
+	}
+
+	async readExactly(length: number): Promise<Buffer> {
+		while (this.pendingBytes < length) {
+			const { value, done } = await this.source.next();
+			if (done) {
+				throw new Error('Bundle ended before all files were received');
+			}
+			const chunk = Buffer.isBuffer(value) ? value : Buffer.from(value);
+			this.pending.push(chunk);
+			this.pendingBytes += chunk.length;
+		}
+
+		const joined = this.pending.length === 1 ? this.pending[0] : Buffer.concat(this.pending);
+		const result = joined.subarray(0, length);
+		const rest = joined.subarray(length);
+		this.pending = rest.length > 0 ? [rest] : [];
+		this.pendingBytes = rest.length;
+		return result;
+	}
+}
@@ -0,0 +1,245 @@
+import { Request, Response } from 'express';
+import { CommitDeltaUploadUseCase } from '../../../application/use-cases/commit-delta-upload.usecase';
+import { FindMissingChunksUseCase } from '../../../application/use-cases/find-missing-chunks.usecase';
+import { StoreDeltaChunkUseCase } from '../../../application/use-cases/store-delta-chunk.usecase';
+import { ILoggingService } from '../../../domain/services/ilogging.service';
+import {
+	decodeContentEncoding,
+	isContentDecodingError,
+	isSupportedContentEncoding,
+} from '../../../infrastructure/utils/content-encoding';
+import {
+	commitDeltaUploadSchema,
+	findMissingChunksSchema,
+	storeDeltaChunkSchema,
+} from '../validators/media.validation';
+
+// Delta sync: a client splits a file into content-defined chunks, sends the
+// ones the server does not hold yet, then commits the list of chunks that
+// make up the file, from which the server rebuilds it
+export class DeltaSyncController {
+	constructor(
+		private findMissingChunksUseCase: FindMissingChunksUseCase,
+		private storeDeltaChunkUseCase: StoreDeltaChunkUseCase,
+		private commitDeltaUploadUseCase: CommitDeltaUploadUseCase,
+		private loggingService: ILoggingService,
+	) {}
+
+	async checkChunks(req: Request, res: Response) {
+		try {
+			const validation = findMissingChunksSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const result = await this.findMissingChunksUseCase.execute({
+				userId,
+				hashes: validation.data.body.hashes,
+			});
+
+			res.json({
+				success: true,
+				missing: result.missing,
+			});
+		} catch (error) {
+			this.loggingService.error('Failed to check delta chunks', error, {
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to check delta chunks',
+			});
+		}
+	}
+
+	async storeChunk(req: Request, res: Response) {
+		try {
+			const validation = storeDeltaChunkSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const contentLength = Number(req.headers['content-length'] || 0);
+			if (contentLength > StoreDeltaChunkUseCase.MAX_CHUNK_SIZE) {
+				return res.status(413).json({
+					success: false,
+					message: 'Chunk too large',
+				});
+			}
+
+			const contentEncoding = req.headers['content-encoding'];
+			if (!isSupportedContentEncoding(contentEncoding)) {
+				return res.status(415).json({
+					success: false,
+					message: 'Unsupported content encoding',
+				});
+			}
+
+			// Streamed to the chunk store, which checks the bytes against the hash
+			const result = await this.storeDeltaChunkUseCase.execute({
+				userId,
+				hash: validation.data.params.hash,
+				chunk: decodeContentEncoding(req, contentEncoding),
+			});
+
+			res.status(201).json({
+				success: true,
+				size: result.size,
+			});
+		} catch (error) {
+			if (isContentDecodingError(error)) {
+				return res.status(400).json({
+					success: false,
+					message: 'Chunk could not be decoded',
+				});
+			}
+
+			if (error instanceof Error && error.message.includes('does not match its hash')) {
+				this.loggingService.warn('Delta chunk rejected', {
+					hash: req.params.hash,
+					userId: req.user?.userId,
+					requestId: req.requestId,
+				});
+				return res.status(400).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			if (error instanceof Error && error.message.includes('Storage limit exceeded')) {
+				return res.status(400).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			if (error instanceof Error && error.message.includes('exceeds the maximum chunk size')) {
+				return res.status(413).json({
+					success: false,
+					message: 'Chunk too large',
+				});
+			}
+
+			this.loggingService.error('Failed to store delta chunk', error, {
+				hash: req.params.hash,
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to store delta chunk',
+			});
+		}
+	}
+
+	async commit(req: Request, res: Response) {
+		try {
+			const validation = commitDeltaUploadSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const result = await this.commitDeltaUploadUseCase.execute({
+				userId,
+				...validation.data.body,
+			});
+
+			if (!result.success || !result.media) {
+				return res.status(409).json({
+					success: false,
+					message: result.message,
+					missing: result.missing,
+				});
+			}
+
+			const media = result.media;
+
+			this.loggingService.info('Media uploaded successfully', {
+				mediaId: media.id,
+				userId,
+				fileSize: media.getFileSizeInMB(),
+				requestId: req.requestId,
+			});
+
+			res.status(201).json({
+				success: true,
+				message: 'Media uploaded successfully',
+				media: {
+					id: media.id,
+					title: media.title,
+					description: media.description,
+					filename: media.filename,
+					originalName: media.originalName,
+					mimeType: media.mimeType,
+					size: media.size,
+					duration: media.duration,
+					url: media.url,
+					uploadedBy: media.uploadedBy,
+					thumbnails: media.thumbnails,
+					createdAt: media.createdAt,
+				},
+			});
+		} catch (error) {
+			this.loggingService.error('Failed to commit delta upload', error, {
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			if (
+				error instanceof Error &&
+				(error.message.includes('Storage limit exceeded') ||
+					error.message.includes('Unsupported file type') ||
+					error.message.includes('do not add up to the file size'))
+			) {
+				return res.status(400).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to commit delta upload',
+			});
+		}
+	}
+}
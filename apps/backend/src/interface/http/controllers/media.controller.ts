@@ -1,10 +1,25 @@
 import { Request, Response } from 'express';
+import { AttachThumbnailsUseCase } from '../../../application/use-cases/attach-thumbnails.usecase';
 import { DeleteMediaUseCase } from '../../../application/use-cases/delete-media.usecase';
+import { FindDuplicateMediaUseCase } from '../../../application/use-cases/find-duplicate-media.usecase';
 import { GetMediaByIdUseCase } from '../../../application/use-cases/get-media-by-id.usecase';
 import { GetUserMediaUseCase } from '../../../application/use-cases/get-user-media.usecase';
+import { UploadMediaBatchUseCase } from '../../../application/use-cases/upload-media-batch.usecase';
 import { UploadMediaUseCase } from '../../../application/use-cases/upload-media.usecase';
 import { ILoggingService } from '../../../domain/services/ilogging.service';
-import { uploadMediaSchema } from '../validators/media.validation';
+import {
+	MEDIA_BUNDLE_CONTENT_TYPE,
+	MediaBundleReader,
+} from '../../../infrastructure/utils/media-bundle-reader';
+import {
+	attachThumbnailsSchema,
+	duplicateCheckSchema,
+	uploadBatchManifestSchema,
+	uploadMediaSchema,
+} from '../validators/media.validation';
+
+// Manifest of a full batch: 500 entries with long names stay well below this
+const MAX_BUNDLE_MANIFEST_SIZE = 1024 * 1024;
 
 export class MediaController {
 	constructor(
@@ -12,6 +27,9 @@ export class MediaController {
 		private getUserMediaUseCase: GetUserMediaUseCase,
 		private getMediaByIdUseCase: GetMediaByIdUseCase,
 		private deleteMediaUseCase: DeleteMediaUseCase,
+		private findDuplicateMediaUseCase: FindDuplicateMediaUseCase,
+		private uploadMediaBatchUseCase: UploadMediaBatchUseCase,
+		private attachThumbnailsUseCase: AttachThumbnailsUseCase,
 		private loggingService: ILoggingService,
 	) {}
 
@@ -34,7 +52,7 @@ export class MediaController {
 				});
 			}
 
-			const { title, description } = validation.data.body;
+			const { title, description, contentHash, duration } = validation.data.body;
 			const userId = req.user?.userId;
 
 			if (!userId) {
@@ -54,8 +72,9 @@ export class MediaController {
 				originalName: req.file.originalname,
 				mimeType: req.file.mimetype,
 				size: req.file.size,
-				duration: 0, // TODO: Extract actual duration from video/audio files
+				duration: duration ?? 0,
 				uploadedBy: userId,
+				contentHash,
 			});
 
 			this.loggingService.info('Media uploaded successfully', {
@@ -105,6 +124,242 @@ export class MediaController {
 		}
 	}
 
+	async checkDuplicate(req: Request, res: Response) {
+		try {
+			const validation = duplicateCheckSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const result = await this.findDuplicateMediaUseCase.execute({
+				userId,
+				contentHash: validation.data.body.contentHash,
+				fileSize: validation.data.body.fileSize,
+			});
+
+			if (!result.exists || !result.media) {
+				return res.json({
+					success: true,
+					exists: false,
+				});
+			}
+
+			const media = result.media;
+			res.json({
+				success: true,
+				exists: true,
+				media: {
+					id: media.id,
+					title: media.title,
+					originalName: media.originalName,
+					mimeType: media.mimeType,
+					size: media.size,
+					url: media.url,
+					thumbnails: media.thumbnails,
+					createdAt: media.createdAt,
+				},
+			});
+		} catch (error) {
+			this.loggingService.error('Duplicate check failed', error, {
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Duplicate check failed',
+			});
+		}
+	}
+
+	async uploadBatch(req: Request, res: Response) {
+		try {
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			if (!req.is(MEDIA_BUNDLE_CONTENT_TYPE)) {
+				return res.status(415).json({
+					success: false,
+					message: `Expected ${MEDIA_BUNDLE_CONTENT_TYPE}`,
+				});
+			}
+
+			const contentLength = Number(req.headers['content-length'] || 0);
+			if (contentLength > UploadMediaBatchUseCase.MAX_BATCH_SIZE) {
+				return res.status(413).json({
+					success: false,
+					message: 'Batch too large',
+				});
+			}
+
+			// The body is read straight from the request, one file at a time
+			const reader = new MediaBundleReader(req);
+			let manifest: unknown;
+			try {
+				manifest = await reader.readManifest(MAX_BUNDLE_MANIFEST_SIZE);
+			} catch {
+				return res.status(400).json({
+					success: false,
+					message: 'Invalid batch manifest',
+				});
+			}
+
+			const validation = uploadBatchManifestSchema.safeParse(manifest);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const { files } = validation.data;
+			const totalSize = files.reduce((sum, file) => sum + file.size, 0);
+			if (
+				files.length > UploadMediaBatchUseCase.MAX_FILES ||
+				totalSize > UploadMediaBatchUseCase.MAX_BATCH_SIZE ||
+				files.some((file) => file.size > UploadMediaBatchUseCase.MAX_FILE_SIZE)
+			) {
+				return res.status(413).json({
+					success: false,
+					message: 'Batch exceeds file count or size limits',
+				});
+			}
+
+			const result = await this.uploadMediaBatchUseCase.execute({
+				uploadedBy: userId,
+				files,
+				readFile: (entry) => reader.readExactly(entry.size),
+			});
+
+			const storedCount = result.results.filter((file) => file.success).length;
+			this.loggingService.info('Media batch uploaded', {
+				userId,
+				fileCount: files.length,
+				storedCount,
+				totalSize,
+				requestId: req.requestId,
+			});
+
+			res.status(storedCount > 0 ? 201 : 500).json({
+				success: storedCount > 0,
+				results: result.results.map((file) => ({
+					index: file.index,
+					originalName: file.originalName,
+					success: file.success,
+					error: file.error,
+					media: file.media
+						? {
+								id: file.media.id,
+								title: file.media.title,
+								originalName: file.media.originalName,
+								mimeType: file.media.mimeType,
+								size: file.media.size,
+								url: file.media.url,
+								createdAt: file.media.createdAt,
+							}
+						: undefined,
+				})),
+			});
+		} catch (error) {
+			this.loggingService.error('Media batch upload failed', error, {
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			if (error instanceof Error && error.message.includes('Storage limit exceeded')) {
+				return res.status(400).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			res.status(500).json({
+				success: false,
+				message: 'Media batch upload failed',
+			});
+		}
+	}
+
+	async attachThumbnails(req: Request, res: Response) {
+		try {
+			const validation = attachThumbnailsSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const files = (req.files as Express.Multer.File[] | undefined) || [];
+			const result = await this.attachThumbnailsUseCase.execute({
+				mediaId: validation.data.params.id,
+				userId,
+				thumbnails: files.map((file) => file.buffer),
+			});
+
+			res.json({
+				success: true,
+				thumbnails: result.thumbnails,
+			});
+		} catch (error) {
+			if (error instanceof Error && error.message.includes('Media not found')) {
+				return res.status(404).json({
+					success: false,
+					message: 'Media not found',
+				});
+			}
+
+			if (
+				error instanceof Error &&
+				(error.message.includes('only be attached to images') ||
+					error.message.includes('must be JPEG images'))
+			) {
+				return res.status(400).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			this.loggingService.error('Failed to attach thumbnails', error, {
+				mediaId: req.params.id,
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to attach thumbnails',
+			});
+		}
+	}
+
 	async getUserMedia(req: Request, res: Response) {
 		try {
 			const userId = req.user?.userId;
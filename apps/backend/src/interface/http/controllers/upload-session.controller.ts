@@ -0,0 +1,420 @@
+import { Request, Response } from 'express';
+import { AbortUploadSessionUseCase } from '../../../application/use-cases/abort-upload-session.usecase';
+import { AppendUploadChunkUseCase } from '../../../application/use-cases/append-upload-chunk.usecase';
+import { CompleteUploadSessionUseCase } from '../../../application/use-cases/complete-upload-session.usecase';
+import { CreateUploadSessionUseCase } from '../../../application/use-cases/create-upload-session.usecase';
+import { GetUploadSessionUseCase } from '../../../application/use-cases/get-upload-session.usecase';
+import { PresignUploadPartsUseCase } from '../../../application/use-cases/presign-upload-parts.usecase';
+import { UploadSession } from '../../../domain/entities/upload-session.entity';
+import { UploadedPart } from '../../../domain/services/idirect-upload.service';
+import { ILoggingService } from '../../../domain/services/ilogging.service';
+import {
+	decodeContentEncoding,
+	isContentDecodingError,
+	isSupportedContentEncoding,
+} from '../../../infrastructure/utils/content-encoding';
+import {
+	completeUploadSessionSchema,
+	createUploadSessionSchema,
+	presignUploadPartsSchema,
+	uploadChunkSchema,
+	uploadSessionByIdSchema,
+} from '../validators/media.validation';
+
+export class UploadSessionController {
+	constructor(
+		private createUploadSessionUseCase: CreateUploadSessionUseCase,
+		private getUploadSessionUseCase: GetUploadSessionUseCase,
+		private appendUploadChunkUseCase: AppendUploadChunkUseCase,
+		private completeUploadSessionUseCase: CompleteUploadSessionUseCase,
+		private abortUploadSessionUseCase: AbortUploadSessionUseCase,
+		private presignUploadPartsUseCase: PresignUploadPartsUseCase,
+		private loggingService: ILoggingService,
+	) {}
+
+	async createSession(req: Request, res: Response) {
+		try {
+			const validation = createUploadSessionSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const { fileName, fileSize, mimeType, title, description, contentHash, mode, partSize } =
+				validation.data.body;
+			const result = await this.createUploadSessionUseCase.execute({
+				userId,
+				fileName,
+				mimeType,
+				totalSize: fileSize,
+				title,
+				description,
+				contentHash,
+				mode,
+				partSize,
+			});
+
+			res.status(201).json({
+				success: true,
+				session: this.toResponse(result.session),
+			});
+		} catch (error) {
+			this.loggingService.error('Failed to create upload session', error, {
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			// Clients fall back to staged sessions
+			if (error instanceof Error && error.message.includes('Direct uploads are not available')) {
+				return res.status(501).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			if (
+				error instanceof Error &&
+				(error.message.includes('Storage limit exceeded') ||
+					error.message.includes('Unsupported file type'))
+			) {
+				return res.status(400).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to create upload session',
+			});
+		}
+	}
+
+	async getSession(req: Request, res: Response) {
+		try {
+			const validation = uploadSessionByIdSchema.safeParse(req);
+			const userId = req.user?.userId;
+			if (!validation.success || !userId) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+				});
+			}
+
+			const result = await this.getUploadSessionUseCase.execute({
+				sessionId: validation.data.params.sessionId,
+				userId,
+			});
+
+			if (!result.success || !result.session) {
+				return res.status(404).json({
+					success: false,
+					message: 'Upload session not found',
+				});
+			}
+
+			res.json({
+				success: true,
+				session: this.toResponse(result.session, result.uploadedParts),
+			});
+		} catch (error) {
+			this.loggingService.error('Failed to get upload session', error, {
+				sessionId: req.params.sessionId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to get upload session',
+			});
+		}
+	}
+
+	async appendChunk(req: Request, res: Response) {
+		try {
+			const validation = uploadChunkSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const contentLength = Number(req.headers['content-length'] || 0);
+			if (contentLength > AppendUploadChunkUseCase.MAX_CHUNK_SIZE) {
+				return res.status(413).json({
+					success: false,
+					message: 'Chunk too large',
+				});
+			}
+
+			const contentEncoding = req.headers['content-encoding'];
+			if (!isSupportedContentEncoding(contentEncoding)) {
+				return res.status(415).json({
+					success: false,
+					message: 'Unsupported content encoding',
+				});
+			}
+
+			// The request body is streamed straight to the staging file, inflated
+			// on the way if the client compressed it
+			const result = await this.appendUploadChunkUseCase.execute({
+				sessionId: validation.data.params.sessionId,
+				userId,
+				offset: validation.data.headers['upload-offset'],
+				chunk: decodeContentEncoding(req, contentEncoding),
+			});
+
+			if (!result.success) {
+				const status = result.offsetMismatch ? 409 : result.wrongMode ? 400 : 404;
+				return res.status(status).json({
+					success: false,
+					message: result.message,
+					receivedBytes: result.receivedBytes,
+				});
+			}
+
+			res.json({
+				success: true,
+				receivedBytes: result.receivedBytes,
+			});
+		} catch (error) {
+			if (isContentDecodingError(error)) {
+				this.loggingService.warn('Upload chunk could not be decoded', {
+					sessionId: req.params.sessionId,
+					contentEncoding: req.headers['content-encoding'],
+					requestId: req.requestId,
+				});
+				return res.status(400).json({
+					success: false,
+					message: 'Chunk could not be decoded',
+				});
+			}
+
+			this.loggingService.error('Failed to store upload chunk', error, {
+				sessionId: req.params.sessionId,
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to store upload chunk',
+			});
+		}
+	}
+
+	async presignParts(req: Request, res: Response) {
+		try {
+			const validation = presignUploadPartsSchema.safeParse(req);
+			if (!validation.success) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+					errors: validation.error.issues,
+				});
+			}
+
+			const userId = req.user?.userId;
+			if (!userId) {
+				return res.status(401).json({
+					success: false,
+					message: 'User not authenticated',
+				});
+			}
+
+			const result = await this.presignUploadPartsUseCase.execute({
+				sessionId: validation.data.params.sessionId,
+				userId,
+				partNumbers: validation.data.body.partNumbers,
+			});
+
+			if (!result.success) {
+				return res.status(result.notFound ? 404 : 400).json({
+					success: false,
+					message: result.message,
+				});
+			}
+
+			res.json({
+				success: true,
+				parts: result.parts,
+				expiresAt: result.expiresAt,
+			});
+		} catch (error) {
+			this.loggingService.error('Failed to sign upload part URLs', error, {
+				sessionId: req.params.sessionId,
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to sign upload part URLs',
+			});
+		}
+	}
+
+	async completeSession(req: Request, res: Response) {
+		try {
+			const validation = completeUploadSessionSchema.safeParse(req);
+			const userId = req.user?.userId;
+			if (!validation.success || !userId) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+				});
+			}
+
+			const result = await this.completeUploadSessionUseCase.execute({
+				sessionId: validation.data.params.sessionId,
+				userId,
+				duration: validation.data.body?.duration,
+			});
+
+			if (!result.success || !result.media) {
+				const conflict = result.receivedBytes !== undefined || result.inProgress;
+				return res.status(conflict ? 409 : 404).json({
+					success: false,
+					message: result.message,
+					receivedBytes: result.receivedBytes,
+				});
+			}
+
+			const media = result.media;
+
+			this.loggingService.info('Media uploaded successfully', {
+				mediaId: media.id,
+				userId,
+				fileSize: media.getFileSizeInMB(),
+				requestId: req.requestId,
+			});
+
+			res.status(201).json({
+				success: true,
+				message: 'Media uploaded successfully',
+				media: {
+					id: media.id,
+					title: media.title,
+					description: media.description,
+					filename: media.filename,
+					originalName: media.originalName,
+					mimeType: media.mimeType,
+					size: media.size,
+					duration: media.duration,
+					url: media.url,
+					uploadedBy: media.uploadedBy,
+					thumbnails: media.thumbnails,
+					createdAt: media.createdAt,
+				},
+			});
+		} catch (error) {
+			this.loggingService.error('Failed to complete upload session', error, {
+				sessionId: req.params.sessionId,
+				userId: req.user?.userId,
+				requestId: req.requestId,
+			});
+
+			if (
+				error instanceof Error &&
+				(error.message.includes('Storage limit exceeded') ||
+					error.message.includes('does not match the upload session size'))
+			) {
+				return res.status(400).json({
+					success: false,
+					message: error.message,
+				});
+			}
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to complete upload session',
+			});
+		}
+	}
+
+	async abortSession(req: Request, res: Response) {
+		try {
+			const validation = uploadSessionByIdSchema.safeParse(req);
+			const userId = req.user?.userId;
+			if (!validation.success || !userId) {
+				return res.status(400).json({
+					success: false,
+					message: 'Validation failed',
+				});
+			}
+
+			const result = await this.abortUploadSessionUseCase.execute({
+				sessionId: validation.data.params.sessionId,
+				userId,
+			});
+
+			if (!result.success) {
+				return res.status(404).json({
+					success: false,
+					message: result.message,
+				});
+			}
+
+			res.json({
+				success: true,
+				message: result.message,
+			});
+		} catch (error) {
+			this.loggingService.error('Failed to abort upload session', error, {
+				sessionId: req.params.sessionId,
+				requestId: req.requestId,
+			});
+
+			res.status(500).json({
+				success: false,
+				message: 'Failed to abort upload session',
+			});
+		}
+	}
+
+	private toResponse(session: UploadSession, uploadedParts?: UploadedPart[]) {
+		const response = {
+			id: session.id,
+			fileName: session.fileName,
+			mimeType: session.mimeType,
+			totalSize: session.totalSize,
+			receivedBytes: session.receivedBytes,
+			status: session.status,
+			expiresAt: session.expiresAt,
+			mode: session.mode,
+		};
+		if (!session.isDirect()) {
+			return response;
+		}
+
+		const parts = uploadedParts || [];
+		return {
+			...response,
+			receivedBytes: parts.reduce((sum, part) => sum + part.size, 0),
+			partSize: session.partSize,
+			partCount: session.getPartCount(),
+			uploadedParts: parts.map((part) => ({ partNumber: part.partNumber, size: part.size })),
+		};
+	}
+}
@@ -1,5 +1,13 @@
+import { Request } from 'express';
 import rateLimit from 'express-rate-limit';
 
+// Chunk PUTs of a resumable upload are already authenticated and bounded per
+// session; counting them would cap a single large upload at ~1000 chunks.
+// Delta sync chunks are bounded the same way, by hash and size in the store,
+// and a first sync sends one per ~1MB of the file.
+const UPLOAD_CHUNK_PATH = /\/media\/uploads\/[^/]+\/chunks$/;
+const DELTA_CHUNK_PATH = /\/media\/delta\/chunks\/[a-f0-9]{64}$/;
+
 export const rateLimiterConfig = rateLimit({
 	windowMs: 15 * 60 * 1000, // 15 minutes
 	max: 1000, // limit each IP to 1000 requests per windowMs
@@ -9,4 +17,6 @@ export const rateLimiterConfig = rateLimit({
 	},
 	standardHeaders: false,
 	legacyHeaders: false,
+	skip: (req: Request) =>
+		req.method === 'PUT' && (UPLOAD_CHUNK_PATH.test(req.path) || DELTA_CHUNK_PATH.test(req.path)),
 });
@@ -1,7 +1,10 @@
 import { Router } from 'express';
 import multer from 'multer';
+import { AttachThumbnailsUseCase } from '../../../application/use-cases/attach-thumbnails.usecase';
 import { IAuthService } from '../../../domain/services/iauth.service';
+import { DeltaSyncController } from '../controllers/delta-sync.controller';
 import { MediaController } from '../controllers/media.controller';
+import { UploadSessionController } from '../controllers/upload-session.controller';
 import { authMiddleware } from '../middlewares/auth.middleware';
 
 // Configure multer for memory storage (for S3 uploads)
@@ -21,7 +24,29 @@ const upload = multer({
 	},
 });
 
-export const createMediaRoutes = (mediaController: MediaController, authService: IAuthService) => {
+// Thumbnails the client made of an image it uploaded; small, so kept in memory
+const thumbnailUpload = multer({
+	storage: multer.memoryStorage(),
+	limits: {
+		files: AttachThumbnailsUseCase.MAX_THUMBNAILS,
+		fileSize: AttachThumbnailsUseCase.MAX_THUMBNAIL_SIZE,
+	},
+	fileFilter: (_req, file, cb) => {
+		if (file.mimetype === 'image/jpeg') {
+			cb(null, true);
+		} else {
+			cb(new Error('Thumbnails must be JPEG images'));
+		}
+	},
+}).array('thumbnails', AttachThumbnailsUseCase.MAX_THUMBNAILS);
+
+export const createMediaRoutes = (
+	mediaController: MediaController,
+	authService: IAuthService,
+	uploadSessionController: UploadSessionController,
+	// Without it the delta sync routes are not mounted and clients upload whole files
+	deltaSyncController?: DeltaSyncController,
+) => {
 	const router = Router();
 
 	// All media routes require authentication
@@ -30,9 +55,61 @@ export const createMediaRoutes = (mediaController: MediaController, authService:
 	// Upload media (single file)
 	router.post('/upload', upload.single('media'), mediaController.uploadMedia.bind(mediaController));
 
+	// Many small files in one streamed request (body format: MediaBundleReader)
+	router.post('/upload-batch', mediaController.uploadBatch.bind(mediaController));
+
+	// Ask whether the user already has this content before uploading it
+	router.post('/dedupe-check', mediaController.checkDuplicate.bind(mediaController));
+
+	// Resumable chunked uploads
+	router.post('/uploads', uploadSessionController.createSession.bind(uploadSessionController));
+	router.get('/uploads/:sessionId', uploadSessionController.getSession.bind(uploadSessionController));
+	router.put(
+		'/uploads/:sessionId/chunks',
+		uploadSessionController.appendChunk.bind(uploadSessionController),
+	);
+	// Direct sessions: presigned URLs to PUT parts straight to object storage
+	router.post(
+		'/uploads/:sessionId/parts',
+		uploadSessionController.presignParts.bind(uploadSessionController),
+	);
+	router.post(
+		'/uploads/:sessionId/complete',
+		uploadSessionController.completeSession.bind(uploadSessionController),
+	);
+	router.delete(
+		'/uploads/:sessionId',
+		uploadSessionController.abortSession.bind(uploadSessionController),
+	);
+
+	// Delta sync: send only the chunks the server does not hold, then commit the file's chunk list
+	if (deltaSyncController) {
+		router.post('/delta/chunks/check', deltaSyncController.checkChunks.bind(deltaSyncController));
+		router.put('/delta/chunks/:hash', deltaSyncController.storeChunk.bind(deltaSyncController));
+		router.post('/delta', deltaSyncController.commit.bind(deltaSyncController));
+	}
+
 	// Get user's media
 	router.get('/my-media', mediaController.getUserMedia.bind(mediaController));
 
+	// Thumbnails made by the client, so the server does no image decoding of its own
+	router.post(
+		'/:id/thumbnails',
+		(req, res, next) => {
+			thumbnailUpload(req, res, (error: unknown) => {
+				if (!error) {
+					return next();
+				}
+				const tooLarge = error instanceof multer.MulterError && error.code === 'LIMIT_FILE_SIZE';
+				res.status(tooLarge ? 413 : 400).json({
+					success: false,
+					message: error instanceof Error ? error.message : 'Invalid thumbnails',
+				});
+			});
+		},
+		mediaController.attachThumbnails.bind(mediaController),
+	);
+
 	// Get specific media by ID
 	router.get('/:id', mediaController.getMediaById.bind(mediaController));
 
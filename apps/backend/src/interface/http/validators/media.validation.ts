@@ -1,10 +1,18 @@
 import { z } from 'zod';
 
+// BLAKE2b-256 digest of the file, hex encoded
+const contentHashSchema = z
+	.string()
+	.regex(/^[a-f0-9]{64}$/, 'Content hash must be a 64 character hex digest');
+
 // Media upload schema (file validation handled by multer)
 export const uploadMediaSchema = z.object({
 	body: z.object({
 		title: z.string().min(1, 'Title is required').max(100, 'Title too long'),
 		description: z.string().max(500, 'Description too long').optional(),
+		contentHash: contentHashSchema.optional(),
+		// Seconds, read by the client from the container header; multipart fields are strings
+		duration: z.coerce.number().min(0).optional(),
 	}),
 });
 
@@ -26,6 +34,13 @@ export const mediaByIdSchema = z.object({
 	}),
 });
 
+// Client-made thumbnails for an uploaded image (files handled by multer)
+export const attachThumbnailsSchema = z.object({
+	params: z.object({
+		id: z.string().min(1, 'Media ID is required'),
+	}),
+});
+
 // Media search schema
 export const mediaSearchSchema = z.object({
 	query: z.object({
@@ -51,3 +66,126 @@ export type UpdateMediaInput = z.infer<typeof updateMediaSchema>['body'];
 export type MediaByIdParams = z.infer<typeof mediaByIdSchema>['params'];
 export type MediaSearchQuery = z.infer<typeof mediaSearchSchema>['query'];
 export type MediaByUserQuery = z.infer<typeof mediaByUserSchema>['query'];
+
+export const duplicateCheckSchema = z.object({
+	body: z.object({
+		contentHash: contentHashSchema,
+		fileSize: z.number().int().min(0, 'File size must be non-negative'),
+	}),
+});
+
+// Resumable upload session schemas
+export const createUploadSessionSchema = z.object({
+	body: z.object({
+		fileName: z.string().min(1, 'File name is required').max(255, 'File name too long'),
+		fileSize: z.number().int().positive('File size must be positive'),
+		mimeType: z.string().min(1, 'MIME type is required'),
+		title: z.string().max(100, 'Title too long').optional(),
+		description: z.string().max(500, 'Description too long').optional(),
+		contentHash: contentHashSchema.optional(),
+		// direct: parts go straight to object storage through presigned URLs
+		mode: z.enum(['staged', 'direct']).optional(),
+		partSize: z.number().int().positive('Part size must be positive').optional(),
+	}),
+});
+
+export const uploadSessionByIdSchema = z.object({
+	params: z.object({
+		sessionId: z.string().min(1, 'Upload session ID is required'),
+	}),
+});
+
+export const uploadChunkSchema = z.object({
+	params: z.object({
+		sessionId: z.string().min(1, 'Upload session ID is required'),
+	}),
+	headers: z.object({
+		'upload-offset': z.coerce.number().int().min(0, 'Upload offset must be non-negative'),
+	}),
+});
+
+export const presignUploadPartsSchema = z.object({
+	params: z.object({
+		sessionId: z.string().min(1, 'Upload session ID is required'),
+	}),
+	body: z.object({
+		partNumbers: z
+			.array(z.number().int().positive('Part numbers start at 1'))
+			.min(1, 'At least one part number is required')
+			.max(100, 'Too many parts in one request'),
+	}),
+});
+
+export const completeUploadSessionSchema = z.object({
+	params: z.object({
+		sessionId: z.string().min(1, 'Upload session ID is required'),
+	}),
+	body: z
+		.object({
+			duration: z.number().min(0).optional(),
+		})
+		.optional(),
+});
+
+export type CreateUploadSessionBody = z.infer<typeof createUploadSessionSchema>['body'];
+
+// Delta sync: content-defined chunks named by their SHA-256, hex encoded
+const chunkHashSchema = z
+	.string()
+	.regex(/^[a-f0-9]{64}$/, 'Chunk hash must be a 64 character hex digest');
+
+export const findMissingChunksSchema = z.object({
+	body: z.object({
+		hashes: z
+			.array(chunkHashSchema)
+			.min(1, 'At least one chunk hash is required')
+			.max(1000, 'Too many chunk hashes in one request'),
+	}),
+});
+
+export const storeDeltaChunkSchema = z.object({
+	params: z.object({
+		hash: chunkHashSchema,
+	}),
+});
+
+export const commitDeltaUploadSchema = z.object({
+	body: z.object({
+		fileName: z.string().min(1, 'File name is required').max(255, 'File name too long'),
+		fileSize: z.number().int().positive('File size must be positive'),
+		mimeType: z.string().min(1, 'MIME type is required'),
+		title: z.string().max(100, 'Title too long').optional(),
+		description: z.string().max(500, 'Description too long').optional(),
+		contentHash: contentHashSchema.optional(),
+		duration: z.number().min(0).optional(),
+		chunks: z
+			.array(
+				z.object({
+					hash: chunkHashSchema,
+					size: z.number().int().positive('Chunk size must be positive'),
+				}),
+			)
+			.min(1, 'At least one chunk is required')
+			.max(100000, 'Too many chunks'),
+	}),
+});
+
+// Manifest at the head of a batched upload (see MediaBundleReader)
+export const uploadBatchManifestSchema = z.object({
+	files: z
+		.array(
+			z.object({
+				name: z.string().min(1, 'File name is required').max(255, 'File name too long'),
+				size: z.number().int().min(0, 'File size must be non-negative'),
+				mimeType: z
+					.string()
+					.regex(/^(video|audio|image)\//, 'Unsupported file type'),
+				title: z.string().max(100, 'Title too long').optional(),
+				contentHash: contentHashSchema.optional(),
+				duration: z.number().min(0).optional(),
+			}),
+		)
+		.min(1, 'At least one file is required'),
+});
+
+export type UploadBatchManifest = z.infer<typeof uploadBatchManifestSchema>;
@@ -0,0 +1,85 @@
+import { AttachThumbnailsUseCase } from '../../../src/application/use-cases/attach-thumbnails.usecase';
+import { IMediaRepository } from '../../../src/domain/repositories/imedia.repository';
+import { ILoggingService } from '../../../src/domain/services/ilogging.service';
+import { IThumbnailService } from '../../../src/domain/services/ithumbnail.service';
+
+const jpeg = (size: number) => Buffer.concat([Buffer.from([0xff, 0xd8, 0xff, 0xe0]), Buffer.alloc(size)]);
+
+describe('AttachThumbnailsUseCase', () => {
+	const makeSut = () => {
+		const mediaRepository: jest.Mocked<IMediaRepository> = {
+			findById: jest.fn(),
+			update: jest.fn(),
+			delete: jest.fn() as any,
+			create: jest.fn() as any,
+			findByUserId: jest.fn() as any,
+			findByMimeType: jest.fn() as any,
+			findByContentHash: jest.fn() as any,
+			createMany: jest.fn() as any,
+			search: jest.fn() as any,
+			getUserMediaStats: jest.fn() as any,
+		};
+		const thumbnailService: jest.Mocked<IThumbnailService> = {
+			generateThumbnails: jest.fn() as any,
+			generateThumbnailsFromPath: jest.fn() as any,
+			storeThumbnails: jest.fn(),
+		};
+		const loggingService: jest.Mocked<ILoggingService> = {
+			debug: jest.fn() as any,
+			info: jest.fn(),
+			warn: jest.fn(),
+			error: jest.fn(),
+			fatal: jest.fn() as any,
+		};
+
+		const sut = new AttachThumbnailsUseCase(mediaRepository, thumbnailService, loggingService);
+		return { sut, mediaRepository, thumbnailService };
+	};
+
+	const image = { id: '1', filename: 'photo.jpg', mimeType: 'image/jpeg', uploadedBy: 'user1', thumbnails: [] } as any;
+
+	it('stores client thumbnails without generating any', async () => {
+		const { sut, mediaRepository, thumbnailService } = makeSut();
+		mediaRepository.findById.mockResolvedValue(image);
+		thumbnailService.storeThumbnails.mockResolvedValue(['https://s3/t0.jpg', 'https://s3/t1.jpg']);
+		mediaRepository.update.mockImplementation(async (_id, updates) => ({ ...image, ...updates }));
+
+		const result = await sut.execute({ mediaId: '1', userId: 'user1', thumbnails: [jpeg(100), jpeg(50)] });
+
+		expect(result.thumbnails).toEqual(['https://s3/t0.jpg', 'https://s3/t1.jpg']);
+		expect(mediaRepository.update).toHaveBeenCalledWith('1', { thumbnails: result.thumbnails });
+		expect(thumbnailService.generateThumbnails).not.toHaveBeenCalled();
+		expect(thumbnailService.generateThumbnailsFromPath).not.toHaveBeenCalled();
+	});
+
+	it('keeps the thumbnails media already has', async () => {
+		const { sut, mediaRepository, thumbnailService } = makeSut();
+		mediaRepository.findById.mockResolvedValue({ ...image, thumbnails: ['https://s3/old.jpg'] });
+
+		const result = await sut.execute({ mediaId: '1', userId: 'user1', thumbnails: [jpeg(100)] });
+
+		expect(result.thumbnails).toEqual(['https://s3/old.jpg']);
+		expect(thumbnailService.storeThumbnails).not.toHaveBeenCalled();
+	});
+
+	it("rejects another user's media, non-images and non-JPEG data", async () => {
+		const { sut, mediaRepository, thumbnailService } = makeSut();
+
+		mediaRepository.findById.mockResolvedValue(image);
+		await expect(sut.execute({ mediaId: '1', userId: 'user2', thumbnails: [jpeg(10)] })).rejects.toThrow(
+			'Media not found',
+		);
+
+		mediaRepository.findById.mockResolvedValue({ ...image, mimeType: 'video/mp4' });
+		await expect(sut.execute({ mediaId: '1', userId: 'user1', thumbnails: [jpeg(10)] })).rejects.toThrow(
+			'only be attached to images',
+		);
+
+		mediaRepository.findById.mockResolvedValue(image);
+		await expect(
+			sut.execute({ mediaId: '1', userId: 'user1', thumbnails: [Buffer.from('\x89PNG\r\n')] }),
+		).rejects.toThrow('must be JPEG images');
+
+		expect(thumbnailService.storeThumbnails).not.toHaveBeenCalled();
+	});
+});
@@ -11,6 +11,8 @@ describe('DeleteMediaUseCase', () => {
 			create: jest.fn() as any,
 			findByUserId: jest.fn() as any,
 			findByMimeType: jest.fn() as any,
+			findByContentHash: jest.fn() as any,
+			createMany: jest.fn() as any,
 			update: jest.fn() as any,
 			search: jest.fn() as any,
 			getUserMediaStats: jest.fn() as any,
@@ -18,6 +20,7 @@ describe('DeleteMediaUseCase', () => {
 		const fileUploadService: jest.Mocked<IFileUploadService> = {
 			deleteFile: jest.fn(),
 			uploadFile: jest.fn() as any,
+			uploadFileFromPath: jest.fn() as any,
 			getSignedUrl: jest.fn() as any,
 		};
 		const loggingService: jest.Mocked<ILoggingService> = {
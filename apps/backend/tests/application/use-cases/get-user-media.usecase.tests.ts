@@ -9,6 +9,8 @@ describe('GetUserMediaUseCase', () => {
 			create: jest.fn() as any,
 			findById: jest.fn() as any,
 			findByMimeType: jest.fn() as any,
+			findByContentHash: jest.fn() as any,
+			createMany: jest.fn() as any,
 			update: jest.fn() as any,
 			delete: jest.fn() as any,
 			search: jest.fn() as any,
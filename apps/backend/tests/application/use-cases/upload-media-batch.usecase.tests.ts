@@ -0,0 +1,187 @@
+import { UploadMediaBatchUseCase } from '../../../src/application/use-cases/upload-media-batch.usecase';
+import { IMediaRepository } from '../../../src/domain/repositories/imedia.repository';
+import { IFileUploadService } from '../../../src/domain/services/ifile-upload.service';
+import { ILoggingService } from '../../../src/domain/services/ilogging.service';
+import { IStorageService } from '../../../src/domain/services/istorage.service';
+import { IThumbnailService } from '../../../src/domain/services/ithumbnail.service';
+
+const makeSut = () => {
+	const mediaRepository: jest.Mocked<IMediaRepository> = {
+		create: jest.fn() as any,
+		createMany: jest.fn(),
+		findById: jest.fn() as any,
+		findByUserId: jest.fn() as any,
+		findByMimeType: jest.fn() as any,
+		findByContentHash: jest.fn() as any,
+		update: jest.fn() as any,
+		delete: jest.fn() as any,
+		search: jest.fn() as any,
+		getUserMediaStats: jest.fn() as any,
+	};
+	const fileUploadService: jest.Mocked<IFileUploadService> = {
+		uploadFile: jest.fn(),
+		uploadFileFromPath: jest.fn() as any,
+		deleteFile: jest.fn() as any,
+		getSignedUrl: jest.fn() as any,
+	};
+	const thumbnailService: jest.Mocked<IThumbnailService> = {
+		generateThumbnails: jest.fn().mockResolvedValue([]),
+		generateThumbnailsFromPath: jest.fn() as any,
+		storeThumbnails: jest.fn() as any,
+	};
+	const storageService: jest.Mocked<IStorageService> = {
+		calculateUserStorageUsage: jest.fn() as any,
+		canUserUpload: jest.fn().mockResolvedValue({
+			canUpload: true,
+			currentUsage: 0,
+			maxLimit: 1000,
+			remainingSpace: 1000,
+		}),
+		getUserStorageStats: jest.fn() as any,
+	};
+	const loggingService: jest.Mocked<ILoggingService> = {
+		debug: jest.fn() as any,
+		info: jest.fn() as any,
+		warn: jest.fn() as any,
+		error: jest.fn() as any,
+		fatal: jest.fn() as any,
+	};
+
+	const sut = new UploadMediaBatchUseCase(
+		mediaRepository,
+		fileUploadService,
+		thumbnailService,
+		storageService,
+		loggingService,
+	);
+	return { sut, mediaRepository, fileUploadService, storageService };
+};
+
+const files = [
+	{ name: 'a.jpg', size: 1, mimeType: 'image/jpeg' },
+	{ name: 'b.jpg', size: 2, mimeType: 'image/jpeg' },
+	{ name: 'c.jpg', size: 3, mimeType: 'image/jpeg' },
+];
+
+describe('UploadMediaBatchUseCase', () => {
+	it('stores every file and creates all records in one write', async () => {
+		const { sut, mediaRepository, fileUploadService } = makeSut();
+		fileUploadService.uploadFile.mockImplementation(async (_data, name) => ({
+			url: `https://s3/${name}`,
+			key: `media/${name}`,
+			bucket: 'test-bucket',
+		}));
+		mediaRepository.createMany.mockImplementation(
+			async (records) => records.map((record, i) => ({ ...record, id: `m${i}` })) as any,
+		);
+
+		const readOrder: string[] = [];
+		const result = await sut.execute({
+			uploadedBy: 'u1',
+			files,
+			readFile: async (entry) => {
+				readOrder.push(entry.name);
+				return Buffer.alloc(entry.size);
+			},
+		});
+
+		expect(readOrder).toEqual(['a.jpg', 'b.jpg', 'c.jpg']);
+		expect(mediaRepository.createMany).toHaveBeenCalledTimes(1);
+		expect(mediaRepository.createMany.mock.calls[0][0]).toHaveLength(3);
+		expect(result.results.map((r) => r.success)).toEqual([true, true, true]);
+		expect(result.results[2].media?.id).toBe('m2');
+	});
+
+	it('reports per-file failures without failing the batch', async () => {
+		const { sut, mediaRepository, fileUploadService } = makeSut();
+		fileUploadService.uploadFile.mockImplementation(async (_data, name) => {
+			if (name === 'b.jpg') {
+				throw new Error('S3 unavailable');
+			}
+			return { url: `https://s3/${name}`, key: `media/${name}`, bucket: 'test-bucket' };
+		});
+		mediaRepository.createMany.mockImplementation(
+			async (records) => records.map((record, i) => ({ ...record, id: `m${i}` })) as any,
+		);
+
+		const result = await sut.execute({
+			uploadedBy: 'u1',
+			files,
+			readFile: async (entry) => Buffer.alloc(entry.size),
+		});
+
+		expect(mediaRepository.createMany.mock.calls[0][0]).toHaveLength(2);
+		expect(result.results[0]).toMatchObject({ success: true, originalName: 'a.jpg' });
+		expect(result.results[1]).toMatchObject({ success: false, error: 'S3 unavailable' });
+		expect(result.results[2]).toMatchObject({ success: true, originalName: 'c.jpg' });
+	});
+
+	it('deletes stored files when the request body fails partway', async () => {
+		const { sut, mediaRepository, fileUploadService } = makeSut();
+		fileUploadService.uploadFile.mockImplementation(async (_data, name) => ({
+			url: `https://s3/${name}`,
+			key: `media/${name}`,
+			bucket: 'test-bucket',
+		}));
+		fileUploadService.deleteFile.mockResolvedValue(true);
+
+		await expect(
+			sut.execute({
+				uploadedBy: 'u1',
+				files,
+				readFile: async (entry) => {
+					if (entry.name === 'b.jpg') {
+						throw new Error('Request body ended early');
+					}
+					return Buffer.from(entry.name);
+				},
+			}),
+		).rejects.toThrow('Request body ended early');
+
+		expect(fileUploadService.deleteFile).toHaveBeenCalledWith('media/a.jpg');
+		expect(fileUploadService.deleteFile).toHaveBeenCalledTimes(1);
+		expect(mediaRepository.createMany).not.toHaveBeenCalled();
+	});
+
+	it('deletes stored files when the records cannot be created', async () => {
+		const { sut, mediaRepository, fileUploadService } = makeSut();
+		fileUploadService.uploadFile.mockImplementation(async (_data, name) => ({
+			url: `https://s3/${name}`,
+			key: `media/${name}`,
+			bucket: 'test-bucket',
+		}));
+		fileUploadService.deleteFile.mockResolvedValue(true);
+		mediaRepository.createMany.mockRejectedValue(new Error('Database unavailable'));
+
+		await expect(
+			sut.execute({ uploadedBy: 'u1', files, readFile: async (entry) => Buffer.from(entry.name) }),
+		).rejects.toThrow('Database unavailable');
+
+		expect(fileUploadService.deleteFile.mock.calls.map(([key]) => key).sort()).toEqual([
+			'media/a.jpg',
+			'media/b.jpg',
+			'media/c.jpg',
+		]);
+	});
+
+	it('checks the storage quota once for the whole batch', async () => {
+		const { sut, storageService, fileUploadService } = makeSut();
+		storageService.canUserUpload.mockResolvedValue({
+			canUpload: false,
+			currentUsage: 1000,
+			maxLimit: 1000,
+			remainingSpace: 0,
+			wouldExceedBy: 6,
+		});
+
+		await expect(
+			sut.execute({
+				uploadedBy: 'u1',
+				files,
+				readFile: async (entry) => Buffer.alloc(entry.size),
+			}),
+		).rejects.toThrow('Storage limit exceeded');
+		expect(storageService.canUserUpload).toHaveBeenCalledWith('u1', 6);
+		expect(fileUploadService.uploadFile).not.toHaveBeenCalled();
+	});
+});
@@ -9,6 +9,8 @@ const makeSut = () => {
 		findById: jest.fn() as any,
 		findByUserId: jest.fn() as any,
 		findByMimeType: jest.fn() as any,
+		findByContentHash: jest.fn() as any,
+		createMany: jest.fn() as any,
 		update: jest.fn() as any,
 		delete: jest.fn() as any,
 		search: jest.fn() as any,
@@ -16,6 +18,7 @@ const makeSut = () => {
 	};
 	const fileUploadService: jest.Mocked<IFileUploadService> = {
 		uploadFile: jest.fn(),
+		uploadFileFromPath: jest.fn() as any,
 		deleteFile: jest.fn() as any,
 		getSignedUrl: jest.fn() as any,
 	};
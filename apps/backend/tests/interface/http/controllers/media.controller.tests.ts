@@ -3,6 +3,9 @@ import { UploadMediaUseCase } from '../../../../src/application/use-cases/upload
 import { GetUserMediaUseCase } from '../../../../src/application/use-cases/get-user-media.usecase';
 import { GetMediaByIdUseCase } from '../../../../src/application/use-cases/get-media-by-id.usecase';
 import { DeleteMediaUseCase } from '../../../../src/application/use-cases/delete-media.usecase';
+import { FindDuplicateMediaUseCase } from '../../../../src/application/use-cases/find-duplicate-media.usecase';
+import { UploadMediaBatchUseCase } from '../../../../src/application/use-cases/upload-media-batch.usecase';
+import { AttachThumbnailsUseCase } from '../../../../src/application/use-cases/attach-thumbnails.usecase';
 import { ILoggingService } from '../../../../src/domain/services/ilogging.service';
 
 describe('MediaController', () => {
@@ -23,6 +26,18 @@ describe('MediaController', () => {
 			execute: jest.fn(),
 		} as any;
 
+		const findDuplicateMediaUseCase: jest.Mocked<FindDuplicateMediaUseCase> = {
+			execute: jest.fn(),
+		} as any;
+
+		const uploadMediaBatchUseCase: jest.Mocked<UploadMediaBatchUseCase> = {
+			execute: jest.fn(),
+		} as any;
+
+		const attachThumbnailsUseCase: jest.Mocked<AttachThumbnailsUseCase> = {
+			execute: jest.fn(),
+		} as any;
+
 		const loggingService: jest.Mocked<ILoggingService> = {
 			debug: jest.fn() as any,
 			info: jest.fn(),
@@ -36,6 +51,9 @@ describe('MediaController', () => {
 			getUserMediaUseCase,
 			getMediaByIdUseCase,
 			deleteMediaUseCase,
+			findDuplicateMediaUseCase,
+			uploadMediaBatchUseCase,
+			attachThumbnailsUseCase,
 			loggingService
 		);
 
@@ -45,6 +63,9 @@ describe('MediaController', () => {
 			getUserMediaUseCase,
 			getMediaByIdUseCase,
 			deleteMediaUseCase,
+			findDuplicateMediaUseCase,
+			uploadMediaBatchUseCase,
+			attachThumbnailsUseCase,
 			loggingService,
 		};
 	};
@@ -102,6 +123,75 @@ describe('MediaController', () => {
 		});
 	});
 
+	it('stores the duration the client read from the file', async () => {
+		const { sut, uploadMediaUseCase } = makeSut();
+		uploadMediaUseCase.execute.mockResolvedValue({
+			media: {
+				id: 'media123',
+				title: 'Test Video',
+				duration: 12.5,
+				getFileSizeInMB: () => 0.001,
+			} as any,
+			uploadUrl: 'https://s3.example.com/test.mp4',
+		});
+
+		const req = {
+			file: {
+				buffer: Buffer.from('test'),
+				originalname: 'test.mp4',
+				mimetype: 'video/mp4',
+				size: 1024,
+			},
+			// Multipart form fields arrive as strings
+			body: { title: 'Test Video', duration: '12.5' },
+			user: { userId: 'user123' },
+		} as any;
+
+		const res = {
+			status: jest.fn().mockReturnThis(),
+			json: jest.fn(),
+		} as any;
+
+		await sut.uploadMedia(req, res);
+
+		expect(uploadMediaUseCase.execute).toHaveBeenCalledWith(
+			expect.objectContaining({ duration: 12.5 }),
+		);
+		expect(res.status).toHaveBeenCalledWith(201);
+	});
+
+	it('attaches thumbnails the client made to its media', async () => {
+		const { sut, attachThumbnailsUseCase } = makeSut();
+		attachThumbnailsUseCase.execute.mockResolvedValue({
+			media: { id: 'media123' } as any,
+			thumbnails: ['https://s3.example.com/thumb-0.jpg'],
+		});
+
+		const thumbnail = Buffer.from([0xff, 0xd8, 0xff, 0xe0]);
+		const req = {
+			params: { id: 'media123' },
+			files: [{ buffer: thumbnail }],
+			user: { userId: 'user123' },
+		} as any;
+
+		const res = {
+			status: jest.fn().mockReturnThis(),
+			json: jest.fn(),
+		} as any;
+
+		await sut.attachThumbnails(req, res);
+
+		expect(attachThumbnailsUseCase.execute).toHaveBeenCalledWith({
+			mediaId: 'media123',
+			userId: 'user123',
+			thumbnails: [thumbnail],
+		});
+		expect(res.json).toHaveBeenCalledWith({
+			success: true,
+			thumbnails: ['https://s3.example.com/thumb-0.jpg'],
+		});
+	});
+
 	it('gets user media with pagination', async () => {
 		const { sut, getUserMediaUseCase } = makeSut();
 		const mockResult = { media: [], total: 0, hasMore: false };
@@ -165,4 +255,62 @@ describe('MediaController', () => {
 			message: 'Media deleted successfully',
 		});
 	});
+
+	it('reports an existing upload with the same content hash', async () => {
+		const { sut, findDuplicateMediaUseCase } = makeSut();
+		const contentHash = 'a'.repeat(64);
+		findDuplicateMediaUseCase.execute.mockResolvedValue({
+			exists: true,
+			media: {
+				id: 'media123',
+				title: 'Test Video',
+				originalName: 'test.mp4',
+				mimeType: 'video/mp4',
+				size: 1024,
+				url: 'https://s3.example.com/test.mp4',
+				createdAt: new Date(),
+			} as any,
+		});
+
+		const req = {
+			body: { contentHash, fileSize: 1024 },
+			user: { userId: 'user123' },
+			requestId: 'req123',
+		} as any;
+
+		const res = {
+			status: jest.fn().mockReturnThis(),
+			json: jest.fn(),
+		} as any;
+
+		await sut.checkDuplicate(req, res);
+
+		expect(findDuplicateMediaUseCase.execute).toHaveBeenCalledWith({
+			userId: 'user123',
+			contentHash,
+			fileSize: 1024,
+		});
+		expect(res.json).toHaveBeenCalledWith(
+			expect.objectContaining({ success: true, exists: true }),
+		);
+	});
+
+	it('rejects a malformed content hash', async () => {
+		const { sut, findDuplicateMediaUseCase } = makeSut();
+
+		const req = {
+			body: { contentHash: 'not-a-hash', fileSize: 1024 },
+			user: { userId: 'user123' },
+		} as any;
+
+		const res = {
+			status: jest.fn().mockReturnThis(),
+			json: jest.fn(),
+		} as any;
+
+		await sut.checkDuplicate(req, res);
+
+		expect(res.status).toHaveBeenCalledWith(400);
+		expect(findDuplicateMediaUseCase.execute).not.toHaveBeenCalled();
+	});
 });
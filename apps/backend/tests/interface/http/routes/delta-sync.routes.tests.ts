@@ -0,0 +1,317 @@
+import { createHash } from 'crypto';
+import express from 'express';
+import { mkdtempSync, readFileSync, rmSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import request from 'supertest';
+import { CommitDeltaUploadUseCase } from '../../../../src/application/use-cases/commit-delta-upload.usecase';
+import { DeleteMediaUseCase } from '../../../../src/application/use-cases/delete-media.usecase';
+import { FindMissingChunksUseCase } from '../../../../src/application/use-cases/find-missing-chunks.usecase';
+import { StoreDeltaChunkUseCase } from '../../../../src/application/use-cases/store-delta-chunk.usecase';
+import { ILoggingService } from '../../../../src/domain/services/ilogging.service';
+import { LocalChunkStore } from '../../../../src/infrastructure/services/local-chunk-store.service';
+import { UploadStagingService } from '../../../../src/infrastructure/services/upload-staging.service';
+import { DeltaSyncController } from '../../../../src/interface/http/controllers/delta-sync.controller';
+import { MediaController } from '../../../../src/interface/http/controllers/media.controller';
+import { createMediaRoutes } from '../../../../src/interface/http/routes/media.routes';
+
+const sha256 = (data: Buffer) => createHash('sha256').update(data).digest('hex');
+
+// Splits content at fixed offsets; the server does not care how the client
+// chose its chunk boundaries
+const chunksOf = (content: Buffer, sizes: number[]) => {
+	let offset = 0;
+	return sizes.map((size) => {
+		const data = content.subarray(offset, offset + size);
+		offset += size;
+		return { hash: sha256(data), size, data };
+	});
+};
+
+describe('Delta sync routes', () => {
+	let stagingDir: string;
+	let chunkDir: string;
+
+	const makeSut = ({ storageLimit = 1024 * 1024 }: { storageLimit?: number } = {}) => {
+		const chunkStore = new LocalChunkStore(chunkDir);
+		const stagingService = new UploadStagingService(stagingDir);
+		const loggingService: jest.Mocked<ILoggingService> = {
+			debug: jest.fn() as any,
+			info: jest.fn() as any,
+			warn: jest.fn() as any,
+			error: jest.fn() as any,
+			fatal: jest.fn() as any,
+		};
+		const storageService = {
+			canUserUpload: jest.fn().mockImplementation(async (_userId: string, fileSize: number) => ({
+				canUpload: fileSize <= storageLimit,
+				currentUsage: 0,
+				maxLimit: storageLimit,
+				remainingSpace: storageLimit,
+				wouldExceedBy: Math.max(0, fileSize - storageLimit),
+			})),
+		} as any;
+		let nextMediaId = 1;
+		const stored = new Map<string, any>();
+		const mediaRepository = {
+			create: jest.fn().mockImplementation(async (data: any) => {
+				const media = {
+					id: `media${nextMediaId++}`,
+					...data,
+					createdAt: new Date(),
+					getFileSizeInMB: () => data.size / (1024 * 1024),
+				};
+				stored.set(media.id, media);
+				return media;
+			}),
+			findById: jest.fn().mockImplementation(async (id: string) => stored.get(id) || null),
+			delete: jest.fn().mockImplementation(async (id: string) => stored.delete(id)),
+		} as any;
+		let uploadedContent = Buffer.alloc(0);
+		const fileUploadService = {
+			uploadFileFromPath: jest.fn().mockImplementation(async (filePath: string) => {
+				uploadedContent = readFileSync(filePath);
+				return { url: 'https://s3/clip.mp4', key: 'media/clip.mp4', bucket: 'test-bucket' };
+			}),
+			deleteFile: jest.fn().mockResolvedValue(undefined),
+		} as any;
+		const thumbnailService = { generateThumbnailsFromPath: jest.fn().mockResolvedValue([]) } as any;
+		const authService = {
+			verifyAccessToken: jest.fn().mockReturnValue({ userId: 'user1', username: 'tester' }),
+		} as any;
+		// Only deletes go through it here
+		const mediaController = new MediaController(
+			{} as any,
+			{} as any,
+			{} as any,
+			new DeleteMediaUseCase(mediaRepository, fileUploadService, loggingService, chunkStore),
+			{} as any,
+			{} as any,
+			{} as any,
+			loggingService,
+		);
+		const uploadSessionController = {
+			createSession: jest.fn(),
+			getSession: jest.fn(),
+			appendChunk: jest.fn(),
+			completeSession: jest.fn(),
+			abortSession: jest.fn(),
+			presignParts: jest.fn(),
+		} as any;
+
+		const controller = new DeltaSyncController(
+			new FindMissingChunksUseCase(chunkStore, loggingService),
+			new StoreDeltaChunkUseCase(chunkStore, storageService, loggingService),
+			new CommitDeltaUploadUseCase(
+				chunkStore,
+				stagingService,
+				mediaRepository,
+				fileUploadService,
+				thumbnailService,
+				storageService,
+				loggingService,
+			),
+			loggingService,
+		);
+
+		const app = express();
+		app.use(express.json());
+		app.use(
+			'/api/v1/media',
+			createMediaRoutes(mediaController, authService, uploadSessionController, controller),
+		);
+
+		return {
+			app,
+			chunkStore,
+			mediaRepository,
+			fileUploadService,
+			getUploadedContent: () => uploadedContent,
+		};
+	};
+
+	const put = (app: express.Express, chunk: { hash: string; data: Buffer }) =>
+		request(app)
+			.put(`/api/v1/media/delta/chunks/${chunk.hash}`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.send(chunk.data);
+
+	const sendMissing = async (
+		app: express.Express,
+		chunks: { hash: string; size: number; data: Buffer }[],
+	) => {
+		const checked = await request(app)
+			.post('/api/v1/media/delta/chunks/check')
+			.set('Authorization', 'Bearer token')
+			.send({ hashes: chunks.map((chunk) => chunk.hash) });
+		expect(checked.status).toBe(200);
+
+		for (const hash of checked.body.missing) {
+			const chunk = chunks.find((c) => c.hash === hash)!;
+			const stored = await put(app, chunk);
+			expect(stored.status).toBe(201);
+			expect(stored.body.size).toBe(chunk.size);
+		}
+		return checked.body.missing as string[];
+	};
+
+	const commit = (app: express.Express, content: Buffer, chunks: { hash: string; size: number }[]) =>
+		request(app)
+			.post('/api/v1/media/delta')
+			.set('Authorization', 'Bearer token')
+			.send({
+				fileName: 'clip.mp4',
+				fileSize: content.length,
+				mimeType: 'video/mp4',
+				chunks: chunks.map(({ hash, size }) => ({ hash, size })),
+			});
+
+	beforeEach(() => {
+		stagingDir = mkdtempSync(join(tmpdir(), 'delta-sync-staging-'));
+		chunkDir = mkdtempSync(join(tmpdir(), 'delta-sync-chunks-'));
+	});
+
+	afterEach(() => {
+		rmSync(stagingDir, { recursive: true, force: true });
+		rmSync(chunkDir, { recursive: true, force: true });
+	});
+
+	it('rebuilds a modified file from stored chunks plus the one that changed', async () => {
+		const { app, getUploadedContent } = makeSut();
+		const original = Buffer.alloc(3000);
+		for (let i = 0; i < original.length; i++) {
+			original[i] = (i * 31) % 251;
+		}
+
+		const first = chunksOf(original, [1000, 1000, 1000]);
+		expect(await sendMissing(app, first)).toHaveLength(3);
+		const created = await commit(app, original, first);
+		expect(created.status).toBe(201);
+		expect(getUploadedContent().equals(original)).toBe(true);
+
+		// Metadata edited in the middle of the file; the chunks around it are unchanged
+		const edited = Buffer.concat([
+			original.subarray(0, 1000),
+			Buffer.from('edited metadata block'.padEnd(1200, '.')),
+			original.subarray(2000),
+		]);
+		const second = chunksOf(edited, [1000, 1200, 1000]);
+		expect(await sendMissing(app, second)).toEqual([second[1].hash]);
+
+		const updated = await commit(app, edited, second);
+		expect(updated.status).toBe(201);
+		expect(updated.body.media.size).toBe(edited.length);
+		expect(getUploadedContent().equals(edited)).toBe(true);
+	});
+
+	it('rejects a chunk whose bytes do not match its hash', async () => {
+		const { app } = makeSut();
+		const data = Buffer.from('chunk contents');
+
+		const stored = await request(app)
+			.put(`/api/v1/media/delta/chunks/${sha256(Buffer.from('something else'))}`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.send(data);
+		expect(stored.status).toBe(400);
+
+		const checked = await request(app)
+			.post('/api/v1/media/delta/chunks/check')
+			.set('Authorization', 'Bearer token')
+			.send({ hashes: [sha256(Buffer.from('something else'))] });
+		expect(checked.body.missing).toHaveLength(1);
+	});
+
+	it('refuses to commit while chunks are missing', async () => {
+		const { app, fileUploadService, mediaRepository } = makeSut();
+		const content = Buffer.from('abcdefghij'.repeat(20));
+		const chunks = chunksOf(content, [100, 100]);
+
+		await sendMissing(app, chunks.slice(0, 1));
+
+		const committed = await commit(app, content, chunks);
+		expect(committed.status).toBe(409);
+		expect(committed.body.missing).toEqual([chunks[1].hash]);
+		expect(fileUploadService.uploadFileFromPath).not.toHaveBeenCalled();
+		expect(mediaRepository.create).not.toHaveBeenCalled();
+	});
+
+	it('refuses chunk lists that do not add up to the file size', async () => {
+		const { app } = makeSut();
+		const content = Buffer.from('0123456789');
+		const chunks = chunksOf(content, [10]);
+		await sendMissing(app, chunks);
+
+		const committed = await request(app)
+			.post('/api/v1/media/delta')
+			.set('Authorization', 'Bearer token')
+			.send({
+				fileName: 'clip.mp4',
+				fileSize: 11,
+				mimeType: 'video/mp4',
+				chunks: chunks.map(({ hash, size }) => ({ hash, size })),
+			});
+		expect(committed.status).toBe(400);
+	});
+
+	it('counts chunks no commit has claimed against the user storage', async () => {
+		const { app, chunkStore } = makeSut({ storageLimit: 1500 });
+		const content = Buffer.from(Array.from({ length: 3000 }, (_value, i) => i % 199));
+		const chunks = chunksOf(content, [1000, 1000, 1000]);
+
+		expect((await put(app, chunks[0])).status).toBe(201);
+		expect((await put(app, chunks[1])).status).toBe(201);
+		expect(await chunkStore.getPendingBytes('user1')).toBe(2000);
+
+		// Uncommitted chunks already fill the allowance
+		const refused = await put(app, chunks[2]);
+		expect(refused.status).toBe(400);
+		expect(refused.body.message).toContain('Storage limit exceeded');
+	});
+
+	it('stops counting chunks once a commit lists them, and expires the rest', async () => {
+		const { app, chunkStore } = makeSut();
+		const content = Buffer.from('0123456789'.repeat(30));
+		const chunks = chunksOf(content, [100, 100, 100]);
+
+		await sendMissing(app, chunks.slice(0, 2));
+		expect((await commit(app, content.subarray(0, 200), chunks.slice(0, 2))).status).toBe(201);
+		expect(await chunkStore.getPendingBytes('user1')).toBe(0);
+
+		// Sent for a sync that never commits
+		expect((await put(app, chunks[2])).status).toBe(201);
+		expect(await chunkStore.getPendingBytes('user1')).toBe(100);
+
+		expect(await chunkStore.expirePending(0)).toBe(1);
+		expect(await chunkStore.getPendingBytes('user1')).toBe(0);
+		expect(await chunkStore.findMissing('user1', chunks.map((chunk) => chunk.hash))).toEqual([
+			chunks[2].hash,
+		]);
+	});
+
+	it('removes the chunks only a deleted media file used', async () => {
+		const { app, chunkStore } = makeSut();
+		const shared = Buffer.from('shared block '.padEnd(100, '-'));
+		const first = Buffer.concat([Buffer.from('first only '.padEnd(100, '.')), shared]);
+		const second = Buffer.concat([shared, Buffer.from('second only '.padEnd(100, '+'))]);
+		const firstChunks = chunksOf(first, [100, 100]);
+		const secondChunks = chunksOf(second, [100, 100]);
+
+		await sendMissing(app, firstChunks);
+		const created = await commit(app, first, firstChunks);
+		await sendMissing(app, secondChunks);
+		expect((await commit(app, second, secondChunks)).status).toBe(201);
+
+		const deleted = await request(app)
+			.delete(`/api/v1/media/${created.body.media.id}`)
+			.set('Authorization', 'Bearer token');
+		expect(deleted.status).toBe(200);
+
+		const hashes = [firstChunks[0].hash, firstChunks[1].hash, secondChunks[1].hash];
+		expect(await chunkStore.findMissing('user1', hashes)).toEqual([firstChunks[0].hash]);
+
+		// Nothing left for the sweep while the other file still lists its chunks
+		expect(await chunkStore.sweepUnreferenced()).toBe(0);
+	});
+});
@@ -0,0 +1,559 @@
+import express from 'express';
+import { mkdtempSync, readFileSync, rmSync } from 'fs';
+import { tmpdir } from 'os';
+import { join } from 'path';
+import request from 'supertest';
+import { deflateSync } from 'zlib';
+import { AbortUploadSessionUseCase } from '../../../../src/application/use-cases/abort-upload-session.usecase';
+import { AppendUploadChunkUseCase } from '../../../../src/application/use-cases/append-upload-chunk.usecase';
+import { CompleteUploadSessionUseCase } from '../../../../src/application/use-cases/complete-upload-session.usecase';
+import { CreateUploadSessionUseCase } from '../../../../src/application/use-cases/create-upload-session.usecase';
+import { GetUploadSessionUseCase } from '../../../../src/application/use-cases/get-upload-session.usecase';
+import { PresignUploadPartsUseCase } from '../../../../src/application/use-cases/presign-upload-parts.usecase';
+import {
+	UploadSession,
+	UploadSessionMode,
+	UploadSessionStatus,
+} from '../../../../src/domain/entities/upload-session.entity';
+import { IUploadSessionRepository } from '../../../../src/domain/repositories/iupload-session.repository';
+import {
+	IDirectUploadService,
+	UploadedPart,
+} from '../../../../src/domain/services/idirect-upload.service';
+import { ILoggingService } from '../../../../src/domain/services/ilogging.service';
+import { UploadStagingService } from '../../../../src/infrastructure/services/upload-staging.service';
+import { UploadSessionController } from '../../../../src/interface/http/controllers/upload-session.controller';
+import { createMediaRoutes } from '../../../../src/interface/http/routes/media.routes';
+
+class InMemoryUploadSessionRepository implements IUploadSessionRepository {
+	private sessions = new Map<string, UploadSession>();
+	private nextId = 1;
+
+	async create(data: {
+		userId: string;
+		fileName: string;
+		mimeType: string;
+		totalSize: number;
+		title: string;
+		description: string;
+		contentHash?: string;
+		mode?: UploadSessionMode;
+		storageKey?: string;
+		storageUploadId?: string;
+		partSize?: number;
+		expiresAt: Date;
+	}): Promise<UploadSession> {
+		const session = new UploadSession(
+			`session${this.nextId++}`,
+			data.userId,
+			data.fileName,
+			data.mimeType,
+			data.totalSize,
+			0,
+			'active',
+			data.title,
+			data.description,
+			data.expiresAt,
+			new Date(),
+			new Date(),
+			data.contentHash || '',
+			data.mode || 'staged',
+			data.storageKey || '',
+			data.storageUploadId || '',
+			data.partSize || 0,
+		);
+		this.sessions.set(session.id, session);
+		return session;
+	}
+
+	async findById(id: string): Promise<UploadSession | null> {
+		return this.sessions.get(id) || null;
+	}
+
+	async advanceOffset(id: string, expectedOffset: number, newOffset: number) {
+		const s = this.sessions.get(id);
+		if (!s || s.status !== 'active' || s.receivedBytes !== expectedOffset) {
+			return null;
+		}
+		return this.replace(s, newOffset, s.status);
+	}
+
+	async transitionStatus(id: string, from: UploadSessionStatus, to: UploadSessionStatus) {
+		const s = this.sessions.get(id);
+		return s && s.status === from ? this.replace(s, s.receivedBytes, to) : null;
+	}
+
+	async markCompleted(id: string, mediaId: string) {
+		const s = this.sessions.get(id);
+		return s ? this.replace(s, s.receivedBytes, 'completed', mediaId) : null;
+	}
+
+	async updateStatus(id: string, status: UploadSessionStatus) {
+		const s = this.sessions.get(id);
+		return s ? this.replace(s, s.receivedBytes, status) : null;
+	}
+
+	async delete(id: string): Promise<boolean> {
+		return this.sessions.delete(id);
+	}
+
+	private replace(
+		s: UploadSession,
+		receivedBytes: number,
+		status: UploadSessionStatus,
+		mediaId = s.mediaId,
+	) {
+		const updated = new UploadSession(
+			s.id,
+			s.userId,
+			s.fileName,
+			s.mimeType,
+			s.totalSize,
+			receivedBytes,
+			status,
+			s.title,
+			s.description,
+			s.expiresAt,
+			s.createdAt,
+			new Date(),
+			s.contentHash,
+			s.mode,
+			s.storageKey,
+			s.storageUploadId,
+			s.partSize,
+			mediaId,
+		);
+		this.sessions.set(s.id, updated);
+		return updated;
+	}
+}
+
+// Stand-in for an S3-compatible store: parts "arrive" through putPart(), as
+// they would from a client PUTting to the presigned URLs
+class InMemoryObjectStorage implements IDirectUploadService {
+	private uploads = new Map<string, Map<number, number>>();
+	private nextId = 1;
+	completed: UploadedPart[] = [];
+	aborted: string[] = [];
+
+	async createMultipartUpload(filename: string) {
+		const uploadId = `mpu${this.nextId++}`;
+		this.uploads.set(uploadId, new Map());
+		return { key: `uploads/media/${filename}`, uploadId };
+	}
+
+	async presignParts(key: string, uploadId: string, partNumbers: number[]) {
+		return partNumbers.map((partNumber) => ({
+			partNumber,
+			url: `http://storage.local/bucket/${key}?uploadId=${uploadId}&partNumber=${partNumber}`,
+		}));
+	}
+
+	putPart(uploadId: string, partNumber: number, size: number) {
+		this.uploads.get(uploadId)!.set(partNumber, size);
+	}
+
+	async listParts(_key: string, uploadId: string) {
+		return [...this.uploads.get(uploadId)!.entries()]
+			.sort(([a], [b]) => a - b)
+			.map(([partNumber, size]) => ({ partNumber, size, etag: `"etag${partNumber}"` }));
+	}
+
+	async completeMultipartUpload(key: string, uploadId: string, parts: UploadedPart[]) {
+		this.completed = parts;
+		this.uploads.delete(uploadId);
+		const size = parts.reduce((sum, part) => sum + part.size, 0);
+		return { url: `http://storage.local/bucket/${key}`, key, bucket: 'bucket', size };
+	}
+
+	async abortMultipartUpload(_key: string, uploadId: string) {
+		this.aborted.push(uploadId);
+		this.uploads.delete(uploadId);
+	}
+}
+
+describe('Upload session routes', () => {
+	let stagingDir: string;
+
+	const makeSut = ({ direct = true }: { direct?: boolean } = {}) => {
+		const objectStorage = new InMemoryObjectStorage();
+		const directUploadService = direct ? objectStorage : undefined;
+		const uploadSessionRepository = new InMemoryUploadSessionRepository();
+		const stagingService = new UploadStagingService(stagingDir);
+		const loggingService: jest.Mocked<ILoggingService> = {
+			debug: jest.fn() as any,
+			info: jest.fn() as any,
+			warn: jest.fn() as any,
+			error: jest.fn() as any,
+			fatal: jest.fn() as any,
+		};
+		const storageService = {
+			canUserUpload: jest.fn().mockResolvedValue({
+				canUpload: true,
+				currentUsage: 0,
+				maxLimit: 1024 * 1024,
+				remainingSpace: 1024 * 1024,
+			}),
+		} as any;
+		const created = new Map<string, any>();
+		const mediaRepository = {
+			create: jest.fn().mockImplementation(async (data: any) => {
+				const media = {
+					id: `media${created.size + 1}`,
+					...data,
+					createdAt: new Date(),
+					getFileSizeInMB: () => data.size / (1024 * 1024),
+				};
+				created.set(media.id, media);
+				return media;
+			}),
+			findById: jest.fn().mockImplementation(async (id: string) => created.get(id) || null),
+		} as any;
+		let uploadedContent = '';
+		const fileUploadService = {
+			uploadFileFromPath: jest.fn().mockImplementation(async (filePath: string) => {
+				uploadedContent = readFileSync(filePath, 'utf8');
+				return { url: 'https://s3/photo.png', key: 'media/photo.png', bucket: 'test-bucket' };
+			}),
+		} as any;
+		const thumbnailService = { generateThumbnailsFromPath: jest.fn() } as any;
+		const authService = {
+			verifyAccessToken: jest.fn().mockReturnValue({ userId: 'user1', username: 'tester' }),
+		} as any;
+		const mediaController = {
+			uploadMedia: jest.fn(),
+			getUserMedia: jest.fn(),
+			getMediaById: jest.fn(),
+			deleteMedia: jest.fn(),
+			checkDuplicate: jest.fn(),
+			uploadBatch: jest.fn(),
+			attachThumbnails: jest.fn(),
+		} as any;
+
+		const controller = new UploadSessionController(
+			new CreateUploadSessionUseCase(
+				uploadSessionRepository,
+				storageService,
+				loggingService,
+				directUploadService,
+			),
+			new GetUploadSessionUseCase(uploadSessionRepository, loggingService, objectStorage),
+			new AppendUploadChunkUseCase(uploadSessionRepository, stagingService, loggingService),
+			new CompleteUploadSessionUseCase(
+				uploadSessionRepository,
+				stagingService,
+				mediaRepository,
+				fileUploadService,
+				thumbnailService,
+				storageService,
+				loggingService,
+				objectStorage,
+			),
+			new AbortUploadSessionUseCase(
+				uploadSessionRepository,
+				stagingService,
+				loggingService,
+				objectStorage,
+			),
+			new PresignUploadPartsUseCase(uploadSessionRepository, objectStorage, loggingService),
+			loggingService,
+		);
+
+		const app = express();
+		app.use(express.json());
+		app.use('/api/v1/media', createMediaRoutes(mediaController, authService, controller));
+
+		return {
+			app,
+			mediaRepository,
+			fileUploadService,
+			objectStorage,
+			getUploadedContent: () => uploadedContent,
+		};
+	};
+
+	beforeEach(() => {
+		stagingDir = mkdtempSync(join(tmpdir(), 'upload-session-tests-'));
+	});
+
+	afterEach(() => {
+		rmSync(stagingDir, { recursive: true, force: true });
+	});
+
+	it('resumes an interrupted upload from the acknowledged offset', async () => {
+		const { app, mediaRepository, getUploadedContent } = makeSut();
+		const content = 'hello resumable world';
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({ fileName: 'photo.png', fileSize: content.length, mimeType: 'image/png' });
+		expect(created.status).toBe(201);
+		const sessionId = created.body.session.id;
+
+		const first = await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Upload-Offset', '0')
+			.send(Buffer.from(content.slice(0, 6)));
+		expect(first.status).toBe(200);
+		expect(first.body.receivedBytes).toBe(6);
+
+		// Client lost track of progress and asks the server where to continue
+		const status = await request(app)
+			.get(`/api/v1/media/uploads/${sessionId}`)
+			.set('Authorization', 'Bearer token');
+		expect(status.body.session.receivedBytes).toBe(6);
+
+		const stale = await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Upload-Offset', '0')
+			.send(Buffer.from(content));
+		expect(stale.status).toBe(409);
+		expect(stale.body.receivedBytes).toBe(6);
+
+		const rest = await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Upload-Offset', '6')
+			.send(Buffer.from(content.slice(6)));
+		expect(rest.status).toBe(200);
+		expect(rest.body.receivedBytes).toBe(content.length);
+
+		const completed = await request(app)
+			.post(`/api/v1/media/uploads/${sessionId}/complete`)
+			.set('Authorization', 'Bearer token')
+			.send({});
+		expect(completed.status).toBe(201);
+		expect(completed.body.media.id).toBe('media1');
+		expect(getUploadedContent()).toBe(content);
+		expect(mediaRepository.create).toHaveBeenCalledWith(
+			expect.objectContaining({ originalName: 'photo.png', size: content.length }),
+		);
+	});
+
+	it('inflates deflate-encoded chunks before staging them', async () => {
+		const { app, getUploadedContent } = makeSut();
+		const content = 'RIFF'.padEnd(4096, '\0') + 'tail';
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({ fileName: 'sound.wav', fileSize: content.length, mimeType: 'audio/wav' });
+		const sessionId = created.body.session.id;
+
+		const chunk = await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Content-Encoding', 'deflate')
+			.set('Upload-Offset', '0')
+			.send(deflateSync(Buffer.from(content)));
+		expect(chunk.status).toBe(200);
+		expect(chunk.body.receivedBytes).toBe(content.length);
+
+		const completed = await request(app)
+			.post(`/api/v1/media/uploads/${sessionId}/complete`)
+			.set('Authorization', 'Bearer token')
+			.send({});
+		expect(completed.status).toBe(201);
+		expect(getUploadedContent()).toBe(content);
+	});
+
+	it('rejects chunks that do not decode', async () => {
+		const { app } = makeSut();
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({ fileName: 'sound.wav', fileSize: 10, mimeType: 'audio/wav' });
+		const sessionId = created.body.session.id;
+
+		const corrupt = await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Content-Encoding', 'deflate')
+			.set('Upload-Offset', '0')
+			.send(Buffer.from('not deflate'));
+		expect(corrupt.status).toBe(400);
+
+		const unknown = await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Content-Encoding', 'br')
+			.set('Upload-Offset', '0')
+			.send(Buffer.from('0123456789'));
+		expect(unknown.status).toBe(415);
+	});
+
+	it('refuses to complete an upload that is missing bytes', async () => {
+		const { app, fileUploadService } = makeSut();
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({ fileName: 'photo.png', fileSize: 10, mimeType: 'image/png' });
+		const sessionId = created.body.session.id;
+
+		const completed = await request(app)
+			.post(`/api/v1/media/uploads/${sessionId}/complete`)
+			.set('Authorization', 'Bearer token')
+			.send({});
+		expect(completed.status).toBe(409);
+		expect(completed.body.receivedBytes).toBe(0);
+		expect(fileUploadService.uploadFileFromPath).not.toHaveBeenCalled();
+	});
+
+	it('completes a session once however often complete is sent', async () => {
+		const { app, mediaRepository, fileUploadService } = makeSut();
+		const content = 'complete me once';
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({ fileName: 'photo.png', fileSize: content.length, mimeType: 'image/png' });
+		const sessionId = created.body.session.id;
+		await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Upload-Offset', '0')
+			.send(Buffer.from(content));
+
+		const complete = () =>
+			request(app)
+				.post(`/api/v1/media/uploads/${sessionId}/complete`)
+				.set('Authorization', 'Bearer token')
+				.send({});
+
+		// The first complete is held in the copy while a second one comes in
+		let entered!: () => void;
+		const inCopy = new Promise<void>((resolve) => (entered = resolve));
+		let release!: () => void;
+		const copied = new Promise<void>((resolve) => (release = resolve));
+		fileUploadService.uploadFileFromPath.mockImplementationOnce(async () => {
+			entered();
+			await copied;
+			return { url: 'https://s3/photo.png', key: 'media/photo.png', bucket: 'test-bucket' };
+		});
+
+		const first = complete().then((res) => res);
+		await inCopy;
+		const second = await complete();
+		expect(second.status).toBe(409);
+		release();
+		expect((await first).status).toBe(201);
+
+		// Sent again once done: the media already made, not a second copy
+		const retried = await complete();
+		expect(retried.status).toBe(201);
+		expect(retried.body.media.id).toBe('media1');
+		expect(fileUploadService.uploadFileFromPath).toHaveBeenCalledTimes(1);
+		expect(mediaRepository.create).toHaveBeenCalledTimes(1);
+	});
+
+	it('sends parts of a direct upload to storage and completes from what storage holds', async () => {
+		const { app, mediaRepository, fileUploadService, objectStorage } = makeSut();
+		const MB = 1024 * 1024;
+		const fileSize = 11 * MB;
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({
+				fileName: 'movie.mp4',
+				fileSize,
+				mimeType: 'video/mp4',
+				mode: 'direct',
+				partSize: 5 * MB,
+			});
+		expect(created.status).toBe(201);
+		expect(created.body.session).toEqual(
+			expect.objectContaining({ mode: 'direct', partSize: 5 * MB, partCount: 3 }),
+		);
+		const sessionId = created.body.session.id;
+
+		const signed = await request(app)
+			.post(`/api/v1/media/uploads/${sessionId}/parts`)
+			.set('Authorization', 'Bearer token')
+			.send({ partNumbers: [1, 2, 3] });
+		expect(signed.status).toBe(200);
+		expect(signed.body.parts).toHaveLength(3);
+		expect(signed.body.parts[0].url).toContain('partNumber=1');
+
+		const outOfRange = await request(app)
+			.post(`/api/v1/media/uploads/${sessionId}/parts`)
+			.set('Authorization', 'Bearer token')
+			.send({ partNumbers: [4] });
+		expect(outOfRange.status).toBe(400);
+
+		// Chunks of a direct session are never accepted by the server itself
+		const chunk = await request(app)
+			.put(`/api/v1/media/uploads/${sessionId}/chunks`)
+			.set('Authorization', 'Bearer token')
+			.set('Content-Type', 'application/octet-stream')
+			.set('Upload-Offset', '0')
+			.send(Buffer.from('data'));
+		expect(chunk.status).toBe(400);
+
+		objectStorage.putPart('mpu1', 1, 5 * MB);
+		objectStorage.putPart('mpu1', 3, 1 * MB);
+
+		const early = await request(app)
+			.post(`/api/v1/media/uploads/${sessionId}/complete`)
+			.set('Authorization', 'Bearer token')
+			.send({});
+		expect(early.status).toBe(409);
+		expect(early.body.receivedBytes).toBe(6 * MB);
+
+		const status = await request(app)
+			.get(`/api/v1/media/uploads/${sessionId}`)
+			.set('Authorization', 'Bearer token');
+		expect(status.body.session.uploadedParts.map((p: any) => p.partNumber)).toEqual([1, 3]);
+
+		objectStorage.putPart('mpu1', 2, 5 * MB);
+
+		const completed = await request(app)
+			.post(`/api/v1/media/uploads/${sessionId}/complete`)
+			.set('Authorization', 'Bearer token')
+			.send({});
+		expect(completed.status).toBe(201);
+		expect(objectStorage.completed.map((p) => p.partNumber)).toEqual([1, 2, 3]);
+		expect(fileUploadService.uploadFileFromPath).not.toHaveBeenCalled();
+		expect(mediaRepository.create).toHaveBeenCalledWith(
+			expect.objectContaining({ originalName: 'movie.mp4', size: fileSize, thumbnails: [] }),
+		);
+	});
+
+	it('aborts the storage upload when a direct session is aborted', async () => {
+		const { app, objectStorage } = makeSut();
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({ fileName: 'movie.mp4', fileSize: 1024, mimeType: 'video/mp4', mode: 'direct' });
+		const sessionId = created.body.session.id;
+
+		const aborted = await request(app)
+			.delete(`/api/v1/media/uploads/${sessionId}`)
+			.set('Authorization', 'Bearer token');
+		expect(aborted.status).toBe(200);
+		expect(objectStorage.aborted).toEqual(['mpu1']);
+	});
+
+	it('answers 501 for direct sessions when the server has no direct storage', async () => {
+		const { app } = makeSut({ direct: false });
+
+		const created = await request(app)
+			.post('/api/v1/media/uploads')
+			.set('Authorization', 'Bearer token')
+			.send({ fileName: 'movie.mp4', fileSize: 1024, mimeType: 'video/mp4', mode: 'direct' });
+		expect(created.status).toBe(501);
+	});
+});
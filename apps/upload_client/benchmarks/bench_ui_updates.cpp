@@ -0,0 +1,143 @@
+// Event-loop latency while many transfers report progress at once.
+//
+// Every tick, each of N items gets a progress change, the way uploadProgress
+// fires for N concurrent transfers. The changes reach a sink that stands in
+// for the GUI either as one queued call per change (how UploadManager and
+// FolderSync used to notify) or through UpdateCoalescer. Meanwhile a probe
+// timer measures how late the event loop runs it, which is the delay every
+// other event (network I/O, input, painting) sees as well.
+//
+// Usage: bench_ui_updates [items=10000] [seconds=3] [repaintUs=5]
+// repaintUs is the cost the sink pays per notification, modelling the view
+// refresh a dataChanged() triggers.
+
+#include "updatecoalescer.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+
+struct Result {
+    double meanUs;
+    qint64 p99Us;
+    qint64 maxUs;
+    qint64 updates;
+    qint64 notifications;
+};
+
+static void spin(qint64 micros)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.nsecsElapsed() < micros * 1000) {
+    }
+}
+
+static Result run(bool coalesced, int items, int seconds, int repaintUs)
+{
+    const int tickInterval = 10; // ms between progress ticks of every transfer
+    const int probeInterval = 5; // ms
+
+    QObject sink;
+    QVector<int> rows(items, 0);
+    qint64 updates = 0;
+    qint64 notifications = 0;
+
+    UpdateCoalescer coalescer;
+    QObject::connect(&coalescer, &UpdateCoalescer::batchReady, &sink, [&](const ItemUpdateBatch &batch) {
+        for (const ItemUpdate &update : batch.items) {
+            rows[update.key] = update.progress;
+        }
+        notifications++;
+        spin(repaintUs);
+    });
+
+    int progress = 0;
+    QTimer producer;
+    producer.setTimerType(Qt::PreciseTimer);
+    producer.setInterval(tickInterval);
+    QObject::connect(&producer, &QTimer::timeout, [&]() {
+        progress = (progress + 1) % 100;
+        for (int i = 0; i < items; ++i) {
+            updates++;
+            if (coalesced) {
+                coalescer.setProgress(i, progress);
+            } else {
+                int value = progress;
+                QMetaObject::invokeMethod(&sink, [&, i, value]() {
+                    rows[i] = value;
+                    notifications++;
+                    spin(repaintUs);
+                }, Qt::QueuedConnection);
+            }
+        }
+    });
+
+    QVector<qint64> latencies;
+    QElapsedTimer clock;
+    qint64 expected = 0;
+    QTimer probe;
+    probe.setTimerType(Qt::PreciseTimer);
+    probe.setInterval(probeInterval);
+    QObject::connect(&probe, &QTimer::timeout, [&]() {
+        qint64 now = clock.nsecsElapsed() / 1000;
+        latencies.append(qMax<qint64>(0, now - expected));
+        expected = now + probeInterval * 1000;
+    });
+
+    QTimer stop;
+    stop.setSingleShot(true);
+    QObject::connect(&stop, &QTimer::timeout, QCoreApplication::instance(), &QCoreApplication::quit);
+
+    clock.start();
+    expected = probeInterval * 1000;
+    producer.start();
+    probe.start();
+    stop.start(seconds * 1000);
+    QCoreApplication::exec();
+
+    producer.stop();
+    probe.stop();
+    coalescer.reset();
+    // Drain queued calls that would otherwise reference this stack frame
+    QCoreApplication::removePostedEvents(&sink);
+
+    Result result = {0, 0, 0, updates, notifications};
+    if (!latencies.isEmpty()) {
+        std::sort(latencies.begin(), latencies.end());
+        qint64 sum = 0;
+        for (qint64 latency : latencies) {
+            sum += latency;
+        }
+        result.meanUs = static_cast<double>(sum) / latencies.size();
+        result.p99Us = latencies.at(qMin<int>(latencies.size() - 1, latencies.size() * 99 / 100));
+        result.maxUs = latencies.last();
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    int items = args.size() > 1 ? args.at(1).toInt() : 10000;
+    int seconds = args.size() > 2 ? args.at(2).toInt() : 3;
+    int repaintUs = args.size() > 3 ? args.at(3).toInt() : 5;
+
+    std::printf("%d items, progress tick every 10 ms, %d us per notification, %d s per run\n\n",
+                items, repaintUs, seconds);
+    std::printf("%-12s %12s %12s %12s %14s %14s\n",
+                "mode", "mean (us)", "p99 (us)", "max (us)", "updates", "notifications");
+
+    const bool modes[] = {false, true};
+    for (bool coalesced : modes) {
+        Result r = run(coalesced, items, seconds, repaintUs);
+        std::printf("%-12s %12.0f %12lld %12lld %14lld %14lld\n",
+                    coalesced ? "coalesced" : "per-change", r.meanUs,
+                    static_cast<long long>(r.p99Us), static_cast<long long>(r.maxUs),
+                    static_cast<long long>(r.updates), static_cast<long long>(r.notifications));
+    }
+    return 0;
+}
@@ -0,0 +1,611 @@
+// End-to-end upload throughput against an in-process mock server.
+//
+// UploadManager (or FolderSync) runs headlessly with its normal settings
+// and sends to a QTcpServer on 127.0.0.1, on its own thread, that speaks
+// just enough of the backend API to accept single uploads, batches and
+// resumable sessions. It reads request bodies and throws them away, so
+// what is measured is the client: hashing, scheduling, streaming from disk
+// and the HTTP stack.
+//
+// Scenarios:
+//   huge   one file of --huge-mb MB, sent through a resumable session
+//   tiny   --tiny-count files of --tiny-bytes bytes each, mostly batched
+//   mixed  2 x 256 MB, 100 x 4 MB and 5000 x 16 KB files
+//   sync   FolderSync over a folder of 1000 x 256 KB files
+//
+// Every scenario runs in a child process of its own, so peak RSS is that
+// scenario's. Per scenario it reports MB/s over the whole run, per-file
+// latency percentiles (first status change after queueing -> completed,
+// at the 5 ms resolution of the coalesced status updates), peak RSS, the
+// peak of MemoryBudget (file data the client chose to hold) and
+// client CPU seconds per GB sent (the mock server's own CPU is excluded
+// where the platform can measure it per thread, i.e. Linux).
+//
+// The results are printed as one JSON document on stdout, or written to
+// --output; a readable table goes to stderr.
+//
+// Usage: bench_upload_throughput [--scenario huge|tiny|mixed|sync]...
+//        [--huge-mb 1024] [--tiny-count 100000] [--tiny-bytes 1024]
+//        [--latency 0] [--output results.json]
+
+#include "uploadmanager.h"
+#include "foldersync.h"
+#include "memorybudget.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <QtEndian>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+struct FileSet {
+    int count;
+    qint64 size;
+};
+
+struct Scenario {
+    QString name;
+    QList<FileSet> files;
+    bool folderSync;
+};
+
+struct Usage {
+    double cpuSeconds; // user + system, -1 if unknown
+    double peakRssMb; // -1 if unknown
+};
+
+static Usage processUsage()
+{
+    Usage usage = {-1, -1};
+#ifdef Q_OS_UNIX
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.cpuSeconds = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+                           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#ifdef Q_OS_MACOS
+        usage.peakRssMb = ru.ru_maxrss / (1024.0 * 1024.0); // bytes
+#else
+        usage.peakRssMb = ru.ru_maxrss / 1024.0; // kilobytes
+#endif
+    }
+#endif
+    return usage;
+}
+
+// CPU seconds of the calling thread, -1 where that is not available
+static double threadCpuSeconds()
+{
+#if defined(Q_OS_LINUX) && defined(RUSAGE_THREAD)
+    struct rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) {
+        return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+               (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+    }
+#endif
+    return -1;
+}
+
+// Just enough of /api/v1/media to keep the client busy. Lives entirely on
+// the thread it is created on.
+class MockServer
+{
+public:
+    struct Stats {
+        qint64 requests;
+        qint64 files;
+        qint64 bodyBytes;
+    };
+
+    explicit MockServer(int latencyMs)
+        : m_latencyMs(latencyMs), m_nextSession(1), m_stats{0, 0, 0}
+    {
+        QObject::connect(&m_server, &QTcpServer::newConnection, [this]() {
+            while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+                accept(socket);
+            }
+        });
+    }
+
+    bool listen() { return m_server.listen(QHostAddress::LocalHost, 0); }
+    quint16 port() const { return m_server.serverPort(); }
+    Stats stats() const { return m_stats; }
+
+private:
+    struct Session {
+        qint64 total;
+        qint64 received;
+    };
+
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QHash<QByteArray, QByteArray> headers; // lower-case names
+        QByteArray body; // first MAX_KEPT_BODY bytes
+        qint64 remaining;
+        bool inBody;
+
+        Request() : remaining(0), inBody(false) {}
+    };
+
+    static const qint64 MAX_KEPT_BODY = 1024 * 1024; // batch manifests, JSON bodies
+
+    void accept(QTcpSocket *socket)
+    {
+        auto request = std::make_shared<Request>();
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, request]() {
+            read(socket, *request);
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+
+    void read(QTcpSocket *socket, Request &request)
+    {
+        for (;;) {
+            if (request.inBody) {
+                QByteArray data = socket->read(qMin<qint64>(request.remaining, 256 * 1024));
+                if (data.isEmpty()) {
+                    return;
+                }
+                request.remaining -= data.size();
+                m_stats.bodyBytes += data.size();
+                if (request.body.size() < MAX_KEPT_BODY) {
+                    request.body += data.left(MAX_KEPT_BODY - request.body.size());
+                }
+                if (request.remaining == 0) {
+                    respond(socket, request);
+                    request = Request();
+                }
+                continue;
+            }
+
+            if (!socket->canReadLine()) {
+                return;
+            }
+            QByteArray line = socket->readLine().trimmed();
+            if (line.isEmpty()) {
+                if (request.method.isEmpty()) {
+                    continue; // stray CRLF between requests
+                }
+                request.remaining = request.headers.value("content-length").toLongLong();
+                if (request.remaining > 0) {
+                    request.inBody = true;
+                } else {
+                    respond(socket, request);
+                    request = Request();
+                }
+            } else if (request.method.isEmpty()) {
+                QList<QByteArray> parts = line.split(' ');
+                request.method = parts.value(0);
+                request.path = parts.value(1).split('?').value(0);
+            } else {
+                int colon = line.indexOf(':');
+                if (colon > 0) {
+                    request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+                }
+            }
+        }
+    }
+
+    void respond(QTcpSocket *socket, const Request &request)
+    {
+        m_stats.requests++;
+        int status = 404;
+        QJsonObject body;
+        body["success"] = true;
+
+        const QList<QByteArray> path = request.path.split('/'); // "", api, v1, media, ...
+        QByteArray resource = path.value(4);
+        QString sessionId = QString::fromLatin1(path.value(5));
+        QByteArray action = path.value(6);
+
+        if (request.method == "POST" && resource == "upload") {
+            m_stats.files++;
+            status = 201;
+        } else if (request.method == "POST" && resource == "upload-batch") {
+            // [uint32 big-endian manifest length][manifest JSON][files]
+            quint32 length = request.body.size() >= 4 ? qFromBigEndian<quint32>(request.body.constData()) : 0;
+            QJsonArray files = QJsonDocument::fromJson(request.body.mid(4, length)).object()
+                                   .value("files").toArray();
+            QJsonArray results;
+            for (int i = 0; i < files.size(); ++i) {
+                results.append(QJsonObject{{"index", i}, {"success", true}});
+            }
+            m_stats.files += files.size();
+            body["results"] = results;
+            status = 201;
+        } else if (request.method == "POST" && resource == "dedupe-check") {
+            body["exists"] = false;
+            status = 200;
+        } else if (request.method == "POST" && resource == "create-directory") {
+            status = 201;
+        } else if (resource == "uploads" && sessionId.isEmpty() && request.method == "POST") {
+            QString id = QString::number(m_nextSession++);
+            m_sessions.insert(id, Session{QJsonDocument::fromJson(request.body).object()
+                                              .value("fileSize").toVariant().toLongLong(), 0});
+            body["session"] = sessionJson(id);
+            status = 201;
+        } else if (resource == "uploads" && m_sessions.contains(sessionId)) {
+            Session &session = m_sessions[sessionId];
+            if (request.method == "GET" && action.isEmpty()) {
+                status = 200;
+            } else if (request.method == "PUT" && action == "chunks") {
+                qint64 offset = request.headers.value("upload-offset").toLongLong();
+                if (offset == session.received) {
+                    session.received += request.headers.value("content-length").toLongLong();
+                    status = 200;
+                } else {
+                    body["success"] = false;
+                    status = 409;
+                }
+                body["receivedBytes"] = session.received;
+            } else if (request.method == "POST" && action == "complete") {
+                if (session.received == session.total) {
+                    m_stats.files++;
+                    m_sessions.remove(sessionId);
+                    status = 201;
+                } else {
+                    body["success"] = false;
+                    body["receivedBytes"] = session.received;
+                    status = 409;
+                }
+            }
+            if (status == 200 && m_sessions.contains(sessionId)) {
+                body["session"] = sessionJson(sessionId);
+            }
+        }
+
+        if (status == 404) {
+            body["success"] = false;
+        }
+        QByteArray payload = QJsonDocument(body).toJson(QJsonDocument::Compact);
+        QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " \r\n"
+                              "Content-Type: application/json\r\n"
+                              "Content-Length: " + QByteArray::number(payload.size()) + "\r\n"
+                              "Connection: keep-alive\r\n\r\n" + payload;
+        if (m_latencyMs > 0) {
+            QTimer::singleShot(m_latencyMs, socket, [socket, response]() {
+                socket->write(response);
+            });
+        } else {
+            socket->write(response);
+        }
+    }
+
+    QJsonObject sessionJson(const QString &id) const
+    {
+        const Session &session = m_sessions[id];
+        return QJsonObject{
+            {"id", id},
+            {"status", "active"},
+            {"mode", "staged"},
+            {"totalSize", session.total},
+            {"receivedBytes", session.received},
+        };
+    }
+
+    QTcpServer m_server;
+    int m_latencyMs;
+    int m_nextSession;
+    QHash<QString, Session> m_sessions;
+    Stats m_stats;
+};
+
+static QList<Scenario> scenarios(qint64 hugeMb, int tinyCount, qint64 tinyBytes)
+{
+    return {
+        {"huge", {{1, hugeMb * 1024 * 1024}}, false},
+        {"tiny", {{tinyCount, tinyBytes}}, false},
+        {"mixed", {{2, 256 * 1024 * 1024}, {100, 4 * 1024 * 1024}, {5000, 16 * 1024}}, false},
+        {"sync", {{1000, 256 * 1024}}, true},
+    };
+}
+
+// Distinct content per file, so nothing is deduplicated or cached by content
+static bool writeFiles(const QString &dir, const QList<FileSet> &sets, QStringList *paths, qint64 *bytes)
+{
+    QByteArray block(1024 * 1024, Qt::Uninitialized);
+    quint32 seed = 0x9e3779b9;
+    for (char &c : block) {
+        seed = seed * 1664525 + 1013904223;
+        c = static_cast<char>(seed >> 24);
+    }
+
+    int index = 0;
+    for (const FileSet &set : sets) {
+        for (int i = 0; i < set.count; ++i, ++index) {
+            // Media extensions, so batching and folder sync take the files
+            QString path = QString("%1/file-%2.%3").arg(dir).arg(index, 6, 10, QChar('0'))
+                               .arg(set.size > 1024 * 1024 ? "mp4" : "jpg");
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly)) {
+                return false;
+            }
+            qToBigEndian<quint32>(static_cast<quint32>(index), block.data());
+            for (qint64 written = 0; written < set.size;) {
+                qint64 n = qMin<qint64>(block.size(), set.size - written);
+                if (file.write(block.constData(), n) != n) {
+                    return false;
+                }
+                written += n;
+            }
+            paths->append(path);
+            *bytes += set.size;
+        }
+    }
+    return true;
+}
+
+static double percentile(const QVector<qint64> &sorted, int p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    return sorted.at(qMin<int>(sorted.size() - 1, sorted.size() * p / 100));
+}
+
+// Runs one scenario in this process and returns its result
+static QJsonObject runScenario(const Scenario &scenario, int latencyMs)
+{
+    QJsonObject result;
+    result["scenario"] = scenario.name;
+
+    QTemporaryDir dataDir;
+    QStringList paths;
+    qint64 totalBytes = 0;
+    if (!dataDir.isValid() || !writeFiles(dataDir.path(), scenario.files, &paths, &totalBytes)) {
+        result["error"] = "could not create the test files";
+        return result;
+    }
+
+    // Mock server on its own thread, so its work stays out of the client's event loop
+    QThread serverThread;
+    QObject *serverContext = new QObject;
+    serverContext->moveToThread(&serverThread);
+    QObject::connect(&serverThread, &QThread::finished, serverContext, &QObject::deleteLater);
+    serverThread.start();
+
+    MockServer *server = nullptr;
+    quint16 port = 0;
+    QMetaObject::invokeMethod(serverContext, [&]() {
+        server = new MockServer(latencyMs);
+        if (server->listen()) {
+            port = server->port();
+        }
+    }, Qt::BlockingQueuedConnection);
+
+    QString serverUrl = QString("http://127.0.0.1:%1").arg(port);
+    {
+        QSettings settings;
+        settings.setValue("upload/serverUrl", serverUrl);
+        settings.setValue("sync/serverUrl", serverUrl);
+        settings.setValue("sync/folders", QStringList{dataDir.path()});
+        settings.setValue("ui/updateInterval", 5);
+    }
+
+    // Per-file latency from the coalesced status updates
+    QHash<quint64, qint64> started;
+    QVector<qint64> latencies;
+    int finished = 0;
+    int failed = 0;
+    QElapsedTimer clock;
+    auto onItems = [&](const ItemUpdateBatch &batch) {
+        qint64 now = clock.elapsed();
+        for (const ItemUpdate &update : batch.items) {
+            const QString &status = update.status;
+            if (status.isNull() || status == "Added to queue" || status == "Pending") {
+                continue;
+            }
+            if (status == "Completed" || status.startsWith("Synced")) {
+                latencies.append(now - started.value(update.key, 0));
+                finished++;
+            } else if (status == "Failed" || status == "File not found" || status == "Cannot open file") {
+                failed++;
+            } else if (!started.contains(update.key)) {
+                started.insert(update.key, now);
+            }
+        }
+        if (scenario.folderSync && finished + failed >= paths.size()) {
+            QCoreApplication::quit();
+        }
+    };
+
+    Usage before = processUsage();
+    qint64 queueMsec = 0;
+    clock.start();
+    if (scenario.folderSync) {
+        FolderSync sync;
+        QObject::connect(&sync, &FolderSync::itemsChanged, onItems);
+        sync.setAuthToken("benchmark");
+        sync.startSync();
+        queueMsec = clock.elapsed();
+        QCoreApplication::exec();
+        sync.stopSync();
+    } else {
+        UploadManager manager;
+        QObject::connect(&manager, &UploadManager::itemsChanged, onItems);
+        QObject::connect(&manager, &UploadManager::uploadFinished, QCoreApplication::instance(),
+                         &QCoreApplication::quit, Qt::QueuedConnection);
+        manager.setAuthToken("benchmark");
+        for (const QString &path : paths) {
+            manager.addFile(path);
+        }
+        queueMsec = clock.elapsed();
+        manager.startUpload();
+        QCoreApplication::exec();
+    }
+    qint64 elapsedMsec = qMax<qint64>(1, clock.elapsed());
+    Usage after = processUsage();
+
+    MockServer::Stats stats = {0, 0, 0};
+    double serverCpu = -1;
+    QMetaObject::invokeMethod(serverContext, [&]() {
+        stats = server->stats();
+        serverCpu = threadCpuSeconds();
+        delete server;
+    }, Qt::BlockingQueuedConnection);
+    serverThread.quit();
+    serverThread.wait();
+
+    std::sort(latencies.begin(), latencies.end());
+    double seconds = elapsedMsec / 1000.0;
+    double gigabytes = totalBytes / 1e9;
+    double cpu = after.cpuSeconds >= 0 ? after.cpuSeconds - before.cpuSeconds : -1;
+    if (cpu >= 0 && serverCpu >= 0) {
+        cpu = qMax(0.0, cpu - serverCpu);
+    }
+
+    result["files"] = paths.size();
+    result["bytes"] = totalBytes;
+    result["filesCompleted"] = finished;
+    result["filesFailed"] = failed;
+    result["serverFiles"] = stats.files;
+    result["serverRequests"] = stats.requests;
+    result["serverBodyBytes"] = stats.bodyBytes;
+    result["seconds"] = seconds;
+    result["queueSeconds"] = queueMsec / 1000.0;
+    result["throughputMBps"] = totalBytes / 1e6 / seconds;
+    result["filesPerSecond"] = finished / seconds;
+    result["latencyMs"] = QJsonObject{
+        {"p50", percentile(latencies, 50)},
+        {"p90", percentile(latencies, 90)},
+        {"p99", percentile(latencies, 99)},
+        {"max", latencies.isEmpty() ? 0.0 : static_cast<double>(latencies.last())},
+    };
+    result["peakRssMB"] = after.peakRssMb;
+    result["peakBufferedMB"] = MemoryBudget::instance()->peak() / (1024.0 * 1024.0);
+    result["cpuSeconds"] = cpu;
+    result["cpuSecondsPerGB"] = cpu >= 0 && gigabytes > 0 ? cpu / gigabytes : -1;
+    result["serverCpuExcluded"] = serverCpu >= 0;
+    return result;
+}
+
+static void printRow(const QJsonObject &r)
+{
+    if (r.contains("error")) {
+        std::fprintf(stderr, "%-8s %s\n", qPrintable(r.value("scenario").toString()),
+                     qPrintable(r.value("error").toString()));
+        return;
+    }
+    QJsonObject latency = r.value("latencyMs").toObject();
+    std::fprintf(stderr, "%-8s %8d %10.1f %10.1f %9.0f %9.0f %9.0f %10.1f %10.2f\n",
+                 qPrintable(r.value("scenario").toString()), r.value("filesCompleted").toInt(),
+                 r.value("seconds").toDouble(), r.value("throughputMBps").toDouble(),
+                 latency.value("p50").toDouble(), latency.value("p90").toDouble(),
+                 latency.value("p99").toDouble(), r.value("peakRssMB").toDouble(),
+                 r.value("cpuSecondsPerGB").toDouble());
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setOrganizationName("UploadClientBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Upload throughput against an in-process mock server");
+    parser.addHelpOption();
+    QCommandLineOption scenarioOption("scenario", "Scenario to run (huge, tiny, mixed, sync); repeatable", "name");
+    QCommandLineOption hugeOption("huge-mb", "Size of the huge file in MB", "mb", "1024");
+    QCommandLineOption tinyCountOption("tiny-count", "Number of tiny files", "count", "100000");
+    QCommandLineOption tinyBytesOption("tiny-bytes", "Size of each tiny file", "bytes", "1024");
+    QCommandLineOption latencyOption("latency", "Mock server response delay in ms", "ms", "0");
+    QCommandLineOption outputOption("output", "Write the JSON results here instead of stdout", "file");
+    QCommandLineOption childOption("child", "Run one scenario in this process (internal)");
+    childOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOptions({scenarioOption, hugeOption, tinyCountOption, tinyBytesOption, latencyOption,
+                       outputOption, childOption});
+    parser.process(app);
+
+    const QList<Scenario> all = scenarios(parser.value(hugeOption).toLongLong(),
+                                          parser.value(tinyCountOption).toInt(),
+                                          parser.value(tinyBytesOption).toLongLong());
+    QStringList selected = parser.values(scenarioOption);
+    if (selected.isEmpty()) {
+        for (const Scenario &scenario : all) {
+            selected.append(scenario.name);
+        }
+    }
+    int latencyMs = parser.value(latencyOption).toInt();
+
+    if (parser.isSet(childOption)) {
+        // Settings, journal and hash cache of a run must not leak into the next
+        QTemporaryDir home;
+        QStandardPaths::setTestModeEnabled(true);
+        app.setApplicationName(QString("bench-%1").arg(QCoreApplication::applicationPid()));
+        QSettings::setDefaultFormat(QSettings::IniFormat);
+        QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, home.path());
+
+        for (const Scenario &scenario : all) {
+            if (scenario.name == selected.value(0)) {
+                QJsonObject result = runScenario(scenario, latencyMs);
+                QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
+                std::printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    std::fprintf(stderr, "%-8s %8s %10s %10s %9s %9s %9s %10s %10s\n", "scenario", "files", "seconds",
+                 "MB/s", "p50 ms", "p90 ms", "p99 ms", "peak MB", "CPU s/GB");
+
+    QJsonArray results;
+    for (const QString &name : selected) {
+        QStringList args = app.arguments().mid(1);
+        args.removeAll("--child");
+        for (int i = args.indexOf("--scenario"); i >= 0; i = args.indexOf("--scenario")) {
+            args.remove(i, qMin(2, args.size() - i));
+        }
+        args << "--child" << "--scenario" << name;
+
+        QProcess child;
+        child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        child.start(QCoreApplication::applicationFilePath(), args);
+        child.waitForFinished(-1);
+
+        QJsonObject result = QJsonDocument::fromJson(child.readAllStandardOutput().trimmed()).object();
+        if (result.isEmpty()) {
+            result["scenario"] = name;
+            result["error"] = QString("run failed (exit code %1)").arg(child.exitCode());
+        }
+        printRow(result);
+        results.append(result);
+    }
+
+    QJsonObject report;
+    report["benchmark"] = "upload_throughput";
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["qtVersion"] = QString::fromLatin1(qVersion());
+    report["latencyMs"] = latencyMs;
+    report["results"] = results;
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            std::fprintf(stderr, "Cannot write %s\n", qPrintable(parser.value(outputOption)));
+            return 1;
+        }
+    } else {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+    }
+    return 0;
+}
@@ -44,7 +44,7 @@ private:
     QLabel *m_statusLabel;
     
     // Network
-    QNetworkAccessManager *m_networkManager;
+    QNetworkAccessManager *m_networkManager; // NetworkTransport::instance(), not owned
     QNetworkReply *m_currentReply;
     
     // State
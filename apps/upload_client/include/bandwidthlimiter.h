@@ -0,0 +1,66 @@
+#ifndef BANDWIDTHLIMITER_H
+#define BANDWIDTHLIMITER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QVariant>
+
+class QIODevice;
+
+// Process-wide token bucket for outgoing upload bytes. Request bodies ask
+// for bytes from readData(); when the bucket is dry they get none and are
+// woken with readyRead() after the next refill, so transfers are paced
+// rather than aborted. Each refill is split evenly between the bodies that
+// are waiting, which keeps concurrent transfers at about the same rate.
+//
+// The limit follows Settings ("network/bandwidthLimit", bytes per second,
+// 0 = unlimited) and can change while uploads are running. All methods must
+// be called from the GUI thread.
+class BandwidthLimiter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static BandwidthLimiter* instance();
+
+    void setRateLimit(qint64 bytesPerSecond);
+    qint64 rateLimit() const;
+    bool isLimited() const;
+
+    // Returns how many of maxBytes the device may send now; 0 means wait
+    qint64 acquire(QIODevice *device, qint64 maxBytes);
+    // The device is closed or fully sent; its unused share goes back
+    void release(QIODevice *device);
+
+private slots:
+    void refill();
+    void onSettingsChanged(const QString &group, const QString &key, const QVariant &value);
+
+private:
+    explicit BandwidthLimiter(QObject *parent = nullptr);
+    ~BandwidthLimiter();
+
+    BandwidthLimiter(const BandwidthLimiter&) = delete;
+    BandwidthLimiter& operator=(const BandwidthLimiter&) = delete;
+
+    void topUp();
+    qint64 burstSize() const;
+    void wakeAll();
+
+    qint64 m_rate;
+    qint64 m_tokens;
+    QElapsedTimer m_clock;
+    QTimer m_refillTimer;
+
+    QHash<QIODevice*, qint64> m_credit; // active devices and their share of past refills
+    QList<QIODevice*> m_waiting;
+
+    static const int REFILL_INTERVAL;
+    static const int BURST_MSEC;
+    static const qint64 MIN_GRANT;
+};
+
+#endif // BANDWIDTHLIMITER_H
@@ -0,0 +1,82 @@
+#ifndef CHUNKENCODER_H
+#define CHUNKENCODER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QMetaType>
+#include <QQueue>
+#include <QStringList>
+#include <QThreadPool>
+
+struct EncodedChunk {
+    QString filePath;
+    qint64 offset;
+    qint64 length; // file bytes the chunk covers
+    QByteArray data; // zlib stream ("deflate" content coding); empty if not compressed
+    bool compressible; // false if the probe found too little to gain
+    bool readFailed;
+
+    EncodedChunk() : offset(0), length(0), compressible(true), readFailed(false) {}
+};
+
+Q_DECLARE_METATYPE(EncodedChunk)
+
+// Compresses upload chunks of formats that are stored uncompressed (WAV, BMP,
+// TIFF, ...) on a worker pool, so uplink bytes shrink without stalling the
+// GUI thread. Already compressed formats are never candidates. The first
+// chunk of a file is probed on a small sample before the whole chunk is
+// compressed; a file that does not compress well enough is sent as is.
+//
+// A job draws twice its chunk length from MemoryBudget, for the raw bytes
+// and the compressed copy, and waits in line while the budget is spent. The
+// compressed data is the receiver's from chunkEncoded on.
+class ChunkEncoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChunkEncoder(QObject *parent = nullptr);
+    ~ChunkEncoder();
+
+    void setLevel(int level);
+    int level() const;
+    void setExtensions(const QStringList &extensions);
+    QStringList extensions() const;
+
+    bool isCandidate(const QString &filePath) const;
+    qint64 maxChunkSize() const; // longer chunks are cut to this when compressed
+
+    // Reads and compresses [offset, offset + length) of the file on a worker
+    // once the memory for it is free; the result arrives through
+    // chunkEncoded on this object's thread
+    void encode(const QString &filePath, qint64 offset, qint64 length, bool probe);
+
+signals:
+    void chunkEncoded(const EncodedChunk &chunk);
+
+private:
+    struct Job {
+        QString filePath;
+        qint64 offset;
+        qint64 length;
+        bool probe;
+    };
+
+    void dispatch();
+    void start(const Job &job);
+
+    static EncodedChunk process(const QString &filePath, qint64 offset, qint64 length,
+                                bool probe, int level);
+    static QByteArray deflate(const QByteArray &data, int level);
+
+    QThreadPool m_pool;
+    QQueue<Job> m_waiting; // for memory, in order
+    QStringList m_extensions; // lower case, with leading dot
+    int m_level;
+
+    static const qint64 PROBE_SIZE;
+    static const qint64 MAX_CHUNK_SIZE;
+    static const double MAX_RATIO;
+};
+
+#endif // CHUNKENCODER_H
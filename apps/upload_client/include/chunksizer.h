@@ -0,0 +1,61 @@
+#ifndef CHUNKSIZER_H
+#define CHUNKSIZER_H
+
+#include <QtGlobal>
+#include <QMetaType>
+
+// Measurements behind the current chunk size, for display
+struct ChunkStats {
+    qint64 chunkSize;   // size of the next chunk
+    qint64 goodput;     // bytes/s acknowledged by the server, request overhead included
+    qint64 throughput;  // bytes/s while the chunk body was on the wire
+    qint64 rttMs;       // last byte sent -> response received
+    int samples;
+
+    ChunkStats() : chunkSize(0), goodput(0), throughput(0), rttMs(0), samples(0) {}
+};
+
+Q_DECLARE_METATYPE(ChunkStats)
+
+// Picks the size of the next chunk of a resumable upload from what the
+// previous chunks measured. A chunk should take about targetDuration() on
+// the wire so a failure never costs much more than that to resend, but at
+// least RTT_MULTIPLE round trips so the per-chunk round trip stays a small
+// share of the transfer. Sizes move at most 2x per chunk, halve on failure
+// and stay within [minChunkSize, maxChunkSize].
+class ChunkSizer
+{
+public:
+    ChunkSizer();
+
+    void setBounds(qint64 minChunkSize, qint64 maxChunkSize);
+    void setTargetDuration(int msec);
+    int targetDuration() const;
+    void setChunkSize(qint64 size);
+    qint64 chunkSize() const;
+
+    // sendMsec: request start -> last body byte; ackMsec: last byte -> response
+    void addSample(qint64 bytes, qint64 sendMsec, qint64 ackMsec);
+    void addFailure();
+
+    ChunkStats stats() const;
+
+private:
+    qint64 alignedSize(qint64 size) const;
+
+    qint64 m_minChunkSize;
+    qint64 m_maxChunkSize;
+    int m_targetDuration;
+    qint64 m_chunkSize;
+
+    // Exponentially weighted averages, 1/8 weight per sample as in TCP's SRTT
+    double m_throughput;
+    double m_goodput;
+    double m_rtt;
+    int m_samples;
+
+    static const int RTT_MULTIPLE;
+    static const qint64 SIZE_ALIGNMENT;
+};
+
+#endif // CHUNKSIZER_H
@@ -0,0 +1,65 @@
+#ifndef CONTENTCHUNKER_H
+#define CONTENTCHUNKER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QMetaType>
+#include <QThreadPool>
+#include <QVector>
+
+struct ContentChunk {
+    qint64 offset;
+    qint64 length;
+    QByteArray hash; // SHA-256 of the chunk bytes, hex
+
+    ContentChunk() : offset(0), length(0) {}
+};
+
+struct ChunkManifest {
+    QString filePath;
+    qint64 fileSize;
+    QVector<ContentChunk> chunks; // in file order, covering the whole file
+    bool failed; // the file could not be read
+
+    ChunkManifest() : fileSize(0), failed(false) {}
+};
+
+Q_DECLARE_METATYPE(ChunkManifest)
+
+// Splits files into content-defined chunks (FastCDC with normalized
+// chunking) on a worker thread. Boundaries depend only on the bytes around
+// them, so an edit moves at most the chunks it touches and the rest of the
+// file produces the same chunks, and hashes, as before. The server keeps
+// chunks by hash, so a changed file costs only its new chunks.
+//
+// A job holds one read block of MemoryBudget while it runs. The gear table
+// and chunk sizes are part of the format: changing them makes every chunk
+// of every file new to the server.
+class ContentChunker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ContentChunker(QObject *parent = nullptr);
+    ~ContentChunker();
+
+    // The manifest arrives through manifestReady on this object's thread
+    void chunkFile(const QString &filePath);
+
+    // Worker side
+    static ChunkManifest chunk(const QString &filePath);
+
+    static const qint64 MIN_CHUNK_SIZE;
+    static const qint64 AVG_CHUNK_SIZE;
+    static const qint64 MAX_CHUNK_SIZE;
+
+signals:
+    void manifestReady(const ChunkManifest &manifest);
+
+private:
+    QThreadPool m_pool;
+
+    static const qint64 READ_BLOCK_SIZE;
+};
+
+#endif // CONTENTCHUNKER_H
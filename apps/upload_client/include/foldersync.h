@@ -12,8 +12,16 @@
 #include <QJsonArray>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QQueue>
+#include "contentchunker.h"
+#include "itemstore.h"
+#include "mediaprobe.h"
+#include "updatecoalescer.h"
+
+struct PreprocessResult;
 
 struct SyncItem {
+    quint64 id; // stable key in the sync queue and in itemsChanged; 0 until queued
     QString localPath;
     QString remotePath;
     QString fileName;
@@ -21,9 +29,11 @@ struct SyncItem {
     QDateTime lastModified;
     QString status;
     bool isDirectory;
+    QByteArray contentHash;
+    MediaInfo mediaInfo; // from the container headers, sent with the upload
     
-    SyncItem() : fileSize(0), isDirectory(false) {}
-    SyncItem(const QString &path) : localPath(path), isDirectory(false) {
+    SyncItem() : id(0), fileSize(0), isDirectory(false) {}
+    SyncItem(const QString &path) : id(0), localPath(path), isDirectory(false) {
         QFileInfo info(path);
         fileName = info.fileName();
         fileSize = info.size();
@@ -59,14 +69,15 @@ public:
     void forceSync();
     
     QStringList getSyncedFolders() const;
-    QList<SyncItem> getSyncQueue() const;
+    QList<SyncItem> getSyncQueue() const; // queue order
+    SyncItem syncItem(quint64 id) const; // default constructed if the ID is gone
     bool isSyncing() const;
 
 signals:
     void syncProgress(int progress);
     void syncFinished();
     void syncError(const QString &error);
-    void itemStatusChanged(int index, const QString &status);
+    void itemsChanged(const ItemUpdateBatch &batch); // keyed by SyncItem::id, at most once per ui/updateInterval
     void folderAdded(const QString &folderPath);
     void folderRemoved(const QString &folderPath);
 
@@ -75,39 +86,92 @@ private slots:
     void onDirectoryChanged(const QString &path);
     void onSyncTimeout();
     void onNetworkReplyFinished();
+    void onFileProcessed(const PreprocessResult &result);
+    void onManifestReady(const ChunkManifest &manifest);
+    void onChunkReplyFinished();
 
 private:
     void scanFolder(const QString &folderPath);
     void scanFile(const QString &filePath);
     void updateSyncQueue();
     void processSyncQueue();
+    void sendFile(const SyncItem &item);
     void uploadFile(const SyncItem &item);
+    void checkDuplicate(const SyncItem &item);
+    void finishCurrentItem(const QString &status);
+    void releaseFile(const QString &filePath);
+    quint64 enqueueSyncItem(const SyncItem &item);
     void createDirectory(const SyncItem &item);
     void removeRemoteItem(const SyncItem &item);
-    void updateItemStatus(int index, const QString &status);
+    void updateItemStatus(quint64 id, const QString &status);
+    
+    // Delta sync: content-defined chunks, of which only those the server
+    // lacks are sent, then a commit that lists all of them
+    enum DeltaPhase {
+        DeltaNone,
+        DeltaChunking,
+        DeltaChecking,
+        DeltaSendingChunks,
+        DeltaCommitting
+    };
+    void startDelta(const SyncItem &item);
+    void sendChunkCheck();
+    void sendChunks();
+    QNetworkReply *sendChunk(int index); // null if the file cannot be read
+    void abortChunks();
+    void commitDelta();
+    bool handleDeltaReply(); // false if the generic reply handling should take over
     
     // File system monitoring
     QFileSystemWatcher *m_fileWatcher;
     QStringList m_watchedFolders;
     
     // Network
-    QNetworkAccessManager *m_networkManager;
+    QNetworkAccessManager *m_networkManager; // NetworkTransport::instance(), not owned
     QNetworkReply *m_currentReply;
     QString m_authToken;
     QString m_serverUrl;
     
-    // Sync state
-    QList<SyncItem> m_syncQueue;
+    // Sync state. Queue entries are addressed by ID, so lookups and removals
+    // stay O(1) however long the queue gets.
+    ItemStore<SyncItem> m_syncQueue;
+    QHash<QString, quint64> m_queuedIds; // local path -> ID in m_syncQueue
+    QQueue<quint64> m_pendingIds; // waiting to sync, oldest first; may hold IDs removed since
     QHash<QString, SyncItem> m_fileIndex;
+    QHash<QByteArray, QString> m_contentIndex; // content hash -> first synced path
+    quint64 m_currentId; // item being hashed, checked or uploaded
+    QString m_currentPath;
+    bool m_checkingDuplicate;
+    
+    // Delta sync of the current item
+    ContentChunker *m_chunker;
+    DeltaPhase m_deltaPhase;
+    ChunkManifest m_deltaManifest;
+    QList<QByteArray> m_deltaHashes; // distinct chunk hashes, in file order
+    QHash<QByteArray, int> m_deltaChunkIndex; // hash -> first chunk with it
+    QVector<int> m_deltaMissing; // chunks to send
+    QList<QNetworkReply*> m_deltaChunkReplies; // chunk PUTs in flight
+    int m_deltaChecked; // hashes checked so far
+    int m_deltaNext; // next entry of m_deltaMissing to send
+    int m_deltaSent; // chunks of m_deltaMissing the server has taken
+    bool m_deltaResent;
+    UpdateCoalescer *m_updates;
     QMutex m_syncMutex;
     bool m_isSyncing;
     bool m_isEnabled;
     
     // Settings
     QTimer *m_syncTimer;
+    QTimer *m_circuitTimer; // resumes the queue once the server's circuit half-opens
     int m_syncInterval;
     int m_maxRetries;
     int m_currentRetries;
+    qint64 m_streamBufferSize;
+    bool m_dedupeEnabled;
+    bool m_deltaEnabled;
+    bool m_deltaSupported; // cleared when the server has no delta sync routes
+    qint64 m_deltaMinSize; // smaller files are uploaded whole
+    int m_deltaConcurrency; // chunk PUTs kept in flight
     
     // File filters
     QStringList m_mediaExtensions;
@@ -0,0 +1,57 @@
+#ifndef HASHCACHE_H
+#define HASHCACHE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QTimer>
+
+// Content hashes (BLAKE2b-256, hex) keyed by (device, inode, size, mtime), so
+// an unchanged file is read at most once no matter how often it is queued or
+// under how many paths it appears. Lookups and inserts are thread safe; the
+// hashing itself happens in PreprocessPool. The cache is persisted in the app
+// data directory.
+class HashCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static HashCache* instance();
+
+    // Returns the cached hash, or an empty array if the file must be hashed
+    QByteArray cachedHash(const QString &filePath);
+    void insert(const QByteArray &key, const QByteArray &hash);
+
+    static QByteArray fileKey(const QString &filePath);
+
+public slots:
+    void save();
+
+private:
+    explicit HashCache(QObject *parent = nullptr);
+    ~HashCache();
+
+    HashCache(const HashCache&) = delete;
+    HashCache& operator=(const HashCache&) = delete;
+
+    struct Entry {
+        QByteArray hash;
+        qint64 lastUsed;
+
+        Entry() : lastUsed(0) {}
+    };
+
+    void load();
+
+    QString m_cachePath;
+    QMutex m_mutex;
+    QHash<QByteArray, Entry> m_entries;
+    bool m_dirty;
+
+    QTimer m_saveTimer;
+
+    static const int MAX_ENTRIES;
+};
+
+#endif // HASHCACHE_H
@@ -0,0 +1,168 @@
+#ifndef ITEMSTORE_H
+#define ITEMSTORE_H
+
+#include <QList>
+#include <QVector>
+
+// Slab of items addressed by stable 64-bit IDs. An ID packs the slot index
+// (low 32 bits) with the slot's generation (high 32 bits), so lookup and
+// removal are O(1), removing an item never moves the others, and an ID that
+// outlived its item never finds whatever reused the slot. Freed slots are
+// reused before the slab grows. Iteration follows insertion order.
+//
+// 0 is never a valid ID.
+template <typename T>
+class ItemStore
+{
+public:
+    typedef quint64 Id;
+
+    ItemStore() : m_head(-1), m_tail(-1), m_free(-1), m_size(0) {}
+
+    Id insert(const T &value)
+    {
+        int slot = m_free;
+        if (slot >= 0) {
+            m_free = m_slots[slot].next;
+        } else {
+            slot = m_slots.size();
+            m_slots.append(Slot());
+        }
+
+        Slot &entry = m_slots[slot];
+        entry.value = value;
+        entry.used = true;
+        entry.prev = m_tail;
+        entry.next = -1;
+        if (m_tail >= 0) {
+            m_slots[m_tail].next = slot;
+        } else {
+            m_head = slot;
+        }
+        m_tail = slot;
+        m_size++;
+        return makeId(slot, entry.generation);
+    }
+
+    bool remove(Id id)
+    {
+        int slot = slotOf(id);
+        if (slot < 0) {
+            return false;
+        }
+
+        Slot &entry = m_slots[slot];
+        if (entry.prev >= 0) {
+            m_slots[entry.prev].next = entry.next;
+        } else {
+            m_head = entry.next;
+        }
+        if (entry.next >= 0) {
+            m_slots[entry.next].prev = entry.prev;
+        } else {
+            m_tail = entry.prev;
+        }
+
+        // A new generation invalidates every ID handed out for this slot
+        entry.value = T();
+        entry.used = false;
+        entry.generation = entry.generation == 0xffffffffu ? 1 : entry.generation + 1;
+        entry.prev = -1;
+        entry.next = m_free;
+        m_free = slot;
+        m_size--;
+        return true;
+    }
+
+    T* find(Id id)
+    {
+        int slot = slotOf(id);
+        return slot >= 0 ? &m_slots[slot].value : nullptr;
+    }
+
+    const T* find(Id id) const
+    {
+        int slot = slotOf(id);
+        return slot >= 0 ? &m_slots.at(slot).value : nullptr;
+    }
+
+    bool contains(Id id) const { return slotOf(id) >= 0; }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    // Slots are kept so their generations still rule out the old IDs
+    void clear()
+    {
+        while (m_head >= 0) {
+            remove(makeId(m_head, m_slots.at(m_head).generation));
+        }
+    }
+
+    // Insertion order; use first() and next() to walk without copying
+    Id first() const { return m_head >= 0 ? makeId(m_head, m_slots.at(m_head).generation) : 0; }
+
+    Id next(Id id) const
+    {
+        int slot = slotOf(id);
+        if (slot < 0 || m_slots.at(slot).next < 0) {
+            return 0;
+        }
+        int nextSlot = m_slots.at(slot).next;
+        return makeId(nextSlot, m_slots.at(nextSlot).generation);
+    }
+
+    QList<Id> ids() const
+    {
+        QList<Id> result;
+        result.reserve(m_size);
+        for (int slot = m_head; slot >= 0; slot = m_slots.at(slot).next) {
+            result.append(makeId(slot, m_slots.at(slot).generation));
+        }
+        return result;
+    }
+
+    QList<T> values() const
+    {
+        QList<T> result;
+        result.reserve(m_size);
+        for (int slot = m_head; slot >= 0; slot = m_slots.at(slot).next) {
+            result.append(m_slots.at(slot).value);
+        }
+        return result;
+    }
+
+private:
+    struct Slot {
+        T value;
+        quint32 generation;
+        bool used;
+        int prev; // insertion order; next doubles as the free list link
+        int next;
+
+        Slot() : generation(1), used(false), prev(-1), next(-1) {}
+    };
+
+    static Id makeId(int slot, quint32 generation)
+    {
+        return (static_cast<Id>(generation) << 32) | static_cast<quint32>(slot);
+    }
+
+    int slotOf(Id id) const
+    {
+        int slot = static_cast<int>(id & 0xffffffffu);
+        quint32 generation = static_cast<quint32>(id >> 32);
+        if (slot < 0 || slot >= m_slots.size() || !m_slots.at(slot).used ||
+            m_slots.at(slot).generation != generation) {
+            return -1;
+        }
+        return slot;
+    }
+
+    QVector<Slot> m_slots;
+    int m_head;
+    int m_tail;
+    int m_free; // most recently freed slot
+    int m_size;
+};
+
+#endif // ITEMSTORE_H
@@ -23,6 +23,7 @@ class AuthDialog;
 class UploadManager;
 class FolderSync;
 class NetworkManager;
+struct ChunkStats;
 
 class MainWindow : public QMainWindow
 {
@@ -44,6 +45,8 @@ private slots:
     void onSyncProgress(int progress);
     void onStatusMessage(const QString &message);
     void onNetworkError(const QString &error);
+    void onChunkStatsChanged(const ChunkStats &stats);
+    void updateMemoryStats();
 
 private:
     void setupUI();
@@ -79,6 +82,8 @@ private:
     QPushButton *m_syncAllBtn;
     QProgressBar *m_uploadProgressBar;
     QProgressBar *m_syncProgressBar;
+    QLabel *m_transferStatsLabel;
+    QLabel *m_memoryStatsLabel;
     
     // Authentication
     QPushButton *m_loginBtn;
@@ -102,6 +107,7 @@ private:
     
     // Timer for periodic sync
     QTimer *m_syncTimer;
+    QTimer *m_memoryStatsTimer;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,117 @@
+#ifndef MEDIAPROBE_H
+#define MEDIAPROBE_H
+
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+struct MediaInfo {
+    qint64 durationMs; // 0 for still images or when the container does not say
+    int width;
+    int height;
+    QString codec; // as the container names it, e.g. "avc1", "V_VP9", "flac", "jpeg"
+    qint64 bitrate; // bits per second; the container's figure, else size over duration
+
+    MediaInfo() : durationMs(0), width(0), height(0), bitrate(0) {}
+
+    bool isEmpty() const { return durationMs <= 0 && width <= 0 && codec.isEmpty(); }
+    double durationSeconds() const { return durationMs / 1000.0; }
+
+    // The known fields, for upload metadata
+    QJsonObject toJson() const;
+};
+
+// Reads duration, resolution, codec and bitrate from container headers
+// without decoding anything: MP4/MOV box trees, Matroska/WebM EBML, WAV
+// (and RF64), FLAC, and PNG, JPEG, GIF, BMP and WebP images. The format is
+// told by its magic bytes, not the file name.
+//
+// The file is mapped in small windows and parsed in place. Each parser
+// jumps from header to header by the sizes they declare, so a file of many
+// GB costs the few pages its headers sit on: an MP4 whose moov is at the
+// end is one window at the start and one at the end. A bounded number of
+// windows and elements keeps a damaged or hostile file from turning the
+// probe into a full read; it then returns whatever it found so far.
+//
+// Safe to call from any thread.
+class MediaProbe
+{
+public:
+    static MediaInfo probe(const QString &filePath);
+
+private:
+    explicit MediaProbe(const QString &filePath);
+
+    MediaProbe(const MediaProbe&) = delete;
+    MediaProbe& operator=(const MediaProbe&) = delete;
+
+    struct Window {
+        qint64 offset;
+        qint64 length;
+        const uchar *data; // into the mapping, or into copy if mapping failed
+        QByteArray copy;
+    };
+
+    // An MP4 box or an EBML element: where its payload starts and where it ends
+    struct Box {
+        quint32 type;
+        qint64 payload;
+        qint64 end;
+    };
+
+    struct Track {
+        bool isVideo;
+        bool isAudio;
+        int width;
+        int height;
+        QString codec;
+
+        Track() : isVideo(false), isAudio(false), width(0), height(0) {}
+    };
+
+    // length bytes at offset, valid while the probe lives; null past the
+    // end of the file or once the window budget is spent
+    const uchar *at(qint64 offset, qint64 length);
+    bool startsWith(qint64 offset, const char *magic);
+    bool countStep();
+
+    void probeMp4();
+    void readMoov(const Box &moov);
+    Track readTrak(const Box &trak);
+    bool readBox(qint64 offset, qint64 end, Box &box);
+    bool findBox(qint64 start, qint64 end, quint32 type, Box &box);
+
+    void probeMatroska();
+    void readInfo(const Box &info);
+    void readTracks(const Box &tracks);
+    void readSeekHead(const Box &seekHead, qint64 segmentStart, qint64 &infoAt, qint64 &tracksAt);
+    bool readElement(qint64 offset, qint64 end, Box &element);
+    bool readVint(qint64 offset, qint64 end, bool keepMarker, quint64 &value, int &length);
+    quint64 readUInt(const Box &element);
+    double readFloat(const Box &element);
+    QString readString(const Box &element);
+
+    void probeWav();
+    void probeFlac(qint64 start);
+    void probeJpeg();
+    void probePng();
+    void probeGif();
+    void probeBmp();
+    void probeWebp();
+
+    void takeTrack(const Track &track);
+
+    QFile m_file;
+    qint64 m_size;
+    QVector<Window> m_windows;
+    int m_steps; // boxes, elements and chunks visited
+    bool m_haveVideo;
+    MediaInfo m_info;
+
+    static const qint64 WINDOW_SIZE;
+    static const int MAX_WINDOWS;
+    static const int MAX_STEPS;
+};
+
+#endif // MEDIAPROBE_H
@@ -0,0 +1,69 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QObject>
+#include <QVariant>
+
+// Process-wide cap on the file data held in memory by every stage of a
+// transfer: read-ahead blocks, chunks being compressed or waiting to be
+// sent, hashing buffers. A stage asks before it buffers; when the budget is
+// spent it gets nothing and waits for memoryAvailable() instead of
+// allocating, the same way request bodies wait for BandwidthLimiter.
+//
+// Work that a transfer is blocked on right now may acquire() past the limit,
+// so the budget slows the stages that run ahead but never stalls an upload.
+// A request larger than the whole budget is granted once nothing else is
+// held.
+//
+// The limit follows Settings ("upload/memoryBudget", bytes, default 256MB)
+// and can change while uploads are running. All methods must be called from
+// the GUI thread.
+class MemoryBudget : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MemoryBudget* instance();
+
+    void setLimit(qint64 bytes);
+    qint64 limit() const;
+    qint64 used() const;
+    qint64 peak() const; // highest used() since start or resetPeak()
+    void resetPeak();
+
+    // Takes bytes if they fit; false means wait for memoryAvailable()
+    bool tryAcquire(qint64 bytes);
+    // Takes bytes even past the limit
+    void acquire(qint64 bytes);
+    void release(qint64 bytes);
+
+signals:
+    // Someone was refused; holders of memory they can do without should let it go
+    void memoryShort();
+    // Memory was released after a refusal; refused stages should ask again
+    void memoryAvailable();
+
+private slots:
+    void onSettingsChanged(const QString &group, const QString &key, const QVariant &value);
+
+private:
+    explicit MemoryBudget(QObject *parent = nullptr);
+    ~MemoryBudget();
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    void take(qint64 bytes);
+    void notify(bool available);
+
+    qint64 m_limit;
+    qint64 m_used;
+    qint64 m_peak;
+    bool m_refused; // someone is waiting for memoryAvailable()
+    bool m_shortPending;
+    bool m_availablePending;
+
+    static const qint64 MIN_LIMIT;
+};
+
+#endif // MEMORYBUDGET_H
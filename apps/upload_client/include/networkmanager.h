@@ -56,10 +56,11 @@ private:
     void trackRequest(QNetworkReply *reply, const QString &endpoint);
     
     // Network
-    QNetworkAccessManager *m_networkManager;
+    QNetworkAccessManager *m_networkManager; // NetworkTransport::instance(), not owned
     QString m_authToken;
     QString m_serverUrl;
     int m_timeout;
+    qint64 m_streamBufferSize;
     
     // State
     bool m_isOnline;
@@ -0,0 +1,62 @@
+#ifndef NETWORKTRANSPORT_H
+#define NETWORKTRANSPORT_H
+
+#include <QNetworkAccessManager>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QUrl>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+
+// The one QNetworkAccessManager every component sends through, so login,
+// uploads, folder sync and API calls share connections, TLS sessions and
+// resolved hosts instead of each paying for its own handshakes.
+//
+// Every request leaving through it gets the transport policy: HTTP/2 where
+// the server negotiates it over TLS (one multiplexed connection), otherwise
+// HTTP/1.1 keep-alive with at most maxConnectionsPerHost() connections per
+// host, and TLS session resumption. A request that already carries its own
+// HTTP/2 attribute, HTTP/1 or TLS configuration keeps it. prewarm() opens
+// connections ahead of the first request, e.g. right after login, so the
+// first upload does not wait for TCP and TLS setup.
+//
+// Settings: network/http2 (default true), network/maxConnectionsPerHost
+// (default 6), network/prewarmConnections (default upload/maxConcurrent).
+// Must be used from the GUI thread.
+class NetworkTransport : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    static NetworkTransport* instance();
+
+    void prewarm(const QUrl &serverUrl);
+
+    bool isHttp2Allowed() const;
+    int maxConnectionsPerHost() const;
+    int prewarmConnections() const;
+
+protected:
+    QNetworkReply* createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData = nullptr) override;
+
+private:
+    explicit NetworkTransport(QObject *parent = nullptr);
+    ~NetworkTransport();
+
+    NetworkTransport(const NetworkTransport&) = delete;
+    NetworkTransport& operator=(const NetworkTransport&) = delete;
+
+    bool m_http2Allowed;
+    int m_maxConnectionsPerHost;
+    int m_prewarmConnections;
+    QHash<QString, QElapsedTimer> m_prewarmed; // origin -> last prewarm
+#if QT_CONFIG(ssl)
+    QSslConfiguration m_sslConfiguration;
+#endif
+
+    static const qint64 PREWARM_INTERVAL;
+};
+
+#endif // NETWORKTRANSPORT_H
@@ -0,0 +1,86 @@
+#ifndef PREPROCESSPOOL_H
+#define PREPROCESSPOOL_H
+
+#include <QObject>
+#include <QHash>
+#include <QMetaType>
+#include <QQueue>
+#include <QSet>
+#include <QThreadPool>
+#include "mediaprobe.h"
+
+struct PreprocessResult {
+    QString filePath;
+    qint64 fileSize;
+    QByteArray contentHash; // empty if the file could not be read
+    MediaInfo mediaInfo; // from the container headers, see MediaProbe
+
+    PreprocessResult() : fileSize(0) {}
+};
+
+Q_DECLARE_METATYPE(PreprocessResult)
+
+// Pre-upload work (hashing, and reading media headers with MediaProbe) on
+// a QThreadPool sized to the machine. Files are admitted in submission
+// order while the bytes that are being processed or waiting for upload
+// stay under maxBytesAhead(); callers release() a file once its upload is
+// finished so the pool can move on. Each running job also holds one read
+// buffer's worth of MemoryBudget (mapped windows are page cache the kernel
+// can take back). An urgent submit skips both budgets, so a file an upload
+// slot is waiting on never queues behind prefetched work.
+//
+// All public methods must be called from the GUI thread; workers only read
+// files and post their results back.
+class PreprocessPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static PreprocessPool* instance();
+
+    // fileSize as the caller last saw it, or -1 to have it read here
+    void submit(const QString &filePath, bool urgent = false, qint64 fileSize = -1);
+    void release(const QString &filePath);
+
+    void setMaxBytesAhead(qint64 bytes);
+    qint64 maxBytesAhead() const;
+    qint64 bytesAhead() const;
+    void setThreadCount(int threads);
+    int threadCount() const;
+
+    // Worker side: hashes through mmap windows, falling back to large reads
+    static QByteArray hashFile(const QString &filePath);
+
+signals:
+    void fileProcessed(const PreprocessResult &result);
+
+private:
+    explicit PreprocessPool(QObject *parent = nullptr);
+    ~PreprocessPool();
+
+    PreprocessPool(const PreprocessPool&) = delete;
+    PreprocessPool& operator=(const PreprocessPool&) = delete;
+
+    static PreprocessResult process(const QString &filePath);
+
+    void start(const QString &filePath, qint64 size);
+    void dispatch();
+    void onJobFinished(const PreprocessResult &result);
+
+    QThreadPool m_pool;
+    // Waiting files in submission order. Released or urgently started files
+    // leave only m_waitingSizes, and dispatch() skips their queue entries.
+    QQueue<QString> m_waiting;
+    QHash<QString, qint64> m_waitingSizes; // -> size at submit
+    QSet<QString> m_running;
+    QHash<QString, qint64> m_admitted; // running or finished but not yet released
+    QHash<QString, PreprocessResult> m_results;
+    qint64 m_bytesAhead;
+    qint64 m_maxBytesAhead;
+
+    static const qint64 DEFAULT_MAX_BYTES_AHEAD;
+    static const qint64 MAP_WINDOW_SIZE;
+    static const qint64 READ_BLOCK_SIZE;
+};
+
+#endif // PREPROCESSPOOL_H
@@ -0,0 +1,98 @@
+#ifndef READAHEADPOOL_H
+#define READAHEADPOOL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QThreadPool>
+#include <QVector>
+
+// Reads upload data from disk ahead of the network on a small I/O pool, so
+// the next blocks of a file are already in memory when a request body asks
+// for them and disk latency overlaps the transfer instead of adding to it.
+//
+// Data is read in blocks of blockSize() bytes into a fixed set of reusable
+// buffers (upload/readAheadMemory bytes worth), keyed by file and offset.
+// Blocks start at multiples of blockSize() in the file, so every range that
+// touches a block finds the same one, wherever the range itself starts.
+// A finished block waits until a stream take()s it; the consumer hands the
+// buffer back with recycle(). Buffers are drawn from MemoryBudget; when it
+// runs short, spare buffers and then unclaimed blocks go back to it one
+// refusal at a time. When no buffer can be had a
+// prefetch is dropped, except an urgent one, which evicts the oldest
+// unclaimed block or goes over budget.
+//
+// Settings: upload/readBlockSize (default 256KB), upload/readAheadMemory
+// (default 64MB), upload/readThreads (default 2; more parallel reads only
+// help on SSDs). All public methods must be called from the GUI thread.
+class ReadAheadPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum BlockState {
+        Missing, // neither read nor being read
+        Pending,
+        Ready,
+        Failed
+    };
+
+    static ReadAheadPool* instance();
+
+    qint64 blockSize() const;
+    qint64 memoryLimit() const;
+
+    // Starts reading blockSize() bytes at offset, a multiple of blockSize(),
+    // unless already read or in flight; false if no buffer could be had for it
+    bool fetch(const QString &filePath, qint64 offset, bool urgent = false);
+    // Blocks covering [offset, offset + length), stopping at the first one over budget
+    void prefetch(const QString &filePath, qint64 offset, qint64 length);
+    // A Ready block, at a multiple of blockSize(), moves into data and leaves
+    // the pool; shorter than blockSize() at the end of the file
+    BlockState take(const QString &filePath, qint64 offset, QByteArray *data);
+    void recycle(QByteArray &buffer);
+    // Forgets every block of the file, e.g. once its upload is finished
+    void drop(const QString &filePath);
+
+signals:
+    void blockReady(const QString &filePath, qint64 offset);
+
+private:
+    using Key = QPair<QString, qint64>;
+
+    struct Block {
+        QByteArray data;
+        bool failed;
+
+        Block() : failed(false) {}
+    };
+
+    explicit ReadAheadPool(QObject *parent = nullptr);
+    ~ReadAheadPool();
+
+    ReadAheadPool(const ReadAheadPool&) = delete;
+    ReadAheadPool& operator=(const ReadAheadPool&) = delete;
+
+    static bool readBlock(const QString &filePath, qint64 offset, QByteArray &buffer);
+
+    bool acquireBuffer(bool urgent, QByteArray *buffer);
+    void onMemoryShort();
+    void onBlockRead(const Key &key, quint64 ticket, const QByteArray &buffer, bool failed);
+
+    QThreadPool m_pool;
+    QVector<QByteArray> m_free; // recycled buffers, capacity blockSize()
+    QHash<Key, quint64> m_inFlight; // -> ticket, so a dropped read is discarded
+    QHash<Key, Block> m_ready;
+    QList<Key> m_readyOrder; // oldest first, for eviction
+    quint64 m_nextTicket;
+    int m_buffersInUse; // in flight, ready or taken
+    int m_maxBuffers;
+    qint64 m_blockSize;
+
+    static const qint64 DEFAULT_BLOCK_SIZE;
+    static const qint64 DEFAULT_MEMORY_LIMIT;
+};
+
+#endif // READAHEADPOOL_H
@@ -0,0 +1,103 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkReply>
+#include <QString>
+#include <QUrl>
+
+// What went wrong with a request, as far as retrying it is concerned
+struct RequestFailure {
+    enum Kind {
+        None,       // the request succeeded
+        Transient,  // connection trouble, timeouts, most 5xx: try again later
+        Throttled,  // 429 or 503: try again, no sooner than retryAfter
+        Fatal       // the same request would fail the same way
+    };
+
+    Kind kind;
+    int httpStatus; // 0 when there was no response
+    qint64 retryAfter; // ms the server asked us to wait, -1 if it did not say
+
+    RequestFailure() : kind(Transient), httpStatus(0), retryAfter(-1) {}
+
+    bool isRetryable() const { return kind == Transient || kind == Throttled; }
+};
+
+// Decides whether and when a failed request is tried again, for every
+// component that talks to a server.
+//
+// Delays use full-jitter exponential backoff: attempt n waits a random time
+// between 0 and min(maxDelay, baseDelay * 2^(n-1)), so clients that failed
+// together (e.g. after an outage) come back spread out instead of in
+// lockstep. A Retry-After from a 429 or 503 is honoured, plus a little
+// jitter.
+//
+// Each host also has a circuit breaker. After failureThreshold consecutive
+// failures that say the host itself is unwell (no connection, timeouts,
+// 500/502/504, 429/503), or one 429/503 with Retry-After, the circuit
+// opens: allowRequest() refuses new work for that host for openTime. Then
+// one probe is let through; success closes the circuit, failure opens it
+// again for twice as long, up to maxOpenTime.
+//
+// Settings: network/retryBaseDelay (default 1000 ms), network/retryMaxDelay
+// (default 60000 ms), network/circuitFailureThreshold (default 5),
+// network/circuitOpenTime (default 30000 ms), network/circuitMaxOpenTime
+// (default 300000 ms). Must be used from the GUI thread.
+class RetryPolicy
+{
+public:
+    static RetryPolicy* instance();
+
+    // Classifies the finished reply and feeds the outcome to its host's circuit
+    RequestFailure record(const QNetworkReply *reply);
+    static RequestFailure classify(const QNetworkReply *reply);
+
+    // Wait before attempt number attempt (1-based) after failure, in ms
+    qint64 retryDelay(const RequestFailure &failure, int attempt, const QUrl &url) const;
+
+    // False while the host's circuit is open, or half-open with its probe out
+    bool allowRequest(const QUrl &url);
+    // ms until allowRequest() may say yes again; 0 if it would now
+    qint64 blockedFor(const QUrl &url) const;
+
+private:
+    enum CircuitState {
+        Closed,
+        Open,
+        HalfOpen
+    };
+
+    struct Circuit {
+        CircuitState state;
+        int failures; // consecutive, while closed
+        qint64 openTime; // ms the last opening lasts
+        QElapsedTimer since; // opened, or probe sent
+        bool probing;
+
+        Circuit() : state(Closed), failures(0), openTime(0), probing(false) {}
+    };
+
+    RetryPolicy();
+
+    RetryPolicy(const RetryPolicy&) = delete;
+    RetryPolicy& operator=(const RetryPolicy&) = delete;
+
+    static QString hostKey(const QUrl &url);
+    static qint64 parseRetryAfter(const QByteArray &value);
+    static bool isHostFailure(const RequestFailure &failure);
+
+    void open(Circuit &circuit, qint64 openTime);
+
+    qint64 m_baseDelay;
+    qint64 m_maxDelay;
+    int m_failureThreshold;
+    qint64 m_openTime;
+    qint64 m_maxOpenTime;
+    QHash<QString, Circuit> m_circuits; // scheme://host:port -> circuit
+
+    static const qint64 MAX_RETRY_AFTER;
+};
+
+#endif // RETRYPOLICY_H
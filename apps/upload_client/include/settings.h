@@ -31,8 +31,14 @@ public:
     void setMaxConcurrentUploads(int max);
     int getChunkSize() const;
     void setChunkSize(int size);
+    qint64 getStreamBufferSize() const;
+    void setStreamBufferSize(qint64 size);
+    qint64 getMemoryBudget() const;
+    void setMemoryBudget(qint64 bytes);
     int getMaxRetries() const;
     void setMaxRetries(int retries);
+    bool getDedupeEnabled() const;
+    void setDedupeEnabled(bool enabled);
     QString getUploadServerUrl() const;
     void setUploadServerUrl(const QString &url);
     
@@ -53,6 +59,8 @@ public:
     void setNetworkTimeout(int timeout);
     QString getNetworkServerUrl() const;
     void setNetworkServerUrl(const QString &url);
+    qint64 getBandwidthLimit() const;
+    void setBandwidthLimit(qint64 bytesPerSecond);
     
     // UI settings
     QSize getWindowSize() const;
@@ -104,6 +112,8 @@ private:
     static const QString DEFAULT_SERVER_URL;
     static const int DEFAULT_MAX_CONCURRENT_UPLOADS;
     static const int DEFAULT_CHUNK_SIZE;
+    static const qint64 DEFAULT_STREAM_BUFFER_SIZE;
+    static const qint64 DEFAULT_MEMORY_BUDGET;
     static const int DEFAULT_MAX_RETRIES;
     static const int DEFAULT_SYNC_INTERVAL;
     static const int DEFAULT_NETWORK_TIMEOUT;
@@ -0,0 +1,36 @@
+#ifndef STORAGEQUOTA_H
+#define STORAGEQUOTA_H
+
+#include <QtGlobal>
+
+// The user's remaining storage as the server last reported it, less the
+// space reserved for uploads this client has planned since. A file is
+// reserved before its first byte is sent; one that does not fit is held
+// back instead of being sent only to be refused once the server has
+// received all of it. A reservation stays taken when its upload completes
+// (the server counts the file from then on) and is given back when the
+// upload fails or turns out to be a duplicate.
+//
+// The server's figure is fetched once per run, so uploads from elsewhere
+// in the meantime are not seen; the server still checks every upload.
+// Until a figure is set the quota is unknown and every file fits.
+class StorageQuota
+{
+public:
+    StorageQuota();
+
+    void setRemaining(qint64 bytes); // from the server; drops earlier reservations
+    void clear();
+    bool isKnown() const;
+    qint64 remaining() const; // after reservations; -1 if unknown
+    qint64 reserved() const;
+
+    bool reserve(qint64 bytes); // false, and nothing reserved, if it does not fit
+    void release(qint64 bytes);
+
+private:
+    qint64 m_remaining; // -1 if unknown
+    qint64 m_reserved;
+};
+
+#endif // STORAGEQUOTA_H
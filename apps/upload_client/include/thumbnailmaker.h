@@ -0,0 +1,76 @@
+#ifndef THUMBNAILMAKER_H
+#define THUMBNAILMAKER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QQueue>
+#include <QSet>
+#include <QThreadPool>
+#include <QUrl>
+
+// Makes JPEG thumbnails of uploaded images on a worker pool and sends them
+// to the server, which stores them as they are instead of decoding the
+// image itself. The image is read at the largest thumbnail size straight
+// away; JPEG decodes at that reduced scale, so a large photo is never held
+// at full resolution. Other formats are decoded, then scaled. Smaller sizes
+// are scaled down from the largest.
+//
+// A job draws the memory of its decoded thumbnail from MemoryBudget and
+// waits in line while the budget is spent. Thumbnails are best effort: an
+// image that cannot be decoded, or a request that fails, leaves the media
+// without thumbnails and nothing else.
+//
+// All public methods must be called from the GUI thread.
+class ThumbnailMaker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ThumbnailMaker* instance();
+
+    // Enabled, supported by the server, and an image format Qt can read
+    bool isCandidate(const QString &filePath) const;
+
+    // Makes the thumbnails of the file, then POSTs them to url (the
+    // thumbnails endpoint of the media the file was uploaded as)
+    void attach(const QString &filePath, const QUrl &url, const QString &authToken);
+
+    void setSizes(const QList<int> &sizes);
+    QList<int> sizes() const; // longest edge in pixels, largest first
+    void setQuality(int quality);
+    int quality() const;
+
+    // Worker side: JPEG data, largest first; empty if the image cannot be read
+    static QList<QByteArray> makeThumbnails(const QString &filePath, const QList<int> &sizes, int quality);
+
+private:
+    explicit ThumbnailMaker(QObject *parent = nullptr);
+    ~ThumbnailMaker();
+
+    ThumbnailMaker(const ThumbnailMaker&) = delete;
+    ThumbnailMaker& operator=(const ThumbnailMaker&) = delete;
+
+    struct Job {
+        QString filePath;
+        QUrl url;
+        QString authToken;
+    };
+
+    qint64 jobMemory() const;
+    void dispatch();
+    void start(const Job &job);
+    void send(const Job &job, const QList<QByteArray> &thumbnails);
+
+    QThreadPool m_pool;
+    QQueue<Job> m_waiting; // for memory, in order
+    QSet<QString> m_suffixes; // readable image formats, lower case
+    QList<int> m_sizes;
+    int m_quality;
+    bool m_enabled;
+    bool m_supported; // cleared when the server has no thumbnails endpoint
+
+    static const int MAX_THUMBNAILS; // server limit per media
+};
+
+#endif // THUMBNAILMAKER_H
@@ -0,0 +1,63 @@
+#ifndef UPDATECOALESCER_H
+#define UPDATECOALESCER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QPair>
+#include <QString>
+#include <QTimer>
+
+// Latest known state of one item; fields that did not change are left unset.
+// The key is whatever the owner addresses its items by: a row index for
+// UploadManager, a stable item ID for FolderSync.
+struct ItemUpdate {
+    quint64 key;
+    int progress; // -1 if unchanged
+    QString status; // null if unchanged
+
+    ItemUpdate() : key(0), progress(-1) {}
+};
+
+struct ItemUpdateBatch {
+    QList<ItemUpdate> items; // ascending key, one entry per changed item
+    QList<QPair<quint64, quint64>> ranges; // first and last key of each run of consecutive keys
+};
+
+Q_DECLARE_METATYPE(ItemUpdateBatch)
+
+// Collects per-row progress and status changes and publishes them as one
+// batch at most once per interval(), so thousands of transfers updating at
+// once cost the GUI one signal per frame instead of one per change. Later
+// changes to a row overwrite earlier ones that were not published yet.
+class UpdateCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UpdateCoalescer(QObject *parent = nullptr);
+
+    void setInterval(int msec);
+    int interval() const;
+
+    void setProgress(quint64 key, int progress);
+    void setStatus(quint64 key, const QString &status);
+    void reset(); // drop unpublished changes, e.g. when the rows go away
+
+public slots:
+    void flush();
+
+signals:
+    void batchReady(const ItemUpdateBatch &batch);
+
+private:
+    ItemUpdate& pending(quint64 key);
+
+    QHash<quint64, ItemUpdate> m_pending;
+    QTimer m_timer;
+
+    static const int DEFAULT_INTERVAL;
+};
+
+#endif // UPDATECOALESCER_H
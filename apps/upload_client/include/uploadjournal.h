@@ -0,0 +1,76 @@
+#ifndef UPLOADJOURNAL_H
+#define UPLOADJOURNAL_H
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QJsonObject>
+#include <QTimer>
+
+struct JournalEntry {
+    QString filePath;
+    qint64 fileSize;
+    qint64 lastModified; // ms since epoch, used to detect files changed while offline
+    QString status;
+    QString uploadId;
+    qint64 uploadedBytes;
+    int priority;
+    qint64 sequence; // insertion order, preserved across compaction
+
+    JournalEntry() : fileSize(0), lastModified(0), uploadedBytes(0), priority(0), sequence(0) {}
+};
+
+// Append-only JSON-lines log of the upload queue. Records are buffered in
+// memory and written in one batch per flush interval, so callers on the
+// upload path never touch the disk. The log is rewritten from the live
+// entries once it has grown well past them.
+class UploadJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UploadJournal(const QString &journalPath, QObject *parent = nullptr);
+    ~UploadJournal();
+
+    // Reads the journal and returns the live entries in queue order. A torn
+    // last line from a crash mid-write is ignored.
+    QList<JournalEntry> replay();
+
+    void recordAdded(const QString &filePath, qint64 fileSize, qint64 lastModified);
+    void recordState(const QString &filePath, const QString &status,
+                     const QString &uploadId, qint64 uploadedBytes);
+    void recordPriority(const QString &filePath, int priority);
+    void recordRemoved(const QString &filePath);
+    void recordCleared();
+
+    void setFlushInterval(int msec);
+    QString journalPath() const;
+
+public slots:
+    void flush();
+    void compact();
+
+private:
+    void append(const QJsonObject &record);
+    void apply(const QJsonObject &record);
+    bool openForAppend();
+
+    QString m_journalPath;
+    QFile m_file;
+    QTimer m_flushTimer;
+
+    // Live view of the journal, kept so compaction never needs the caller
+    QHash<QString, JournalEntry> m_entries;
+    qint64 m_nextSequence;
+
+    // Records waiting for the next flush; state updates for the same file coalesce
+    QList<QJsonObject> m_pending;
+    QHash<QString, int> m_pendingState;
+    qint64 m_recordsOnDisk;
+
+    static const int DEFAULT_FLUSH_INTERVAL;
+    static const qint64 COMPACT_MIN_RECORDS;
+};
+
+#endif // UPLOADJOURNAL_H
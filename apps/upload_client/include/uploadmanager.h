@@ -7,10 +7,43 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QQueue>
+#include <QHash>
+#include <QSet>
 #include <QMutex>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QUrl>
+#include "chunkencoder.h"
+#include "chunksizer.h"
+#include "mediaprobe.h"
+#include "uploadscheduler.h"
+#include "updatecoalescer.h"
+#include "retrypolicy.h"
+#include "storagequota.h"
+
+class UploadJournal;
+struct PreprocessResult;
+
+// Request an item is currently waiting on. Each file is first hashed and
+// checked against the server; files larger than one chunk then go through a
+// resumable session: create -> (query offset) -> chunks -> complete. In a
+// direct session the chunks are parts PUT straight to object storage through
+// presigned URLs, several at once and in any order: create -> (query offset)
+// -> parts -> complete. Small files are bundled with others into one batch
+// request instead.
+enum class UploadPhase {
+    Hashing,
+    DedupeCheck,
+    Multipart,
+    Batched,
+    CreateSession,
+    QueryOffset,
+    SendChunk,
+    SendParts,
+    CompleteSession
+};
 
 struct UploadItem {
     QString filePath;
@@ -18,10 +51,40 @@ struct UploadItem {
     qint64 fileSize;
     QString status;
     int progress;
-    QFile *file;
+    int retries;
+    int priority; // user set; higher goes first, see UploadScheduler
+    
+    // Resumable session state, kept across pause and retry
+    UploadPhase phase;
+    QString uploadId;
+    qint64 uploadedBytes; // last offset acknowledged by the server
+    qint64 sentBytes; // file bytes counted toward overall progress
+    
+    // Direct sessions: the server fixes the part layout and signs the part URLs
+    bool direct;
+    qint64 partSize;
+    QSet<int> partsDone; // parts storage holds, in any order
+    QHash<int, QUrl> partUrls; // part number -> presigned PUT URL
+    qint64 partUrlsExpiry; // ms since epoch, of the earliest URL held
+    
+    // Content hash used to skip files the server already has
+    QByteArray contentHash;
+    bool dedupeChecked;
+    
+    // Duration, resolution and codec from the container headers, sent with the upload
+    MediaInfo mediaInfo;
+    bool mediaProbed;
+    
+    qint64 reservedBytes; // storage quota held for this file, see StorageQuota
+    
+    bool batchable; // cleared once a batch could not take it; sent on its own from then on
     
-    UploadItem() : fileSize(0), progress(0), file(nullptr) {}
-    UploadItem(const QString &path) : filePath(path), file(nullptr) {
+    // Chunks are deflated if the first one showed the file compresses well
+    bool compressionProbed;
+    bool compressChunks;
+    
+    UploadItem() : fileSize(0), progress(0), retries(0), priority(0), phase(UploadPhase::Multipart), uploadedBytes(0), sentBytes(0), direct(false), partSize(0), partUrlsExpiry(0), dedupeChecked(false), mediaProbed(false), reservedBytes(0), batchable(true), compressionProbed(false), compressChunks(false) {}
+    UploadItem(const QString &path) : filePath(path), retries(0), priority(0), phase(UploadPhase::Multipart), uploadedBytes(0), sentBytes(0), direct(false), partSize(0), partUrlsExpiry(0), dedupeChecked(false), mediaProbed(false), reservedBytes(0), batchable(true), compressionProbed(false), compressChunks(false) {
         QFileInfo info(path);
         fileName = info.fileName();
         fileSize = info.size();
@@ -49,54 +112,193 @@ public:
     
     void setAuthToken(const QString &token);
     void setServerUrl(const QString &url);
-    void addFile(const QString &filePath);
+    void addFile(const QString &filePath, int priority = 0);
     void addFolder(const QString &folderPath);
     void startUpload();
     void pauseUpload();
     void resumeUpload();
     void clearQueue();
+    void setItemPriority(int index, int priority);
     
     QList<UploadItem> getQueue() const;
     bool isUploading() const;
+    qint64 totalBytes() const;
+    qint64 transferredBytes() const; // completed files plus bytes sent of the rest
+    ChunkStats chunkStats() const;
 
 signals:
     void uploadProgress(int progress);
     void uploadFinished();
     void uploadError(const QString &error);
-    void itemProgressChanged(int index, int progress);
-    void itemStatusChanged(int index, const QString &status);
+    void itemsChanged(const ItemUpdateBatch &batch); // coalesced, at most once per ui/updateInterval
+    void chunkStatsChanged(const ChunkStats &stats);
 
 private slots:
     void processNextUpload();
     void onUploadProgress(qint64 bytesSent, qint64 bytesTotal);
     void onUploadFinished();
     void onNetworkError(QNetworkReply::NetworkError error);
+    void onFileProcessed(const PreprocessResult &result);
+    void onBatchTimeout();
+    void onChunkEncoded(const EncodedChunk &chunk);
 
 private:
     void scanFolder(const QString &folderPath);
-    void createMultipartRequest(const UploadItem &item);
+    void enqueueItem(const UploadItem &item);
+    void restoreFromJournal();
+    void journalItemState(int index);
+    void abortActiveUploads();
+    void enqueuePending(int index);
+    void queuePending();
+    void fetchQuota();
+    bool reserveQuota(int index);
+    void reportHeldBack();
+    bool needsHash(const UploadItem &item) const;
+    void prefetchNext();
+    void releasePreprocessed(int index);
+    bool startItemUpload(int index);
+    void completeItem(int index, const QJsonObject &media = QJsonObject());
+    int activeSlots() const;
+    bool isBatchable(const UploadItem &item) const;
+    void addToBatch(int index);
+    bool batchReady() const;
+    void flushBatch();
+    void returnBatchItems(const QList<int> &indices, bool batchable);
+    void onBatchFinished(QNetworkReply *reply);
+    void startParts(int index);
+    void pumpParts(int index);
+    void onPartFinished(QNetworkReply *reply);
+    void retryPart(int index, int partNumber);
+    void failParts(int index, const RequestFailure &failure);
+    void settleParts(int index);
+    void retryItem(int index, const RequestFailure &failure);
+    QNetworkReply* createMultipartRequest(const UploadItem &item);
+    QNetworkReply* createPhaseRequest(const UploadItem &item);
+    QNetworkReply* createChunkRequest(const UploadItem &item, const EncodedChunk *encoded = nullptr);
+    QNetworkReply* createPresignRequest(const UploadItem &item, const QList<int> &partNumbers);
+    QNetworkReply* createPartRequest(const UploadItem &item, int partNumber);
+    int nextPartNumber(const UploadItem &item) const;
+    int partCount(const UploadItem &item) const;
+    qint64 partLength(const UploadItem &item, int partNumber) const;
+    bool hasPartUrl(const UploadItem &item, int partNumber) const;
+    void clearSession(UploadItem &item);
+    qint64 nextChunkLength(const UploadItem &item);
+    bool shouldCompress(const UploadItem &item) const;
+    void startChunkEncode(int index);
+    QNetworkRequest createApiRequest(const QString &path) const;
+    void connectReply(QNetworkReply *reply);
+    bool isChunked(const UploadItem &item) const;
+    bool advanceUpload(UploadItem &item, const QJsonObject &response);
+    ChunkSizer& chunkSizerFor(const QString &filePath);
+    void recordChunkResult(QNetworkReply *reply, const UploadItem &item, bool acknowledged);
+    void finishIfIdle();
     void updateItemProgress(int index, int progress);
+    void setItemSentBytes(int index, qint64 bytes);
+    void markItemCompleted(int index);
+    void updateOverallProgress();
     void updateItemStatus(int index, const QString &status);
     
     // Network
-    QNetworkAccessManager *m_networkManager;
-    QNetworkReply *m_currentReply;
+    QNetworkAccessManager *m_networkManager; // NetworkTransport::instance(), not owned
+    QHash<QNetworkReply*, int> m_activeUploads; // reply -> queue index
+    QMultiHash<QString, int> m_hashingItems; // file path -> queue index, holds a slot while hashing
     QString m_authToken;
     QString m_serverUrl;
     
+    // Chunk sizing: one estimator per transfer, seeded from the latest measurements
+    struct ChunkTiming {
+        QElapsedTimer timer;
+        qint64 bytes;
+        qint64 sentMsec; // -1 until the whole body has been handed to the socket
+        
+        ChunkTiming() : bytes(0), sentMsec(-1) {}
+    };
+    QHash<QNetworkReply*, ChunkTiming> m_chunkTimings;
+    QHash<QString, ChunkSizer> m_chunkSizers; // file path -> estimator
+    ChunkSizer m_chunkSizer;
+    
+    // Transport compression; an item holds its slot while its next chunk is compressed
+    ChunkEncoder *m_encoder;
+    QHash<QString, int> m_encodingItems; // file path -> queue index
+    
+    // Small-file batching: items collect in m_batchBuffer without holding a
+    // slot, then go out together as one request that holds a single slot
+    struct UploadBatch {
+        QList<int> indices; // queue indices, in body order
+        QList<qint64> offsets; // start of each file in the request body
+        QList<qint64> sizes;
+        int sentCursor; // items before this one are fully sent
+        
+        UploadBatch() : sentCursor(0) {}
+    };
+    QHash<QNetworkReply*, UploadBatch> m_activeBatches;
+    
+    // Direct sessions send up to m_partConcurrency parts of one file at once
+    // over separate connections. The item holds a single slot meanwhile; a
+    // failed part is retried on its own while the others carry on.
+    struct PartUpload {
+        QHash<int, qint64> inFlight; // part number -> bytes on the wire
+        QSet<int> waiting; // failed parts sitting out their retry delay
+        QHash<int, int> retries; // part number -> attempts failed
+        qint64 doneBytes; // bytes of partsDone
+        bool presigning;
+        bool failed; // the whole item gives up once nothing is in flight
+        RequestFailure failure; // why, when failed
+        
+        PartUpload() : doneBytes(0), presigning(false), failed(false) {}
+    };
+    struct PartTransfer {
+        int index;
+        int partNumber; // 0 for the request signing more part URLs
+    };
+    QHash<int, PartUpload> m_partUploads; // queue index -> state
+    QHash<QNetworkReply*, PartTransfer> m_activeParts;
+    QList<int> m_batchBuffer;
+    qint64 m_batchBufferBytes;
+    QTimer *m_batchTimer;
+    bool m_batchDue; // linger time of the oldest buffered item has passed
+    
+    QTimer *m_circuitTimer; // wakes the pool once the server's circuit half-opens
+    
+    // Remaining storage, fetched once per run; files that do not fit are held back
+    StorageQuota m_quota;
+    QNetworkReply *m_quotaReply; // the run waits for it before anything is queued
+    int m_heldFiles; // held back since the last warning
+    qint64 m_heldBytes;
+    
     // Upload queue
     QQueue<UploadItem> m_uploadQueue;
+    UploadScheduler m_scheduler; // items waiting for a slot
     QMutex m_queueMutex;
-    int m_currentIndex;
     bool m_isUploading;
     bool m_isPaused;
+    int m_scheduledRetries;
+    quint64 m_queueGeneration;
+    UploadJournal *m_journal;
+    UpdateCoalescer *m_updates;
+    bool m_resumeOnAuth; // journal held transfers that were running at shutdown
+    
+    // Overall progress, kept up to date incrementally so a tick is O(1)
+    qint64 m_totalBytes; // every queued file
+    qint64 m_sentBytes; // sentBytes of files not yet completed
+    qint64 m_completedBytes;
+    int m_overallProgress;
     
     // Settings
     int m_maxConcurrentUploads;
-    int m_chunkSize;
-    QTimer *m_retryTimer;
+    qint64 m_chunkSize;
+    qint64 m_streamBufferSize;
     int m_maxRetries;
-    int m_currentRetries;
+    bool m_dedupeEnabled;
+    bool m_compressionEnabled;
+    bool m_directUploads;
+    int m_partConcurrency;
+    bool m_batchEnabled;
+    bool m_quotaEnabled;
+    int m_batchMinFiles;
+    int m_batchMaxFiles;
+    qint64 m_batchMaxBytes;
+    qint64 m_batchMaxFileSize;
 };
 
 #endif // UPLOADMANAGER_H
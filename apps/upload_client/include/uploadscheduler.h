@@ -0,0 +1,63 @@
+#ifndef UPLOADSCHEDULER_H
+#define UPLOADSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <set>
+#include <utility>
+
+// Decides which queued item gets the next upload slot. Every item gets a
+// virtual deadline when it is queued:
+//
+//     enqueue time + lane delay - priority * priorityStep
+//
+// and the earliest deadline goes first. Small files have no lane delay, so
+// they overtake large ones queued at about the same time; large files pay
+// largeFileDelay() once, so after waiting that long they are ahead of any
+// small file queued later and cannot be starved. Each user priority step
+// moves an item priorityStep() ahead.
+//
+// Deadlines are fixed at enqueue time, so ageing needs no rescans: every
+// operation is O(log n) in the number of queued items.
+class UploadScheduler
+{
+public:
+    UploadScheduler();
+
+    void setSmallFileThreshold(qint64 bytes);
+    qint64 smallFileThreshold() const;
+    void setLargeFileDelay(qint64 msec);
+    qint64 largeFileDelay() const;
+    void setPriorityStep(qint64 msec);
+    qint64 priorityStep() const;
+
+    // Queuing an index that is already queued moves it
+    void enqueue(int index, qint64 fileSize, int priority);
+    // Ahead of everything else, e.g. to resume an interrupted item first
+    void enqueueFront(int index);
+    void setPriority(int index, qint64 fileSize, int priority);
+    void remove(int index);
+
+    int takeNext(); // -1 if empty
+    int peekNext() const; // -1 if empty
+    bool contains(int index) const;
+    bool isEmpty() const;
+    int size() const;
+    void clear();
+
+private:
+    using Key = std::pair<qint64, int>; // deadline, then queue index to keep order stable
+
+    void insert(int index, qint64 deadline);
+
+    std::set<Key> m_order;
+    QHash<int, qint64> m_deadlines; // queue index -> deadline in m_order
+    QHash<int, qint64> m_enqueuedAt;
+    QElapsedTimer m_clock;
+
+    qint64 m_smallFileThreshold;
+    qint64 m_largeFileDelay;
+    qint64 m_priorityStep;
+};
+
+#endif // UPLOADSCHEDULER_H
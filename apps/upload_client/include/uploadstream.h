@@ -0,0 +1,92 @@
+#ifndef UPLOADSTREAM_H
+#define UPLOADSTREAM_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QList>
+#include <QJsonObject>
+#include <QHash>
+
+// Read-only request body built from in-memory segments (multipart headers,
+// metadata) and file ranges. File data comes from ReadAheadPool: while one
+// block is being sent, the blocks up to bufferSize() bytes further into the
+// file are read on the I/O pool, so memory stays bounded no matter how large
+// the file is. When the next block is not in memory yet readData() returns 0
+// and readyRead() follows once it is, the same way reads are paced by
+// BandwidthLimiter when a bandwidth limit is set.
+class UploadStream : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit UploadStream(QObject *parent = nullptr);
+    ~UploadStream();
+
+    // Budgeted data, e.g. a compressed chunk, counts against MemoryBudget
+    // until the stream is destroyed
+    void appendData(const QByteArray &data, bool budgeted = false);
+    bool appendFile(const QString &filePath, qint64 offset = 0, qint64 length = -1);
+
+    // How far past the read position file data is prefetched
+    void setBufferSize(qint64 size);
+    qint64 bufferSize() const;
+    QString errorFilePath() const;
+
+    // Builds a multipart/form-data body with a "metadata" JSON part (if any),
+    // one plain text part per entry in fields, then a streamed "file" part.
+    // Returns nullptr if the file cannot be read.
+    static UploadStream* createMultipart(const QString &filePath, const QString &fileName,
+                                         const QJsonObject &metadata,
+                                         const QHash<QString, QString> &fields = QHash<QString, QString>(),
+                                         QObject *parent = nullptr);
+    QByteArray boundary() const;
+    QByteArray contentType() const;
+
+    // QIODevice interface
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override;
+    qint64 size() const override;
+    bool seek(qint64 pos) override;
+    bool reset() override;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    struct Segment {
+        QByteArray data;
+        QString filePath;
+        qint64 fileOffset;
+        qint64 fileSize;
+        qint64 length;
+        qint64 start;
+
+        Segment() : fileOffset(0), fileSize(0), length(0), start(0) {}
+    };
+
+    int segmentAt(qint64 pos) const;
+    bool isBuffered(int index) const;
+    int loadBlock(int index, qint64 segmentPos); // 1 loaded, 0 not read yet, -1 error
+    void prefetch(int index, qint64 fileOffset);
+    void onBlockReady(const QString &filePath, qint64 offset);
+
+    QList<Segment> m_segments;
+    qint64 m_size;
+    qint64 m_position;
+    QByteArray m_boundary;
+    QString m_errorFilePath;
+    qint64 m_budgetedBytes;
+
+    // Block of the file segment currently being streamed
+    int m_fileSegment;
+    QByteArray m_buffer;
+    qint64 m_bufferStart;
+    qint64 m_bufferSize;
+    qint64 m_waitingOffset; // file offset of the block readData() waits for, or -1
+
+    static const qint64 DEFAULT_BUFFER_SIZE;
+};
+
+#endif // UPLOADSTREAM_H
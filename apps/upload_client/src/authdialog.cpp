@@ -1,4 +1,5 @@
 #include "authdialog.h"
+#include "networktransport.h"
 #include <QSettings>
 #include <QMessageBox>
 #include <QApplication>
@@ -21,8 +22,8 @@ AuthDialog::AuthDialog(QWidget *parent)
     m_usernameEdit->setText(settings.value("auth/username").toString());
     m_rememberMeCheck->setChecked(settings.value("auth/rememberMe", false).toBool());
     
-    // Initialize network manager
-    m_networkManager = new QNetworkAccessManager(this);
+    // Shared with the rest of the app, so the login connection is reused for uploads
+    m_networkManager = NetworkTransport::instance();
     
     setWindowTitle("Login - Upload Client");
     setModal(true);
@@ -0,0 +1,164 @@
+#include "bandwidthlimiter.h"
+#include "settings.h"
+#include <QIODevice>
+
+const int BandwidthLimiter::REFILL_INTERVAL = 50; // 50ms
+const int BandwidthLimiter::BURST_MSEC = 200; // bucket holds 200ms of traffic
+const qint64 BandwidthLimiter::MIN_GRANT = 4096; // 4KB
+
+BandwidthLimiter* BandwidthLimiter::instance()
+{
+    static BandwidthLimiter instance;
+    return &instance;
+}
+
+BandwidthLimiter::BandwidthLimiter(QObject *parent)
+    : QObject(parent)
+    , m_rate(0)
+    , m_tokens(0)
+{
+    m_refillTimer.setInterval(REFILL_INTERVAL);
+    connect(&m_refillTimer, &QTimer::timeout, this, &BandwidthLimiter::refill);
+
+    connect(Settings::instance(), &Settings::settingsChanged,
+            this, &BandwidthLimiter::onSettingsChanged);
+    setRateLimit(Settings::instance()->getBandwidthLimit());
+}
+
+BandwidthLimiter::~BandwidthLimiter()
+{
+}
+
+void BandwidthLimiter::setRateLimit(qint64 bytesPerSecond)
+{
+    bytesPerSecond = qMax<qint64>(0, bytesPerSecond);
+    if (bytesPerSecond == m_rate) {
+        return;
+    }
+
+    m_rate = bytesPerSecond;
+    m_tokens = 0;
+    m_clock.start();
+
+    // Shares handed out under the old rate are void; everyone asks again
+    for (auto it = m_credit.begin(); it != m_credit.end(); ++it) {
+        it.value() = 0;
+    }
+    wakeAll();
+
+    if (m_rate == 0) {
+        m_refillTimer.stop();
+        m_credit.clear();
+    }
+}
+
+qint64 BandwidthLimiter::rateLimit() const
+{
+    return m_rate;
+}
+
+bool BandwidthLimiter::isLimited() const
+{
+    return m_rate > 0;
+}
+
+qint64 BandwidthLimiter::acquire(QIODevice *device, qint64 maxBytes)
+{
+    if (m_rate == 0 || maxBytes <= 0) {
+        return maxBytes;
+    }
+
+    qint64 &credit = m_credit[device];
+    if (credit > 0) {
+        qint64 granted = qMin(credit, maxBytes);
+        credit -= granted;
+        return granted;
+    }
+
+    // Nobody queued ahead: take a fair slice of what has accumulated
+    topUp();
+    if (m_waiting.isEmpty() && m_tokens > 0) {
+        qint64 slice = qMax(MIN_GRANT, m_tokens / m_credit.size());
+        qint64 granted = qMin(qMin(slice, m_tokens), maxBytes);
+        m_tokens -= granted;
+        return granted;
+    }
+
+    if (!m_waiting.contains(device)) {
+        m_waiting.append(device);
+    }
+    if (!m_refillTimer.isActive()) {
+        m_refillTimer.start();
+    }
+    return 0;
+}
+
+void BandwidthLimiter::release(QIODevice *device)
+{
+    auto it = m_credit.find(device);
+    if (it == m_credit.end()) {
+        return;
+    }
+
+    m_tokens = qMin(burstSize(), m_tokens + it.value());
+    m_credit.erase(it);
+    m_waiting.removeOne(device);
+}
+
+void BandwidthLimiter::refill()
+{
+    if (m_rate == 0 || m_waiting.isEmpty()) {
+        m_refillTimer.stop();
+        return;
+    }
+
+    topUp();
+    if (m_tokens < MIN_GRANT) {
+        return;
+    }
+
+    // Even split between waiting devices; the order rotates as they re-queue
+    QList<QIODevice*> waiting;
+    waiting.swap(m_waiting);
+    qint64 share = m_tokens / waiting.size();
+    for (QIODevice *device : waiting) {
+        m_credit[device] += share;
+        m_tokens -= share;
+    }
+    for (QIODevice *device : waiting) {
+        emit device->readyRead();
+    }
+}
+
+void BandwidthLimiter::onSettingsChanged(const QString &group, const QString &key, const QVariant &value)
+{
+    if (group == "network" && key == "bandwidthLimit") {
+        setRateLimit(value.toLongLong());
+    } else if (group.isEmpty() || (group == "network" && key.isEmpty())) {
+        setRateLimit(0); // settings were cleared
+    }
+}
+
+void BandwidthLimiter::topUp()
+{
+    qint64 added = m_rate * m_clock.elapsed() / 1000;
+    if (added <= 0) {
+        return; // keep the clock running so slow rates still add up
+    }
+    m_clock.restart();
+    m_tokens = qMin(burstSize(), m_tokens + added);
+}
+
+qint64 BandwidthLimiter::burstSize() const
+{
+    return qMax(MIN_GRANT, m_rate * BURST_MSEC / 1000);
+}
+
+void BandwidthLimiter::wakeAll()
+{
+    QList<QIODevice*> waiting;
+    waiting.swap(m_waiting);
+    for (QIODevice *device : waiting) {
+        emit device->readyRead();
+    }
+}
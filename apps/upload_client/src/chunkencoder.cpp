@@ -0,0 +1,135 @@
+#include "chunkencoder.h"
+#include "memorybudget.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+const qint64 ChunkEncoder::PROBE_SIZE = 64 * 1024;
+const qint64 ChunkEncoder::MAX_CHUNK_SIZE = 8 * 1024 * 1024; // bounds memory and time per job
+const double ChunkEncoder::MAX_RATIO = 0.9; // must save at least 10% to be worth it
+
+ChunkEncoder::ChunkEncoder(QObject *parent)
+    : QObject(parent)
+    , m_level(1)
+{
+    qRegisterMetaType<EncodedChunk>("EncodedChunk");
+
+    // Compression shares the CPU with hashing; half the cores keep up with any uplink
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+
+    connect(MemoryBudget::instance(), &MemoryBudget::memoryAvailable, this, &ChunkEncoder::dispatch);
+}
+
+ChunkEncoder::~ChunkEncoder()
+{
+    m_pool.waitForDone();
+}
+
+void ChunkEncoder::setLevel(int level)
+{
+    m_level = qBound(1, level, 9);
+}
+
+int ChunkEncoder::level() const
+{
+    return m_level;
+}
+
+void ChunkEncoder::setExtensions(const QStringList &extensions)
+{
+    m_extensions.clear();
+    for (const QString &extension : extensions) {
+        QString normalized = extension.trimmed().toLower();
+        if (normalized.isEmpty()) {
+            continue;
+        }
+        if (!normalized.startsWith('.')) {
+            normalized.prepend('.');
+        }
+        m_extensions.append(normalized);
+    }
+}
+
+QStringList ChunkEncoder::extensions() const
+{
+    return m_extensions;
+}
+
+bool ChunkEncoder::isCandidate(const QString &filePath) const
+{
+    return m_extensions.contains("." + QFileInfo(filePath).suffix().toLower());
+}
+
+qint64 ChunkEncoder::maxChunkSize() const
+{
+    return MAX_CHUNK_SIZE;
+}
+
+void ChunkEncoder::encode(const QString &filePath, qint64 offset, qint64 length, bool probe)
+{
+    m_waiting.enqueue(Job{filePath, offset, length, probe});
+    dispatch();
+}
+
+void ChunkEncoder::dispatch()
+{
+    while (!m_waiting.isEmpty() && MemoryBudget::instance()->tryAcquire(2 * m_waiting.head().length)) {
+        start(m_waiting.dequeue());
+    }
+}
+
+void ChunkEncoder::start(const Job &job)
+{
+    int level = m_level;
+    m_pool.start([this, job, level]() {
+        EncodedChunk chunk = process(job.filePath, job.offset, job.length, job.probe, level);
+        QMetaObject::invokeMethod(this, [this, chunk]() {
+            // The raw bytes are gone; whoever keeps the compressed ones counts them
+            MemoryBudget::instance()->release(2 * chunk.length);
+            emit chunkEncoded(chunk);
+        }, Qt::QueuedConnection);
+    });
+}
+
+EncodedChunk ChunkEncoder::process(const QString &filePath, qint64 offset, qint64 length,
+                                   bool probe, int level)
+{
+    EncodedChunk chunk;
+    chunk.filePath = filePath;
+    chunk.offset = offset;
+    chunk.length = length;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(offset)) {
+        chunk.readFailed = true;
+        return chunk;
+    }
+    QByteArray raw = file.read(length);
+    if (raw.size() != length) {
+        chunk.readFailed = true;
+        return chunk;
+    }
+
+    // A header-sized sample says enough about the rest of the file
+    if (probe && length > PROBE_SIZE) {
+        QByteArray sample = raw.left(PROBE_SIZE);
+        if (deflate(sample, level).size() > sample.size() * MAX_RATIO) {
+            chunk.compressible = false;
+            return chunk;
+        }
+    }
+
+    chunk.data = deflate(raw, level);
+    if (chunk.data.size() > raw.size() * MAX_RATIO) {
+        chunk.data.clear();
+        chunk.compressible = !probe;
+    }
+    return chunk;
+}
+
+QByteArray ChunkEncoder::deflate(const QByteArray &data, int level)
+{
+    // qCompress() emits a zlib stream behind a 4-byte length of its own
+    QByteArray compressed = qCompress(data, level);
+    return compressed.size() > 4 ? compressed.mid(4) : QByteArray();
+}
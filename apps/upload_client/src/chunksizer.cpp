@@ -0,0 +1,98 @@
+#include "chunksizer.h"
+#include <QtMath>
+
+const int ChunkSizer::RTT_MULTIPLE = 10; // round trip is at most ~10% of a chunk
+const qint64 ChunkSizer::SIZE_ALIGNMENT = 64 * 1024;
+
+ChunkSizer::ChunkSizer()
+    : m_minChunkSize(256 * 1024)
+    , m_maxChunkSize(64 * 1024 * 1024)
+    , m_targetDuration(2000) // 2 seconds
+    , m_chunkSize(1024 * 1024)
+    , m_throughput(0)
+    , m_goodput(0)
+    , m_rtt(0)
+    , m_samples(0)
+{
+}
+
+void ChunkSizer::setBounds(qint64 minChunkSize, qint64 maxChunkSize)
+{
+    m_minChunkSize = qMax<qint64>(SIZE_ALIGNMENT, minChunkSize);
+    m_maxChunkSize = qMax(m_minChunkSize, maxChunkSize);
+    m_chunkSize = qBound(m_minChunkSize, m_chunkSize, m_maxChunkSize);
+}
+
+void ChunkSizer::setTargetDuration(int msec)
+{
+    m_targetDuration = qMax(100, msec);
+}
+
+int ChunkSizer::targetDuration() const
+{
+    return m_targetDuration;
+}
+
+void ChunkSizer::setChunkSize(qint64 size)
+{
+    m_chunkSize = qBound(m_minChunkSize, size, m_maxChunkSize);
+}
+
+qint64 ChunkSizer::chunkSize() const
+{
+    return m_chunkSize;
+}
+
+void ChunkSizer::addSample(qint64 bytes, qint64 sendMsec, qint64 ackMsec)
+{
+    if (bytes <= 0) {
+        return;
+    }
+    sendMsec = qMax<qint64>(1, sendMsec);
+    ackMsec = qMax<qint64>(0, ackMsec);
+
+    double throughput = bytes * 1000.0 / sendMsec;
+    double goodput = bytes * 1000.0 / (sendMsec + ackMsec);
+    if (m_samples == 0) {
+        m_throughput = throughput;
+        m_goodput = goodput;
+        m_rtt = ackMsec;
+    } else {
+        m_throughput += (throughput - m_throughput) / 8;
+        m_goodput += (goodput - m_goodput) / 8;
+        m_rtt += (ackMsec - m_rtt) / 8;
+    }
+    m_samples++;
+
+    // Short chunks barely measure the link; let them grow before trusting the rate
+    if (bytes < m_chunkSize / 2) {
+        return;
+    }
+
+    double duration = qMax<double>(m_targetDuration, RTT_MULTIPLE * m_rtt);
+    qint64 desired = static_cast<qint64>(m_throughput * duration / 1000.0);
+    desired = qBound(m_chunkSize / 2, desired, m_chunkSize * 2);
+    m_chunkSize = qBound(m_minChunkSize, alignedSize(desired), m_maxChunkSize);
+}
+
+void ChunkSizer::addFailure()
+{
+    // A lost chunk is resent in full; make the next one cheaper to lose
+    m_chunkSize = qBound(m_minChunkSize, alignedSize(m_chunkSize / 2), m_maxChunkSize);
+}
+
+ChunkStats ChunkSizer::stats() const
+{
+    ChunkStats stats;
+    stats.chunkSize = m_chunkSize;
+    stats.goodput = qRound64(m_goodput);
+    stats.throughput = qRound64(m_throughput);
+    stats.rttMs = qRound64(m_rtt);
+    stats.samples = m_samples;
+    return stats;
+}
+
+qint64 ChunkSizer::alignedSize(qint64 size) const
+{
+    return qMax(SIZE_ALIGNMENT, (size / SIZE_ALIGNMENT) * SIZE_ALIGNMENT);
+}
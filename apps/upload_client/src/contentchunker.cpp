@@ -0,0 +1,139 @@
+#include "contentchunker.h"
+#include "memorybudget.h"
+#include <QCryptographicHash>
+#include <QFile>
+
+const qint64 ContentChunker::MIN_CHUNK_SIZE = 256 * 1024; // 256KB
+const qint64 ContentChunker::AVG_CHUNK_SIZE = 1024 * 1024; // 1MB
+const qint64 ContentChunker::MAX_CHUNK_SIZE = 4 * 1024 * 1024; // 4MB
+const qint64 ContentChunker::READ_BLOCK_SIZE = 4 * 1024 * 1024; // 4MB
+
+// Normalized chunking: a harder mask (more bits) before the average size and
+// an easier one after it, so chunk sizes cluster around the average. The
+// bits are the high ones, which depend on the last 64 bytes rolled in.
+static const quint64 MASK_HARD = 0xFFFFFC0000000000ULL; // 22 bits
+static const quint64 MASK_EASY = 0xFFFFC00000000000ULL; // 18 bits
+
+// Random values for each byte, from splitmix64 with a fixed seed so every
+// client cuts the same bytes in the same places
+static const quint64 *gearTable()
+{
+    static quint64 table[256];
+    static bool ready = [] {
+        quint64 state = 0x2545F4914F6CDD1DULL;
+        for (quint64 &value : table) {
+            state += 0x9E3779B97F4A7C15ULL;
+            quint64 z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            value = z ^ (z >> 31);
+        }
+        return true;
+    }();
+    Q_UNUSED(ready);
+    return table;
+}
+
+ContentChunker::ContentChunker(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<ChunkManifest>("ChunkManifest");
+    gearTable();
+
+    // One file at a time: it is the file being synced, and reads are sequential
+    m_pool.setMaxThreadCount(1);
+}
+
+ContentChunker::~ContentChunker()
+{
+    m_pool.waitForDone();
+}
+
+void ContentChunker::chunkFile(const QString &filePath)
+{
+    // Someone is waiting on this file, so it does not queue for memory
+    MemoryBudget::instance()->acquire(READ_BLOCK_SIZE);
+
+    m_pool.start([this, filePath]() {
+        ChunkManifest manifest = chunk(filePath);
+        QMetaObject::invokeMethod(this, [this, manifest]() {
+            MemoryBudget::instance()->release(READ_BLOCK_SIZE);
+            emit manifestReady(manifest);
+        }, Qt::QueuedConnection);
+    });
+}
+
+ChunkManifest ContentChunker::chunk(const QString &filePath)
+{
+    ChunkManifest manifest;
+    manifest.filePath = filePath;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        manifest.failed = true;
+        return manifest;
+    }
+
+    const quint64 *gear = gearTable();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QByteArray buffer(READ_BLOCK_SIZE, Qt::Uninitialized);
+    const uchar *data = reinterpret_cast<const uchar*>(buffer.constData());
+    qint64 position = 0; // file offset of buffer[0]
+    qint64 chunkStart = 0;
+    quint64 fingerprint = 0;
+    qint64 got;
+
+    while ((got = file.read(buffer.data(), buffer.size())) > 0) {
+        qint64 hashed = 0; // buffer bytes already added to the chunk hash
+        qint64 i = 0;
+        while (i < got) {
+            qint64 length = position + i - chunkStart;
+
+            // No cut inside the minimum size, so those bytes are not even looked at
+            if (length < MIN_CHUNK_SIZE) {
+                i += qMin(MIN_CHUNK_SIZE - length, got - i);
+                continue;
+            }
+
+            fingerprint = (fingerprint << 1) + gear[data[i]];
+            ++i;
+            ++length;
+
+            const quint64 mask = length < AVG_CHUNK_SIZE ? MASK_HARD : MASK_EASY;
+            if (!(fingerprint & mask) || length >= MAX_CHUNK_SIZE) {
+                hash.addData(QByteArrayView(buffer.constData() + hashed, i - hashed));
+                hashed = i;
+
+                ContentChunk chunk;
+                chunk.offset = chunkStart;
+                chunk.length = length;
+                chunk.hash = hash.result().toHex();
+                manifest.chunks.append(chunk);
+
+                hash.reset();
+                chunkStart = position + i;
+                fingerprint = 0;
+            }
+        }
+        hash.addData(QByteArrayView(buffer.constData() + hashed, got - hashed));
+        position += got;
+    }
+
+    if (got < 0) {
+        manifest.failed = true;
+        manifest.chunks.clear();
+        return manifest;
+    }
+
+    if (position > chunkStart) {
+        ContentChunk chunk;
+        chunk.offset = chunkStart;
+        chunk.length = position - chunkStart;
+        chunk.hash = hash.result().toHex();
+        manifest.chunks.append(chunk);
+    }
+
+    // What was read, in case the file changed size since it was queued
+    manifest.fileSize = position;
+    return manifest;
+}
@@ -1,28 +1,55 @@
 #include "foldersync.h"
+#include "uploadstream.h"
+#include "preprocesspool.h"
+#include "networktransport.h"
+#include "readaheadpool.h"
+#include "retrypolicy.h"
+#include "thumbnailmaker.h"
 #include <QDirIterator>
-#include <QHttpMultiPart>
-#include <QHttpPart>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMimeDatabase>
 #include <QSettings>
 #include <QApplication>
 #include <QStandardPaths>
 #include <QFileDialog>
 #include <QDateTime>
 
+static const int DELTA_CHECK_BATCH = 1000; // most hashes the server checks per request
+
 FolderSync::FolderSync(QObject *parent)
     : QObject(parent)
     , m_fileWatcher(nullptr)
     , m_currentReply(nullptr)
+    , m_currentId(0)
+    , m_checkingDuplicate(false)
+    , m_chunker(nullptr)
+    , m_deltaPhase(DeltaNone)
+    , m_deltaChecked(0)
+    , m_deltaNext(0)
+    , m_deltaSent(0)
+    , m_deltaResent(false)
+    , m_updates(nullptr)
     , m_isSyncing(false)
     , m_isEnabled(false)
     , m_syncInterval(300000) // 5 minutes
     , m_maxRetries(3)
     , m_currentRetries(0)
+    , m_streamBufferSize(1024 * 1024) // 1MB read-ahead per transfer
+    , m_dedupeEnabled(true)
+    , m_deltaEnabled(true)
+    , m_deltaSupported(true)
+    , m_deltaMinSize(8 * 1024 * 1024) // 8MB
+    , m_deltaConcurrency(4)
 {
     m_fileWatcher = new QFileSystemWatcher(this);
-    m_networkManager = new QNetworkAccessManager(this);
+    m_networkManager = NetworkTransport::instance();
     m_syncTimer = new QTimer(this);
+    m_circuitTimer = new QTimer(this);
+    m_circuitTimer->setSingleShot(true);
+    connect(m_circuitTimer, &QTimer::timeout, this, &FolderSync::processSyncQueue);
+    m_updates = new UpdateCoalescer(this);
+    connect(m_updates, &UpdateCoalescer::batchReady, this, &FolderSync::itemsChanged);
     
     // Initialize media file extensions
     m_mediaExtensions = {".mp4", ".avi", ".mov", ".mkv", ".mp3", ".wav", ".flac", 
@@ -44,6 +71,17 @@ FolderSync::FolderSync(QObject *parent)
     m_serverUrl = settings.value("sync/serverUrl", "http://localhost:3000").toString();
     m_syncInterval = settings.value("sync/interval", 300000).toInt();
     m_maxRetries = settings.value("sync/maxRetries", 3).toInt();
+    m_streamBufferSize = settings.value("upload/streamBufferSize", 1024 * 1024).toLongLong();
+    m_dedupeEnabled = settings.value("upload/dedupe", true).toBool();
+    m_deltaEnabled = settings.value("sync/deltaSync", true).toBool();
+    m_deltaMinSize = settings.value("sync/deltaMinSize", 8 * 1024 * 1024).toLongLong();
+    m_deltaConcurrency = qMax(1, settings.value("sync/deltaConcurrency", 4).toInt());
+    m_updates->setInterval(settings.value("ui/updateInterval", 33).toInt());
+    
+    connect(PreprocessPool::instance(), &PreprocessPool::fileProcessed, this, &FolderSync::onFileProcessed);
+    
+    m_chunker = new ContentChunker(this);
+    connect(m_chunker, &ContentChunker::manifestReady, this, &FolderSync::onManifestReady);
     
     m_syncTimer->setInterval(m_syncInterval);
 }
@@ -61,6 +99,10 @@ FolderSync::~FolderSync()
 void FolderSync::setAuthToken(const QString &token)
 {
     m_authToken = token;
+    
+    if (!m_authToken.isEmpty()) {
+        NetworkTransport::instance()->prewarm(QUrl(m_serverUrl));
+    }
 }
 
 void FolderSync::setServerUrl(const QString &url)
@@ -125,10 +167,15 @@ void FolderSync::removeFolder(const QString &folderPath)
         m_fileWatcher->removePath(subDir);
     }
     
-    // Remove items from sync queue
-    for (int i = m_syncQueue.size() - 1; i >= 0; --i) {
-        if (m_syncQueue[i].localPath.startsWith(folderPath)) {
-            m_syncQueue.removeAt(i);
+    // Remove items from sync queue; IDs of the rest stay valid, and stale
+    // entries in m_pendingIds are skipped when they come up
+    for (auto it = m_queuedIds.begin(); it != m_queuedIds.end();) {
+        if (it.key().startsWith(folderPath)) {
+            releaseFile(it.key());
+            m_syncQueue.remove(it.value());
+            it = m_queuedIds.erase(it);
+        } else {
+            ++it;
         }
     }
     
@@ -178,13 +225,16 @@ void FolderSync::stopSync()
 {
     m_isEnabled = false;
     m_syncTimer->stop();
+    m_circuitTimer->stop();
     
     if (m_isSyncing) {
         if (m_currentReply) {
             m_currentReply->abort();
         }
+        abortChunks();
         m_isSyncing = false;
     }
+    m_deltaPhase = DeltaNone; // a manifest still being built is ignored when it arrives
 }
 
 void FolderSync::forceSync()
@@ -205,7 +255,14 @@ QStringList FolderSync::getSyncedFolders() const
 QList<SyncItem> FolderSync::getSyncQueue() const
 {
     QMutexLocker locker(const_cast<QMutex*>(&m_syncMutex));
-    return m_syncQueue;
+    return m_syncQueue.values();
+}
+
+SyncItem FolderSync::syncItem(quint64 id) const
+{
+    QMutexLocker locker(const_cast<QMutex*>(&m_syncMutex));
+    const SyncItem *item = m_syncQueue.find(id);
+    return item ? *item : SyncItem();
 }
 
 bool FolderSync::isSyncing() const
@@ -262,18 +319,90 @@ void FolderSync::onNetworkReplyFinished()
         return;
     }
     
+    if (m_checkingDuplicate) {
+        m_checkingDuplicate = false;
+        QNetworkReply *reply = m_currentReply;
+        m_currentReply = nullptr;
+        reply->deleteLater();
+        
+        QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+        SyncItem *item = m_syncQueue.find(m_currentId);
+        if (m_isEnabled) {
+            RetryPolicy::instance()->record(reply);
+        }
+        if (!m_isEnabled) {
+            m_isSyncing = false; // stopSync() aborted the lookup
+        } else if (reply->error() == QNetworkReply::NoError && response.value("exists").toBool()) {
+            finishCurrentItem("Synced (duplicate)");
+        } else if (item) {
+            // Unknown to the server, or the lookup failed: upload normally
+            sendFile(*item);
+            if (!m_currentReply && m_deltaPhase == DeltaNone) {
+                m_isSyncing = false;
+                processSyncQueue();
+            }
+        } else {
+            m_isSyncing = false;
+            processSyncQueue();
+        }
+        return;
+    }
+    
+    if (handleDeltaReply()) {
+        return;
+    }
+    m_deltaPhase = DeltaNone;
+    
+    // stopSync() aborts say nothing about the server
+    RequestFailure failure;
+    if (m_isEnabled) {
+        failure = RetryPolicy::instance()->record(m_currentReply);
+    }
+    
     if (m_currentReply->error() == QNetworkReply::NoError) {
         // Sync successful
         m_currentRetries = 0;
+        if (const SyncItem *item = m_syncQueue.find(m_currentId)) {
+            if (!item->contentHash.isEmpty()) {
+                m_contentIndex.insert(item->contentHash, m_currentPath);
+            }
+            updateItemStatus(m_currentId, "Synced");
+        }
+        
+        // Images get thumbnails made here, so the server never decodes them
+        QJsonObject media = QJsonDocument::fromJson(m_currentReply->readAll()).object().value("media").toObject();
+        QString mediaId = media.value("id").toString();
+        if (!mediaId.isEmpty() && media.value("thumbnails").toArray().isEmpty() &&
+            ThumbnailMaker::instance()->isCandidate(m_currentPath)) {
+            QUrl thumbnailsUrl(m_serverUrl);
+            thumbnailsUrl.setPath(QString("/api/v1/media/%1/thumbnails").arg(mediaId));
+            ThumbnailMaker::instance()->attach(m_currentPath, thumbnailsUrl, m_authToken);
+        }
+        releaseFile(m_currentPath);
     } else {
         // Sync failed
-        if (m_currentRetries < m_maxRetries) {
+        if (failure.isRetryable() && m_currentRetries < m_maxRetries) {
             m_currentRetries++;
-            // Retry after delay
-            QTimer::singleShot(2000 * m_currentRetries, this, &FolderSync::processSyncQueue);
+            // Retry after delay, ahead of everything else that is waiting
+            quint64 id = m_currentId;
+            updateItemStatus(id, QString("Retrying... (%1/%2)").arg(m_currentRetries).arg(m_maxRetries));
+            qint64 delay = RetryPolicy::instance()->retryDelay(failure, m_currentRetries, QUrl(m_serverUrl));
+            QTimer::singleShot(static_cast<int>(delay), this, [this, id]() {
+                if (m_syncQueue.contains(id)) {
+                    updateItemStatus(id, "Pending");
+                    m_pendingIds.prepend(id);
+                }
+                processSyncQueue();
+            });
         } else {
             m_currentRetries = 0;
-            emit syncError(QString("Sync failed after %1 retries").arg(m_maxRetries));
+            updateItemStatus(m_currentId, "Failed");
+            releaseFile(m_currentPath);
+            if (failure.isRetryable()) {
+                emit syncError(QString("Sync failed after %1 retries").arg(m_maxRetries));
+            } else {
+                emit syncError(QString("Sync failed: %1").arg(m_currentReply->errorString()));
+            }
         }
     }
     
@@ -310,34 +439,53 @@ void FolderSync::scanFile(const QString &filePath)
         return;
     }
     
+    bool queued = false;
+    
     // Check if file is already in index
     if (m_fileIndex.contains(filePath)) {
         SyncItem &existingItem = m_fileIndex[filePath];
         
         // Check if file has changed
-        if (existingItem.lastModified != fileInfo.lastModified() || 
-            existingItem.fileSize != fileInfo.size()) {
+        auto queuedId = m_queuedIds.constFind(filePath);
+        bool current = m_isSyncing && queuedId != m_queuedIds.constEnd() && queuedId.value() == m_currentId;
+        
+        // The item being synced is left alone: the index keeps its old size
+        // and time, so a later scan queues the change once this sync is done
+        if (!current && (existingItem.lastModified != fileInfo.lastModified() || 
+                         existingItem.fileSize != fileInfo.size())) {
             existingItem.lastModified = fileInfo.lastModified();
             existingItem.fileSize = fileInfo.size();
             existingItem.status = "Modified";
             
             // Add to sync queue if not already there
-            bool inQueue = false;
-            for (const SyncItem &item : m_syncQueue) {
-                if (item.localPath == filePath) {
-                    inQueue = true;
-                    break;
+            if (queuedId == m_queuedIds.constEnd()) {
+                enqueueSyncItem(existingItem);
+                queued = true;
+            } else if (SyncItem *item = m_syncQueue.find(queuedId.value())) {
+                // Synced (or failed) before: sync the new version
+                bool waiting = item->status == "Pending" || item->status == "Modified";
+                item->fileSize = existingItem.fileSize;
+                item->lastModified = existingItem.lastModified;
+                item->contentHash.clear();
+                updateItemStatus(item->id, "Modified");
+                if (!waiting) {
+                    m_pendingIds.enqueue(item->id);
                 }
-            }
-            if (!inQueue) {
-                m_syncQueue.append(existingItem);
+                releaseFile(filePath); // drop the old hash and blocks
+                queued = true;
             }
         }
     } else {
         // New file
         SyncItem newItem(filePath);
         m_fileIndex[filePath] = newItem;
-        m_syncQueue.append(newItem);
+        enqueueSyncItem(newItem);
+        queued = true;
+    }
+    
+    // Hashing happens on the pre-processing pool, never on the GUI thread
+    if (queued && m_dedupeEnabled) {
+        PreprocessPool::instance()->submit(filePath, false, fileInfo.size());
     }
 }
 
@@ -358,12 +506,12 @@ void FolderSync::processSyncQueue()
     
     QMutexLocker locker(&m_syncMutex);
     
-    // Find next item to sync
+    // Next item to sync; IDs of items removed since they were queued are dropped
     SyncItem *nextItem = nullptr;
-    for (int i = 0; i < m_syncQueue.size(); ++i) {
-        if (m_syncQueue[i].status == "Pending" || m_syncQueue[i].status == "Modified") {
-            nextItem = &m_syncQueue[i];
-            break;
+    while (!nextItem && !m_pendingIds.isEmpty()) {
+        SyncItem *item = m_syncQueue.find(m_pendingIds.dequeue());
+        if (item && (item->status == "Pending" || item->status == "Modified")) {
+            nextItem = item;
         }
     }
     
@@ -372,73 +520,473 @@ void FolderSync::processSyncQueue()
         return;
     }
     
+    // Leave the server alone while its circuit is open
+    if (!RetryPolicy::instance()->allowRequest(QUrl(m_serverUrl))) {
+        m_pendingIds.prepend(nextItem->id);
+        if (!m_circuitTimer->isActive()) {
+            qint64 wait = RetryPolicy::instance()->blockedFor(QUrl(m_serverUrl));
+            m_circuitTimer->start(static_cast<int>(qBound<qint64>(100, wait, 60000)));
+        }
+        return;
+    }
+    
     m_isSyncing = true;
     nextItem->status = "Syncing";
+    m_currentId = nextItem->id;
+    m_currentPath = nextItem->localPath;
     
     if (nextItem->isDirectory) {
         createDirectory(*nextItem);
+    } else if (m_dedupeEnabled) {
+        // Uploads wait for the hash; onFileProcessed() continues with the duplicate check
+        PreprocessPool::instance()->submit(nextItem->localPath, true, nextItem->fileSize);
     } else {
-        uploadFile(*nextItem);
+        // Hashing would have read the media headers; without it they are read here, a few KB
+        nextItem->mediaInfo = MediaProbe::probe(nextItem->localPath);
+        sendFile(*nextItem);
     }
     
-    emit itemStatusChanged(m_syncQueue.indexOf(*nextItem), "Syncing");
+    m_updates->setStatus(m_currentId, "Syncing");
+}
+
+void FolderSync::sendFile(const SyncItem &item)
+{
+    // Large files go in content-defined chunks, so the next version of the
+    // file only costs the chunks that changed
+    if (m_deltaEnabled && m_deltaSupported && item.fileSize >= m_deltaMinSize) {
+        startDelta(item);
+    } else {
+        uploadFile(item);
+    }
 }
 
 void FolderSync::uploadFile(const SyncItem &item)
 {
     if (!QFile::exists(item.localPath)) {
-        updateItemStatus(m_syncQueue.indexOf(item), "File not found");
+        updateItemStatus(item.id, "File not found");
+        releaseFile(item.localPath);
         return;
     }
     
-    // Create multipart request
-    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
-    
-    // Add file part
-    QHttpPart filePart;
-    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/octet-stream"));
-    filePart.setHeader(QNetworkRequest::ContentDispositionHeader, 
-                      QVariant(QString("form-data; name=\"file\"; filename=\"%1\"").arg(item.fileName)));
-    
-    QFile file(item.localPath);
-    if (file.open(QIODevice::ReadOnly)) {
-        filePart.setBody(file.readAll());
-        file.close();
-    }
-    multiPart->append(filePart);
-    
-    // Add metadata
-    QHttpPart metadataPart;
-    metadataPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"metadata\""));
-    
     QJsonObject metadata;
     metadata["fileName"] = item.fileName;
     metadata["fileSize"] = static_cast<qint64>(item.fileSize);
     metadata["originalPath"] = item.localPath;
     metadata["lastModified"] = item.lastModified.toString(Qt::ISODate);
+    const QJsonObject media = item.mediaInfo.toJson();
+    for (auto it = media.constBegin(); it != media.constEnd(); ++it) {
+        metadata.insert(it.key(), it.value());
+    }
     
-    QJsonDocument metadataDoc(metadata);
-    metadataPart.setBody(metadataDoc.toJson());
-    multiPart->append(metadataPart);
+    QHash<QString, QString> fields;
+    if (!item.contentHash.isEmpty()) {
+        fields.insert("contentHash", QString::fromLatin1(item.contentHash));
+    }
+    if (item.mediaInfo.durationMs > 0) {
+        fields.insert("duration", QString::number(item.mediaInfo.durationSeconds(), 'f', 3));
+    }
+    
+    // Stream the file from disk instead of reading it into memory
+    UploadStream *stream = UploadStream::createMultipart(item.localPath, item.fileName, metadata, fields);
+    if (!stream) {
+        updateItemStatus(item.id, "Cannot open file");
+        releaseFile(item.localPath);
+        return;
+    }
+    stream->setBufferSize(m_streamBufferSize);
+    stream->open(QIODevice::ReadOnly);
     
     // Create request
     QUrl uploadUrl(m_serverUrl);
     uploadUrl.setPath("/api/v1/media/upload");
     
     QNetworkRequest request(uploadUrl);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "multipart/form-data");
+    request.setHeader(QNetworkRequest::ContentTypeHeader, stream->contentType());
+    request.setHeader(QNetworkRequest::ContentLengthHeader, stream->size());
     
     if (!m_authToken.isEmpty()) {
         request.setRawHeader("Authorization", QString("Bearer %1").arg(m_authToken).toUtf8());
     }
     
     // Send request
-    m_currentReply = m_networkManager->post(request, multiPart);
-    multiPart->setParent(m_currentReply);
+    m_currentReply = m_networkManager->post(request, stream);
+    stream->setParent(m_currentReply);
+    
+    connect(m_currentReply, &QNetworkReply::finished, this, &FolderSync::onNetworkReplyFinished);
+}
+
+void FolderSync::onFileProcessed(const PreprocessResult &result)
+{
+    const QString &filePath = result.filePath;
+    const QByteArray &hash = result.contentHash;
+    if (!m_isSyncing || m_currentReply || m_deltaPhase != DeltaNone || filePath != m_currentPath) {
+        return;
+    }
+    
+    SyncItem *current = m_syncQueue.find(m_currentId);
+    if (!current) {
+        m_isSyncing = false;
+        processSyncQueue();
+        return;
+    }
+    
+    SyncItem &item = *current;
+    item.contentHash = hash;
+    item.mediaInfo = result.mediaInfo;
+    
+    // Same bytes already synced from another path in this session
+    QString knownPath = m_contentIndex.value(hash);
+    if (!hash.isEmpty() && !knownPath.isEmpty() && knownPath != filePath) {
+        finishCurrentItem("Synced (duplicate)");
+        return;
+    }
+    
+    if (hash.isEmpty()) {
+        sendFile(item);
+    } else {
+        checkDuplicate(item);
+    }
+    
+    if (!m_currentReply && m_deltaPhase == DeltaNone) {
+        m_isSyncing = false;
+        processSyncQueue();
+    }
+}
+
+void FolderSync::checkDuplicate(const SyncItem &item)
+{
+    QUrl checkUrl(m_serverUrl);
+    checkUrl.setPath("/api/v1/media/dedupe-check");
+    
+    QNetworkRequest request(checkUrl);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    
+    if (!m_authToken.isEmpty()) {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_authToken).toUtf8());
+    }
+    
+    QJsonObject body;
+    body["contentHash"] = QString::fromLatin1(item.contentHash);
+    body["fileSize"] = static_cast<qint64>(item.fileSize);
+    
+    m_checkingDuplicate = true;
+    m_currentReply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+    
+    connect(m_currentReply, &QNetworkReply::finished, this, &FolderSync::onNetworkReplyFinished);
+}
+
+void FolderSync::startDelta(const SyncItem &item)
+{
+    // onManifestReady() continues once the file is chunked
+    m_deltaPhase = DeltaChunking;
+    m_deltaResent = false;
+    m_chunker->chunkFile(item.localPath);
+}
+
+void FolderSync::onManifestReady(const ChunkManifest &manifest)
+{
+    if (m_deltaPhase != DeltaChunking || !m_isSyncing || manifest.filePath != m_currentPath) {
+        return; // stopSync() came in between
+    }
+    
+    if (manifest.failed || manifest.chunks.isEmpty()) {
+        m_deltaPhase = DeltaNone;
+        const SyncItem *item = m_syncQueue.find(m_currentId);
+        if (manifest.failed || !item) {
+            updateItemStatus(m_currentId, "Cannot open file");
+            releaseFile(m_currentPath);
+        } else {
+            uploadFile(*item); // emptied since it was queued
+        }
+        if (!m_currentReply) {
+            m_isSyncing = false;
+            processSyncQueue();
+        }
+        return;
+    }
+    
+    m_deltaManifest = manifest;
+    m_deltaHashes.clear();
+    m_deltaChunkIndex.clear();
+    m_deltaMissing.clear();
+    for (int i = 0; i < manifest.chunks.size(); ++i) {
+        const QByteArray &hash = manifest.chunks.at(i).hash;
+        if (!m_deltaChunkIndex.contains(hash)) {
+            m_deltaChunkIndex.insert(hash, i);
+            m_deltaHashes.append(hash);
+        }
+    }
+    m_deltaChecked = 0;
+    m_deltaNext = 0;
+    m_deltaSent = 0;
+    
+    sendChunkCheck();
+}
+
+void FolderSync::sendChunkCheck()
+{
+    QUrl checkUrl(m_serverUrl);
+    checkUrl.setPath("/api/v1/media/delta/chunks/check");
+    
+    QNetworkRequest request(checkUrl);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    
+    if (!m_authToken.isEmpty()) {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_authToken).toUtf8());
+    }
+    
+    QJsonArray hashes;
+    int end = qMin(m_deltaHashes.size(), m_deltaChecked + DELTA_CHECK_BATCH);
+    for (int i = m_deltaChecked; i < end; ++i) {
+        hashes.append(QString::fromLatin1(m_deltaHashes.at(i)));
+    }
+    
+    QJsonObject body;
+    body["hashes"] = hashes;
+    
+    m_deltaPhase = DeltaChecking;
+    m_currentReply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
     
     connect(m_currentReply, &QNetworkReply::finished, this, &FolderSync::onNetworkReplyFinished);
 }
 
+void FolderSync::sendChunks()
+{
+    // Several PUTs at once: chunks are ~1MB, so one at a time would leave a
+    // first sync waiting on a round trip per MB
+    m_deltaPhase = DeltaSendingChunks;
+    while (m_deltaNext < m_deltaMissing.size() && m_deltaChunkReplies.size() < m_deltaConcurrency) {
+        QNetworkReply *reply = sendChunk(m_deltaMissing.at(m_deltaNext));
+        if (!reply) {
+            abortChunks();
+            m_deltaPhase = DeltaNone;
+            updateItemStatus(m_currentId, "Cannot open file");
+            releaseFile(m_currentPath);
+            return;
+        }
+        m_deltaChunkReplies.append(reply);
+        ++m_deltaNext;
+    }
+    
+    updateItemStatus(m_currentId, QString("Syncing (%1 of %2 chunks)")
+                                      .arg(m_deltaSent + 1).arg(m_deltaMissing.size()));
+}
+
+QNetworkReply *FolderSync::sendChunk(int index)
+{
+    const ContentChunk &chunk = m_deltaManifest.chunks.at(index);
+    
+    UploadStream *stream = new UploadStream();
+    if (!stream->appendFile(m_currentPath, chunk.offset, chunk.length)) {
+        delete stream;
+        return nullptr;
+    }
+    stream->setBufferSize(m_streamBufferSize);
+    stream->open(QIODevice::ReadOnly);
+    
+    QUrl chunkUrl(m_serverUrl);
+    chunkUrl.setPath(QString("/api/v1/media/delta/chunks/%1").arg(QString::fromLatin1(chunk.hash)));
+    
+    QNetworkRequest request(chunkUrl);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/octet-stream");
+    request.setHeader(QNetworkRequest::ContentLengthHeader, stream->size());
+    
+    if (!m_authToken.isEmpty()) {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_authToken).toUtf8());
+    }
+    
+    QNetworkReply *reply = m_networkManager->put(request, stream);
+    stream->setParent(reply);
+    
+    connect(reply, &QNetworkReply::finished, this, &FolderSync::onChunkReplyFinished);
+    return reply;
+}
+
+void FolderSync::abortChunks()
+{
+    QList<QNetworkReply*> replies = m_deltaChunkReplies;
+    m_deltaChunkReplies.clear(); // onChunkReplyFinished() ignores them from here on
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+void FolderSync::onChunkReplyFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !m_deltaChunkReplies.removeOne(reply)) {
+        return; // aborted along with the rest of its item
+    }
+    
+    if (reply->error() != QNetworkReply::NoError) {
+        // The first failed chunk stands for the item: the others are dropped
+        // and the item is retried or failed like any upload. A retry checks
+        // again, so chunks that did arrive are not sent twice.
+        abortChunks();
+        m_deltaPhase = DeltaNone;
+        m_currentReply = reply;
+        onNetworkReplyFinished();
+        return;
+    }
+    
+    RetryPolicy::instance()->record(reply);
+    reply->deleteLater();
+    
+    if (++m_deltaSent < m_deltaMissing.size()) {
+        sendChunks();
+    } else {
+        commitDelta();
+    }
+    
+    if (!m_currentReply && m_deltaChunkReplies.isEmpty()) {
+        m_deltaPhase = DeltaNone;
+        m_isSyncing = false;
+        processSyncQueue();
+    }
+}
+
+void FolderSync::commitDelta()
+{
+    QUrl commitUrl(m_serverUrl);
+    commitUrl.setPath("/api/v1/media/delta");
+    
+    QNetworkRequest request(commitUrl);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    
+    if (!m_authToken.isEmpty()) {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_authToken).toUtf8());
+    }
+    
+    QJsonArray chunks;
+    for (const ContentChunk &chunk : m_deltaManifest.chunks) {
+        QJsonObject entry;
+        entry["hash"] = QString::fromLatin1(chunk.hash);
+        entry["size"] = chunk.length;
+        chunks.append(entry);
+    }
+    
+    QJsonObject body;
+    body["fileName"] = QFileInfo(m_currentPath).fileName();
+    body["fileSize"] = m_deltaManifest.fileSize;
+    body["mimeType"] = QMimeDatabase().mimeTypeForFile(m_currentPath).name();
+    body["chunks"] = chunks;
+    const SyncItem *item = m_syncQueue.find(m_currentId);
+    if (item && !item->contentHash.isEmpty()) {
+        body["contentHash"] = QString::fromLatin1(item->contentHash);
+    }
+    if (item && item->mediaInfo.durationMs > 0) {
+        body["duration"] = item->mediaInfo.durationSeconds();
+    }
+    
+    m_deltaPhase = DeltaCommitting;
+    m_currentReply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+    
+    connect(m_currentReply, &QNetworkReply::finished, this, &FolderSync::onNetworkReplyFinished);
+}
+
+bool FolderSync::handleDeltaReply()
+{
+    if (m_deltaPhase == DeltaNone || !m_isEnabled) {
+        return false;
+    }
+    
+    QNetworkReply *reply = m_currentReply;
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // Peeked, so a reply handed on to the generic handling still has its body
+    QJsonObject response = QJsonDocument::fromJson(reply->peek(reply->bytesAvailable())).object();
+    QJsonArray missing = response.value("missing").toArray();
+    
+    bool unsupported = m_deltaPhase == DeltaChecking && status == 404;
+    bool resend = m_deltaPhase == DeltaCommitting && status == 409 && !m_deltaResent && !missing.isEmpty();
+    if (!unsupported && !resend && (reply->error() != QNetworkReply::NoError || m_deltaPhase == DeltaCommitting)) {
+        return false; // retried or failed like any upload, or it is done
+    }
+    
+    RetryPolicy::instance()->record(reply);
+    m_currentReply = nullptr;
+    reply->deleteLater();
+    
+    if (unsupported) {
+        // Server without delta sync: whole files from now on
+        m_deltaSupported = false;
+        m_deltaPhase = DeltaNone;
+        if (const SyncItem *item = m_syncQueue.find(m_currentId)) {
+            uploadFile(*item);
+        }
+    } else if (resend) {
+        // Chunks went missing after they were checked; send those once more
+        m_deltaResent = true;
+        m_deltaMissing.clear();
+        m_deltaNext = 0;
+        m_deltaSent = 0;
+        for (const QJsonValue &value : missing) {
+            int index = m_deltaChunkIndex.value(value.toString().toLatin1(), -1);
+            if (index >= 0) {
+                m_deltaMissing.append(index);
+            }
+        }
+        if (m_deltaMissing.isEmpty()) {
+            commitDelta();
+        } else {
+            sendChunks();
+        }
+    } else if (m_deltaPhase == DeltaChecking) {
+        for (const QJsonValue &value : missing) {
+            int index = m_deltaChunkIndex.value(value.toString().toLatin1(), -1);
+            if (index >= 0) {
+                m_deltaMissing.append(index);
+            }
+        }
+        m_deltaChecked = qMin(m_deltaHashes.size(), m_deltaChecked + DELTA_CHECK_BATCH);
+        if (m_deltaChecked < m_deltaHashes.size()) {
+            sendChunkCheck();
+        } else if (m_deltaMissing.isEmpty()) {
+            commitDelta();
+        } else {
+            sendChunks();
+        }
+    }
+    
+    if (!m_currentReply && m_deltaChunkReplies.isEmpty()) {
+        m_deltaPhase = DeltaNone;
+        m_isSyncing = false;
+        processSyncQueue();
+    }
+    return true;
+}
+
+void FolderSync::finishCurrentItem(const QString &status)
+{
+    if (const SyncItem *item = m_syncQueue.find(m_currentId)) {
+        const QByteArray &hash = item->contentHash;
+        if (!hash.isEmpty() && !m_contentIndex.contains(hash)) {
+            m_contentIndex.insert(hash, m_currentPath);
+        }
+        updateItemStatus(m_currentId, status);
+    }
+    releaseFile(m_currentPath);
+    
+    m_isSyncing = false;
+    processSyncQueue();
+}
+
+void FolderSync::releaseFile(const QString &filePath)
+{
+    // Whatever the outcome, the file stops holding its hash and read-ahead blocks
+    PreprocessPool::instance()->release(filePath);
+    ReadAheadPool::instance()->drop(filePath);
+}
+
+quint64 FolderSync::enqueueSyncItem(const SyncItem &item)
+{
+    quint64 id = m_syncQueue.insert(item);
+    m_syncQueue.find(id)->id = id;
+    m_queuedIds.insert(item.localPath, id);
+    m_pendingIds.enqueue(id);
+    return id;
+}
+
 void FolderSync::createDirectory(const SyncItem &item)
 {
     // Create directory on server
@@ -488,10 +1036,10 @@ void FolderSync::removeRemoteItem(const SyncItem &item)
     connect(m_currentReply, &QNetworkReply::finished, this, &FolderSync::onNetworkReplyFinished);
 }
 
-void FolderSync::updateItemStatus(int index, const QString &status)
+void FolderSync::updateItemStatus(quint64 id, const QString &status)
 {
-    if (index >= 0 && index < m_syncQueue.size()) {
-        m_syncQueue[index].status = status;
-        emit itemStatusChanged(index, status);
+    if (SyncItem *item = m_syncQueue.find(id)) {
+        item->status = status;
+        m_updates->setStatus(id, status);
     }
 }
@@ -0,0 +1,167 @@
+#include "hashcache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+const int HashCache::MAX_ENTRIES = 200000;
+
+static const quint32 CACHE_FORMAT_VERSION = 1;
+
+HashCache* HashCache::instance()
+{
+    static HashCache instance;
+    return &instance;
+}
+
+HashCache::HashCache(QObject *parent)
+    : QObject(parent)
+    , m_dirty(false)
+{
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataPath);
+    m_cachePath = dataPath + "/hash-cache.dat";
+
+    // Persist at most every few seconds while hashes are coming in
+    m_saveTimer.setSingleShot(true);
+    m_saveTimer.setInterval(5000);
+    connect(&m_saveTimer, &QTimer::timeout, this, &HashCache::save);
+
+    load();
+}
+
+HashCache::~HashCache()
+{
+    save();
+}
+
+QByteArray HashCache::cachedHash(const QString &filePath)
+{
+    QByteArray key = fileKey(filePath);
+    if (key.isEmpty()) {
+        return QByteArray();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return QByteArray();
+    }
+    it->lastUsed = QDateTime::currentSecsSinceEpoch();
+    return it->hash;
+}
+
+QByteArray HashCache::fileKey(const QString &filePath)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(filePath).constData(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return QByteArray();
+    }
+
+    // Identity survives renames and hard links; size and mtime catch edits
+    qint64 mtimeMs = QFileInfo(filePath).lastModified().toMSecsSinceEpoch();
+    return QByteArray::number(static_cast<quint64>(st.st_dev)) + ':' +
+           QByteArray::number(static_cast<quint64>(st.st_ino)) + ':' +
+           QByteArray::number(static_cast<qint64>(st.st_size)) + ':' +
+           QByteArray::number(mtimeMs);
+#else
+    // No inode through Qt here; fall back to the canonical path
+    QFileInfo info(filePath);
+    if (!info.isFile()) {
+        return QByteArray();
+    }
+    return info.canonicalFilePath().toUtf8() + ':' +
+           QByteArray::number(info.size()) + ':' +
+           QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+#endif
+}
+
+void HashCache::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty) {
+        return;
+    }
+
+    // Drop the least recently used entries once the cache grows past its cap
+    if (m_entries.size() > MAX_ENTRIES) {
+        QList<QPair<qint64, QByteArray>> byAge;
+        byAge.reserve(m_entries.size());
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            byAge.append(qMakePair(it->lastUsed, it.key()));
+        }
+        std::sort(byAge.begin(), byAge.end());
+        for (int i = 0; i < byAge.size() - MAX_ENTRIES; ++i) {
+            m_entries.remove(byAge.at(i).second);
+        }
+    }
+
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream out(&file);
+    out << CACHE_FORMAT_VERSION << static_cast<quint32>(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        out << it.key() << it->hash << it->lastUsed;
+    }
+
+    if (file.commit()) {
+        m_dirty = false;
+    }
+}
+
+void HashCache::load()
+{
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream in(&file);
+    quint32 version = 0;
+    quint32 count = 0;
+    in >> version >> count;
+    if (version != CACHE_FORMAT_VERSION) {
+        return;
+    }
+
+    m_entries.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray key;
+        Entry entry;
+        in >> key >> entry.hash >> entry.lastUsed;
+        if (in.status() == QDataStream::Ok) {
+            m_entries.insert(key, entry);
+        }
+    }
+}
+
+void HashCache::insert(const QByteArray &key, const QByteArray &hash)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry entry;
+        entry.hash = hash;
+        entry.lastUsed = QDateTime::currentSecsSinceEpoch();
+        m_entries.insert(key, entry);
+        m_dirty = true;
+    }
+
+    // Called from worker threads; the timer belongs to the GUI thread
+    QMetaObject::invokeMethod(this, [this]() {
+        if (!m_saveTimer.isActive()) {
+            m_saveTimer.start();
+        }
+    }, Qt::QueuedConnection);
+}
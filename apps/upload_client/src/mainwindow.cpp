@@ -2,7 +2,9 @@
 #include "authdialog.h"
 #include "uploadmanager.h"
 #include "foldersync.h"
+#include "memorybudget.h"
 #include "networkmanager.h"
+#include "networktransport.h"
 #include "settings.h"
 #include <QFileDialog>
 #include <QMessageBox>
@@ -12,12 +14,14 @@
 #include <QMenu>
 #include <QAction>
 #include <QInputDialog>
+#include <QLocale>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_isAuthenticated(false)
     , m_settings(nullptr)
     , m_syncTimer(nullptr)
+    , m_memoryStatsTimer(nullptr)
 {
     setupUI();
     setupMenuBar();
@@ -27,6 +31,8 @@ MainWindow::MainWindow(QWidget *parent)
     // Initialize components
     m_authDialog = new AuthDialog(this);
     m_uploadManager = new UploadManager(this);
+    connect(m_uploadManager, &UploadManager::chunkStatsChanged, this, &MainWindow::onChunkStatsChanged);
+    connect(m_uploadManager, &UploadManager::uploadError, this, &MainWindow::onStatusMessage);
     m_folderSync = new FolderSync(this);
     m_networkManager = new NetworkManager(this);
     
@@ -38,6 +44,12 @@ MainWindow::MainWindow(QWidget *parent)
     m_syncTimer->setInterval(300000); // 5 minutes
     connect(m_syncTimer, &QTimer::timeout, this, &MainWindow::onSyncAllClicked);
     
+    m_memoryStatsTimer = new QTimer(this);
+    m_memoryStatsTimer->setInterval(1000);
+    connect(m_memoryStatsTimer, &QTimer::timeout, this, &MainWindow::updateMemoryStats);
+    m_memoryStatsTimer->start();
+    updateMemoryStats();
+    
     // Update authentication state
     updateAuthenticationState();
     
@@ -169,6 +181,11 @@ void MainWindow::setupMenuBar()
 void MainWindow::setupStatusBar()
 {
     statusBar()->showMessage("Ready");
+    
+    m_transferStatsLabel = new QLabel();
+    statusBar()->addPermanentWidget(m_transferStatsLabel);
+    m_memoryStatsLabel = new QLabel();
+    statusBar()->addPermanentWidget(m_memoryStatsLabel);
 }
 
 void MainWindow::setupConnections()
@@ -238,6 +255,12 @@ void MainWindow::onLoginClicked()
     if (m_authDialog->exec() == QDialog::Accepted) {
         m_authToken = m_authDialog->getAuthToken();
         m_currentUser = m_authDialog->getUsername();
+        
+        // Connect to the upload and sync servers while the user picks files
+        Settings *settings = Settings::instance();
+        NetworkTransport::instance()->prewarm(QUrl(settings->getUploadServerUrl()));
+        NetworkTransport::instance()->prewarm(QUrl(settings->getSyncServerUrl()));
+        
         updateAuthenticationState();
         saveSettings();
     }
@@ -322,3 +345,23 @@ void MainWindow::onNetworkError(const QString &error)
     statusBar()->showMessage(QString("Error: %1").arg(error));
     QMessageBox::warning(this, "Network Error", error);
 }
+
+void MainWindow::onChunkStatsChanged(const ChunkStats &stats)
+{
+    QLocale locale;
+    m_transferStatsLabel->setText(QString("Chunk %1 | %2/s goodput | %3/s link | RTT %4 ms")
+                                  .arg(locale.formattedDataSize(stats.chunkSize))
+                                  .arg(locale.formattedDataSize(stats.goodput))
+                                  .arg(locale.formattedDataSize(stats.throughput))
+                                  .arg(stats.rttMs));
+}
+
+void MainWindow::updateMemoryStats()
+{
+    QLocale locale;
+    MemoryBudget *budget = MemoryBudget::instance();
+    m_memoryStatsLabel->setText(QString("Buffers %1 of %2 | peak %3")
+                                .arg(locale.formattedDataSize(budget->used()))
+                                .arg(locale.formattedDataSize(budget->limit()))
+                                .arg(locale.formattedDataSize(budget->peak())));
+}
@@ -0,0 +1,687 @@
+#include "mediaprobe.h"
+#include <QtEndian>
+#include <cstring>
+
+const qint64 MediaProbe::WINDOW_SIZE = 64 * 1024; // 64KB, mapped; only the pages read are faulted in
+const int MediaProbe::MAX_WINDOWS = 16;
+const int MediaProbe::MAX_STEPS = 4096;
+
+// Matroska element IDs, marker bits included as the spec writes them
+static const quint32 EBML_HEADER = 0x1A45DFA3;
+static const quint32 EBML_SEGMENT = 0x18538067;
+static const quint32 EBML_SEEK_HEAD = 0x114D9B74;
+static const quint32 EBML_SEEK = 0x4DBB;
+static const quint32 EBML_SEEK_ID = 0x53AB;
+static const quint32 EBML_SEEK_POSITION = 0x53AC;
+static const quint32 EBML_INFO = 0x1549A966;
+static const quint32 EBML_TIMECODE_SCALE = 0x2AD7B1;
+static const quint32 EBML_DURATION = 0x4489;
+static const quint32 EBML_TRACKS = 0x1654AE6B;
+static const quint32 EBML_TRACK_ENTRY = 0xAE;
+static const quint32 EBML_TRACK_TYPE = 0x83;
+static const quint32 EBML_CODEC_ID = 0x86;
+static const quint32 EBML_VIDEO = 0xE0;
+static const quint32 EBML_PIXEL_WIDTH = 0xB0;
+static const quint32 EBML_PIXEL_HEIGHT = 0xBA;
+static const quint32 EBML_CLUSTER = 0x1F43B675;
+
+static quint32 fourCC(const char *name)
+{
+    return quint32(uchar(name[0])) << 24 | quint32(uchar(name[1])) << 16 |
+           quint32(uchar(name[2])) << 8 | quint32(uchar(name[3]));
+}
+
+QJsonObject MediaInfo::toJson() const
+{
+    QJsonObject json;
+    if (durationMs > 0) {
+        json["duration"] = durationSeconds();
+    }
+    if (width > 0 && height > 0) {
+        json["width"] = width;
+        json["height"] = height;
+    }
+    if (!codec.isEmpty()) {
+        json["codec"] = codec;
+    }
+    if (bitrate > 0) {
+        json["bitrate"] = bitrate;
+    }
+    return json;
+}
+
+MediaProbe::MediaProbe(const QString &filePath)
+    : m_file(filePath)
+    , m_size(0)
+    , m_steps(0)
+    , m_haveVideo(false)
+{
+}
+
+MediaInfo MediaProbe::probe(const QString &filePath)
+{
+    MediaProbe probe(filePath);
+    if (!probe.m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return MediaInfo();
+    }
+    probe.m_size = probe.m_file.size();
+
+    if (probe.startsWith(0, "\x1A\x45\xDF\xA3")) {
+        probe.probeMatroska();
+    } else if (probe.startsWith(4, "ftyp") || probe.startsWith(4, "moov") || probe.startsWith(4, "mdat") ||
+               probe.startsWith(4, "wide") || probe.startsWith(4, "free") || probe.startsWith(4, "skip")) {
+        probe.probeMp4(); // old QuickTime files have no ftyp
+    } else if ((probe.startsWith(0, "RIFF") || probe.startsWith(0, "RF64")) && probe.startsWith(8, "WAVE")) {
+        probe.probeWav();
+    } else if (probe.startsWith(0, "RIFF") && probe.startsWith(8, "WEBP")) {
+        probe.probeWebp();
+    } else if (probe.startsWith(0, "\x89PNG\r\n\x1A\n")) {
+        probe.probePng();
+    } else if (probe.startsWith(0, "\xFF\xD8\xFF")) {
+        probe.probeJpeg();
+    } else if (probe.startsWith(0, "GIF87a") || probe.startsWith(0, "GIF89a")) {
+        probe.probeGif();
+    } else if (probe.startsWith(0, "BM")) {
+        probe.probeBmp();
+    } else if (probe.startsWith(0, "ID3")) {
+        // An ID3v2 tag in front of FLAC; its size is syncsafe, 7 bits a byte
+        const uchar *tag = probe.at(0, 10);
+        if (tag) {
+            qint64 size = (tag[6] & 0x7F) << 21 | (tag[7] & 0x7F) << 14 | (tag[8] & 0x7F) << 7 | (tag[9] & 0x7F);
+            probe.probeFlac(10 + size + ((tag[5] & 0x10) ? 10 : 0));
+        }
+    } else {
+        probe.probeFlac(0);
+    }
+
+    MediaInfo &info = probe.m_info;
+    if (info.bitrate <= 0 && info.durationMs > 0) {
+        info.bitrate = qint64(double(probe.m_size) * 8 * 1000 / info.durationMs);
+    }
+    return info;
+}
+
+const uchar *MediaProbe::at(qint64 offset, qint64 length)
+{
+    if (offset < 0 || length <= 0 || length > WINDOW_SIZE || offset > m_size - length) {
+        return nullptr;
+    }
+    for (const Window &window : m_windows) {
+        if (offset >= window.offset && offset + length <= window.offset + window.length) {
+            return window.data + (offset - window.offset);
+        }
+    }
+    if (m_windows.size() >= MAX_WINDOWS) {
+        return nullptr;
+    }
+
+    Window window;
+    window.offset = offset - offset % WINDOW_SIZE;
+    window.length = qMin(m_size - window.offset, qMax(WINDOW_SIZE, offset + length - window.offset));
+    window.data = m_file.map(window.offset, window.length);
+    if (!window.data) {
+        // e.g. network filesystems; a window is small enough to copy
+        window.copy.resize(window.length);
+        if (!m_file.seek(window.offset) || m_file.read(window.copy.data(), window.length) != window.length) {
+            return nullptr;
+        }
+        window.data = reinterpret_cast<const uchar*>(window.copy.constData());
+    }
+    m_windows.append(window);
+    return window.data + (offset - window.offset);
+}
+
+bool MediaProbe::startsWith(qint64 offset, const char *magic)
+{
+    const qint64 length = qint64(strlen(magic));
+    const uchar *data = at(offset, length);
+    return data && memcmp(data, magic, length) == 0;
+}
+
+bool MediaProbe::countStep()
+{
+    return ++m_steps <= MAX_STEPS;
+}
+
+void MediaProbe::takeTrack(const Track &track)
+{
+    // The first video track describes the file; an audio codec only when there is no video
+    if (track.isVideo && !m_haveVideo) {
+        m_haveVideo = true;
+        m_info.width = track.width;
+        m_info.height = track.height;
+        m_info.codec = track.codec;
+    } else if (track.isAudio && !m_haveVideo && m_info.codec.isEmpty()) {
+        m_info.codec = track.codec;
+    }
+}
+
+// MP4 / QuickTime: a tree of boxes, each a 32-bit size (or 1 and a 64-bit
+// size after the type, or 0 for "to the end") and a four character type.
+// Everything needed is under moov; mdat, the media itself, is skipped.
+
+bool MediaProbe::readBox(qint64 offset, qint64 end, Box &box)
+{
+    if (end - offset < 8 || !countStep()) {
+        return false;
+    }
+    const uchar *header = at(offset, 8);
+    if (!header) {
+        return false;
+    }
+
+    quint64 size = qFromBigEndian<quint32>(header);
+    box.type = qFromBigEndian<quint32>(header + 4);
+    box.payload = offset + 8;
+    if (size == 1) {
+        const uchar *largeSize = at(offset + 8, 8);
+        if (!largeSize) {
+            return false;
+        }
+        size = qFromBigEndian<quint64>(largeSize);
+        box.payload = offset + 16;
+    } else if (size == 0) {
+        size = quint64(end - offset);
+    }
+
+    if (size < quint64(box.payload - offset) || size > quint64(end - offset)) {
+        return false;
+    }
+    box.end = offset + qint64(size);
+    return true;
+}
+
+bool MediaProbe::findBox(qint64 start, qint64 end, quint32 type, Box &box)
+{
+    for (qint64 offset = start; readBox(offset, end, box); offset = box.end) {
+        if (box.type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediaProbe::probeMp4()
+{
+    Box moov;
+    if (findBox(0, m_size, fourCC("moov"), moov)) {
+        readMoov(moov);
+    }
+}
+
+void MediaProbe::readMoov(const Box &moov)
+{
+    quint32 timescale = 0;
+    quint64 duration = 0;
+    quint64 fragmentDuration = 0;
+
+    Box box;
+    for (qint64 offset = moov.payload; readBox(offset, moov.end, box); offset = box.end) {
+        if (box.type == fourCC("mvhd")) {
+            // version 1 has 64-bit times and duration
+            const uchar *header = at(box.payload, 32);
+            if (header && header[0] == 1) {
+                timescale = qFromBigEndian<quint32>(header + 20);
+                duration = qFromBigEndian<quint64>(header + 24);
+            } else if ((header = at(box.payload, 20))) {
+                timescale = qFromBigEndian<quint32>(header + 12);
+                duration = qFromBigEndian<quint32>(header + 16);
+                if (duration == 0xFFFFFFFF) {
+                    duration = 0; // unknown
+                }
+            }
+        } else if (box.type == fourCC("mvex")) {
+            // Fragmented files: moov covers no samples, mehd has the total
+            Box mehd;
+            if (findBox(box.payload, box.end, fourCC("mehd"), mehd)) {
+                const uchar *header = at(mehd.payload, 12);
+                if (header && header[0] == 1) {
+                    fragmentDuration = qFromBigEndian<quint64>(header + 4);
+                } else if ((header = at(mehd.payload, 8))) {
+                    fragmentDuration = qFromBigEndian<quint32>(header + 4);
+                }
+            }
+        } else if (box.type == fourCC("trak")) {
+            takeTrack(readTrak(box));
+        }
+    }
+
+    if (duration == 0) {
+        duration = fragmentDuration;
+    }
+    if (timescale > 0) {
+        m_info.durationMs = qint64(double(duration) * 1000 / timescale);
+    }
+}
+
+MediaProbe::Track MediaProbe::readTrak(const Box &trak)
+{
+    Track track;
+
+    // Presentation size, 16.16 fixed point, in the last 8 bytes of either version
+    Box tkhd;
+    if (findBox(trak.payload, trak.end, fourCC("tkhd"), tkhd)) {
+        const uchar *size = tkhd.end - tkhd.payload >= 84 ? at(tkhd.end - 8, 8) : nullptr;
+        if (size) {
+            track.width = int(qFromBigEndian<quint32>(size) >> 16);
+            track.height = int(qFromBigEndian<quint32>(size + 4) >> 16);
+        }
+    }
+
+    Box mdia, hdlr, minf, stbl, stsd;
+    if (!findBox(trak.payload, trak.end, fourCC("mdia"), mdia)) {
+        return track;
+    }
+    if (findBox(mdia.payload, mdia.end, fourCC("hdlr"), hdlr)) {
+        const uchar *header = at(hdlr.payload, 12);
+        if (header) {
+            quint32 handler = qFromBigEndian<quint32>(header + 8);
+            track.isVideo = handler == fourCC("vide") && track.width > 0 && track.height > 0;
+            track.isAudio = handler == fourCC("soun");
+        }
+    }
+
+    // The first sample description's format is the codec
+    if (findBox(mdia.payload, mdia.end, fourCC("minf"), minf) &&
+        findBox(minf.payload, minf.end, fourCC("stbl"), stbl) &&
+        findBox(stbl.payload, stbl.end, fourCC("stsd"), stsd)) {
+        const uchar *header = at(stsd.payload, 16);
+        if (header && qFromBigEndian<quint32>(header + 4) > 0) {
+            track.codec = QString::fromLatin1(reinterpret_cast<const char*>(header + 12), 4).trimmed();
+        }
+    }
+    return track;
+}
+
+// Matroska / WebM: EBML elements, each an ID and a size written as
+// variable-length integers. Info and Tracks normally come before the
+// clusters; muxers that write them later point to them from the SeekHead.
+
+bool MediaProbe::readVint(qint64 offset, qint64 end, bool keepMarker, quint64 &value, int &length)
+{
+    const uchar *first = offset < end ? at(offset, 1) : nullptr;
+    if (!first || *first == 0) {
+        return false; // longer than 8 bytes is not valid
+    }
+
+    // The leading zero bits of the first byte give the length
+    length = 1;
+    while (!(*first & (0x80 >> (length - 1)))) {
+        ++length;
+    }
+    const uchar *data = end - offset >= length ? at(offset, length) : nullptr;
+    if (!data) {
+        return false;
+    }
+
+    value = keepMarker ? data[0] : data[0] & (0xFF >> length);
+    for (int i = 1; i < length; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return true;
+}
+
+bool MediaProbe::readElement(qint64 offset, qint64 end, Box &element)
+{
+    quint64 id, size;
+    int idLength, sizeLength;
+    if (!countStep() || !readVint(offset, end, true, id, idLength) || idLength > 4 ||
+        !readVint(offset + idLength, end, false, size, sizeLength)) {
+        return false;
+    }
+
+    element.type = quint32(id);
+    element.payload = offset + idLength + sizeLength;
+    if (size == (quint64(1) << (7 * sizeLength)) - 1) {
+        element.end = end; // unknown size, i.e. while live streaming: runs to the end of its parent
+    } else if (size <= quint64(end - element.payload)) {
+        element.end = element.payload + qint64(size);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+quint64 MediaProbe::readUInt(const Box &element)
+{
+    const qint64 length = element.end - element.payload;
+    const uchar *data = length <= 8 ? at(element.payload, length) : nullptr;
+    quint64 value = 0;
+    for (qint64 i = 0; data && i < length; ++i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+double MediaProbe::readFloat(const Box &element)
+{
+    const qint64 length = element.end - element.payload;
+    const uchar *data = length == 4 || length == 8 ? at(element.payload, length) : nullptr;
+    if (!data) {
+        return 0;
+    }
+    if (length == 4) {
+        quint32 bits = qFromBigEndian<quint32>(data);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    quint64 bits = qFromBigEndian<quint64>(data);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+QString MediaProbe::readString(const Box &element)
+{
+    const qint64 length = element.end - element.payload;
+    const uchar *data = length <= 64 ? at(element.payload, length) : nullptr;
+    if (!data) {
+        return QString();
+    }
+    // Padded with zero bytes to the element size
+    const char *text = reinterpret_cast<const char*>(data);
+    return QString::fromLatin1(text, qsizetype(qstrnlen(text, size_t(length))));
+}
+
+void MediaProbe::probeMatroska()
+{
+    Box header, segment;
+    if (!readElement(0, m_size, header) || header.type != EBML_HEADER) {
+        return;
+    }
+    bool found = false;
+    for (qint64 offset = header.end; !found && readElement(offset, m_size, segment); offset = segment.end) {
+        found = segment.type == EBML_SEGMENT;
+    }
+    if (!found) {
+        return;
+    }
+
+    bool haveInfo = false;
+    bool haveTracks = false;
+    qint64 infoAt = -1;
+    qint64 tracksAt = -1;
+    Box element;
+    for (qint64 offset = segment.payload; !(haveInfo && haveTracks) && readElement(offset, segment.end, element);
+         offset = element.end) {
+        if (element.type == EBML_SEEK_HEAD) {
+            readSeekHead(element, segment.payload, infoAt, tracksAt);
+        } else if (element.type == EBML_INFO) {
+            readInfo(element);
+            haveInfo = true;
+        } else if (element.type == EBML_TRACKS) {
+            readTracks(element);
+            haveTracks = true;
+        } else if (element.type == EBML_CLUSTER) {
+            break; // the media data; walking it would read the whole file
+        }
+    }
+
+    if (!haveInfo && infoAt >= 0 && readElement(infoAt, segment.end, element) && element.type == EBML_INFO) {
+        readInfo(element);
+    }
+    if (!haveTracks && tracksAt >= 0 && readElement(tracksAt, segment.end, element) &&
+        element.type == EBML_TRACKS) {
+        readTracks(element);
+    }
+}
+
+void MediaProbe::readSeekHead(const Box &seekHead, qint64 segmentStart, qint64 &infoAt, qint64 &tracksAt)
+{
+    Box seek, field;
+    for (qint64 offset = seekHead.payload; readElement(offset, seekHead.end, seek); offset = seek.end) {
+        if (seek.type != EBML_SEEK) {
+            continue;
+        }
+        quint64 id = 0;
+        quint64 position = 0;
+        for (qint64 inner = seek.payload; readElement(inner, seek.end, field); inner = field.end) {
+            if (field.type == EBML_SEEK_ID) {
+                id = readUInt(field); // the target's ID, stored as bytes
+            } else if (field.type == EBML_SEEK_POSITION) {
+                position = readUInt(field);
+            }
+        }
+        // Positions are relative to the start of the segment's payload
+        if (position < quint64(m_size - segmentStart)) {
+            if (id == EBML_INFO) {
+                infoAt = segmentStart + qint64(position);
+            } else if (id == EBML_TRACKS) {
+                tracksAt = segmentStart + qint64(position);
+            }
+        }
+    }
+}
+
+void MediaProbe::readInfo(const Box &info)
+{
+    quint64 timecodeScale = 1000000; // ns per tick, the default
+    double duration = 0;
+    Box element;
+    for (qint64 offset = info.payload; readElement(offset, info.end, element); offset = element.end) {
+        if (element.type == EBML_TIMECODE_SCALE) {
+            timecodeScale = readUInt(element);
+        } else if (element.type == EBML_DURATION) {
+            duration = readFloat(element);
+        }
+    }
+    if (duration > 0) {
+        m_info.durationMs = qint64(duration * double(timecodeScale) / 1000000);
+    }
+}
+
+void MediaProbe::readTracks(const Box &tracks)
+{
+    Box entry, element, video;
+    for (qint64 offset = tracks.payload; readElement(offset, tracks.end, entry); offset = entry.end) {
+        if (entry.type != EBML_TRACK_ENTRY) {
+            continue;
+        }
+
+        Track track;
+        for (qint64 inner = entry.payload; readElement(inner, entry.end, element); inner = element.end) {
+            if (element.type == EBML_TRACK_TYPE) {
+                quint64 type = readUInt(element);
+                track.isVideo = type == 1;
+                track.isAudio = type == 2;
+            } else if (element.type == EBML_CODEC_ID) {
+                track.codec = readString(element);
+            } else if (element.type == EBML_VIDEO) {
+                for (qint64 v = element.payload; readElement(v, element.end, video); v = video.end) {
+                    if (video.type == EBML_PIXEL_WIDTH) {
+                        track.width = int(readUInt(video));
+                    } else if (video.type == EBML_PIXEL_HEIGHT) {
+                        track.height = int(readUInt(video));
+                    }
+                }
+            }
+        }
+        takeTrack(track);
+    }
+}
+
+// WAV: RIFF chunks, little-endian and padded to even sizes. fmt comes
+// before data, and data is the audio itself. RF64 (WAV over 4GB) puts the
+// real data size in ds64 and writes 0xFFFFFFFF in the data chunk.
+
+void MediaProbe::probeWav()
+{
+    const bool rf64 = startsWith(0, "RF64");
+    quint64 dataSize64 = 0;
+    quint16 format = 0;
+    quint32 byteRate = 0;
+
+    qint64 offset = 12;
+    const uchar *chunk;
+    while (countStep() && (chunk = at(offset, 8))) {
+        const quint64 size = qFromLittleEndian<quint32>(chunk + 4);
+        const qint64 payload = offset + 8;
+
+        if (memcmp(chunk, "ds64", 4) == 0) {
+            const uchar *ds64 = at(payload, 24);
+            if (ds64) {
+                dataSize64 = qFromLittleEndian<quint64>(ds64 + 8);
+            }
+        } else if (memcmp(chunk, "fmt ", 4) == 0) {
+            const uchar *fmt = at(payload, 16);
+            if (fmt) {
+                format = qFromLittleEndian<quint16>(fmt);
+                byteRate = qFromLittleEndian<quint32>(fmt + 8);
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            quint64 dataSize = rf64 && size == 0xFFFFFFFF ? dataSize64 : size;
+            dataSize = qMin<quint64>(dataSize, quint64(m_size - payload)); // a recording cut short
+            if (byteRate > 0) {
+                m_info.durationMs = qint64(dataSize * 1000 / byteRate);
+                m_info.bitrate = qint64(byteRate) * 8;
+            }
+            break;
+        }
+        offset = payload + qint64(size + (size & 1));
+    }
+
+    switch (format) {
+    case 0:
+        break;
+    case 1:
+    case 0xFFFE: // extensible, PCM in practice
+        m_info.codec = "pcm";
+        break;
+    case 3:
+        m_info.codec = "pcm_float";
+        break;
+    default:
+        m_info.codec = QString("wav_0x%1").arg(uint(format), 4, 16, QChar('0'));
+        break;
+    }
+}
+
+// FLAC: "fLaC", then metadata blocks, the first always STREAMINFO with
+// the sample rate (20 bits) and total samples (36 bits) packed together.
+
+void MediaProbe::probeFlac(qint64 start)
+{
+    if (!startsWith(start, "fLaC")) {
+        return;
+    }
+    const uchar *block = at(start + 4, 4 + 34);
+    if (!block || (block[0] & 0x7F) != 0) {
+        return;
+    }
+
+    const uchar *info = block + 4;
+    const quint32 sampleRate = quint32(info[10]) << 12 | quint32(info[11]) << 4 | info[12] >> 4;
+    const quint64 samples = quint64(info[13] & 0x0F) << 32 | qFromBigEndian<quint32>(info + 14);
+    m_info.codec = "flac";
+    if (sampleRate > 0 && samples > 0) {
+        m_info.durationMs = qint64(samples * 1000 / sampleRate);
+    }
+}
+
+// Images: only the dimensions, which every format keeps near the start
+
+void MediaProbe::probeJpeg()
+{
+    // Segments up to the frame header; EXIF and embedded previews are stepped over by length
+    qint64 offset = 2;
+    const uchar *marker;
+    while (countStep() && (marker = at(offset, 4)) && marker[0] == 0xFF) {
+        const uchar type = marker[1];
+        if (type == 0xFF) {
+            ++offset; // fill byte
+            continue;
+        }
+        if (type == 0x01 || (type >= 0xD0 && type <= 0xD7)) {
+            offset += 2; // no payload
+            continue;
+        }
+        if (type == 0xD9 || type == 0xDA) {
+            return; // end of image or start of scan: no frame header
+        }
+
+        const quint16 length = qFromBigEndian<quint16>(marker + 2);
+        if (length < 2) {
+            return;
+        }
+        // SOF0-SOF15, except DHT, JPG and DAC which share the range
+        if (type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC) {
+            const uchar *frame = at(offset + 4, 5);
+            if (frame) {
+                m_info.height = qFromBigEndian<quint16>(frame + 1);
+                m_info.width = qFromBigEndian<quint16>(frame + 3);
+                m_info.codec = "jpeg";
+            }
+            return;
+        }
+        offset += 2 + length;
+    }
+}
+
+void MediaProbe::probePng()
+{
+    const uchar *header = at(0, 24);
+    if (header && memcmp(header + 12, "IHDR", 4) == 0) {
+        m_info.width = int(qFromBigEndian<quint32>(header + 16));
+        m_info.height = int(qFromBigEndian<quint32>(header + 20));
+        m_info.codec = "png";
+    }
+}
+
+void MediaProbe::probeGif()
+{
+    const uchar *header = at(0, 10);
+    if (header) {
+        m_info.width = qFromLittleEndian<quint16>(header + 6);
+        m_info.height = qFromLittleEndian<quint16>(header + 8);
+        m_info.codec = "gif";
+    }
+}
+
+void MediaProbe::probeBmp()
+{
+    const uchar *header = at(0, 26);
+    if (!header) {
+        return;
+    }
+
+    // "BM" alone is a weak signature; the DIB header size must be one of the known ones
+    const quint32 dibSize = qFromLittleEndian<quint32>(header + 14);
+    if (dibSize == 12) {
+        m_info.width = qFromLittleEndian<quint16>(header + 18);
+        m_info.height = qFromLittleEndian<quint16>(header + 20);
+    } else if (dibSize == 40 || dibSize == 52 || dibSize == 56 || dibSize == 108 || dibSize == 124) {
+        m_info.width = qAbs(qFromLittleEndian<qint32>(header + 18));
+        m_info.height = qAbs(qFromLittleEndian<qint32>(header + 22)); // negative when stored top-down
+    } else {
+        return;
+    }
+    m_info.codec = "bmp";
+}
+
+void MediaProbe::probeWebp()
+{
+    const uchar *chunk = at(12, 18);
+    if (!chunk) {
+        return;
+    }
+
+    const uchar *data = chunk + 8;
+    if (memcmp(chunk, "VP8X", 4) == 0) {
+        // Extended: 24-bit canvas size minus one
+        m_info.width = 1 + int(data[4] | data[5] << 8 | data[6] << 16);
+        m_info.height = 1 + int(data[7] | data[8] << 8 | data[9] << 16);
+    } else if (memcmp(chunk, "VP8L", 4) == 0 && data[0] == 0x2F) {
+        // Lossless: 14-bit sizes minus one after the signature byte
+        const quint32 bits = qFromLittleEndian<quint32>(data + 1);
+        m_info.width = 1 + int(bits & 0x3FFF);
+        m_info.height = 1 + int((bits >> 14) & 0x3FFF);
+    } else if (memcmp(chunk, "VP8 ", 4) == 0 && data[3] == 0x9D && data[4] == 0x01 && data[5] == 0x2A) {
+        // Lossy: key frame start code, then 14-bit sizes
+        m_info.width = qFromLittleEndian<quint16>(data + 6) & 0x3FFF;
+        m_info.height = qFromLittleEndian<quint16>(data + 8) & 0x3FFF;
+    } else {
+        return;
+    }
+    m_info.codec = "webp";
+}
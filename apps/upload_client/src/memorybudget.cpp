@@ -0,0 +1,130 @@
+#include "memorybudget.h"
+#include "settings.h"
+
+const qint64 MemoryBudget::MIN_LIMIT = 4 * 1024 * 1024; // 4MB
+
+MemoryBudget* MemoryBudget::instance()
+{
+    static MemoryBudget instance;
+    return &instance;
+}
+
+MemoryBudget::MemoryBudget(QObject *parent)
+    : QObject(parent)
+    , m_limit(0)
+    , m_used(0)
+    , m_peak(0)
+    , m_refused(false)
+    , m_shortPending(false)
+    , m_availablePending(false)
+{
+    connect(Settings::instance(), &Settings::settingsChanged,
+            this, &MemoryBudget::onSettingsChanged);
+    setLimit(Settings::instance()->getMemoryBudget());
+}
+
+MemoryBudget::~MemoryBudget()
+{
+}
+
+void MemoryBudget::setLimit(qint64 bytes)
+{
+    m_limit = qMax(MIN_LIMIT, bytes);
+    if (m_refused && m_used < m_limit) {
+        notify(true);
+    }
+}
+
+qint64 MemoryBudget::limit() const
+{
+    return m_limit;
+}
+
+qint64 MemoryBudget::used() const
+{
+    return m_used;
+}
+
+qint64 MemoryBudget::peak() const
+{
+    return m_peak;
+}
+
+void MemoryBudget::resetPeak()
+{
+    m_peak = m_used;
+}
+
+bool MemoryBudget::tryAcquire(qint64 bytes)
+{
+    if (bytes <= 0) {
+        return true;
+    }
+
+    // Too big to ever fit still goes through alone, or it would wait forever
+    if (m_used > 0 && m_used + bytes > m_limit) {
+        if (!m_refused) {
+            m_refused = true;
+            notify(false);
+        }
+        return false;
+    }
+    take(bytes);
+    return true;
+}
+
+void MemoryBudget::acquire(qint64 bytes)
+{
+    if (bytes > 0) {
+        take(bytes);
+    }
+}
+
+void MemoryBudget::release(qint64 bytes)
+{
+    if (bytes <= 0) {
+        return;
+    }
+
+    m_used = qMax<qint64>(0, m_used - bytes);
+    if (m_refused) {
+        notify(true);
+    }
+}
+
+void MemoryBudget::onSettingsChanged(const QString &group, const QString &key, const QVariant &value)
+{
+    if (group == "upload" && key == "memoryBudget") {
+        setLimit(value.toLongLong());
+    } else if (group.isEmpty() || (group == "upload" && key.isEmpty())) {
+        setLimit(Settings::instance()->getMemoryBudget()); // settings were cleared
+    }
+}
+
+void MemoryBudget::take(qint64 bytes)
+{
+    m_used += bytes;
+    m_peak = qMax(m_peak, m_used);
+}
+
+void MemoryBudget::notify(bool available)
+{
+    // Queued and coalesced: callers are usually in the middle of changing
+    // their own state when they acquire or release
+    bool &pending = available ? m_availablePending : m_shortPending;
+    if (pending) {
+        return;
+    }
+    pending = true;
+
+    QMetaObject::invokeMethod(this, [this, available]() {
+        if (available) {
+            m_availablePending = false;
+            m_refused = false;
+            emit memoryAvailable();
+        } else {
+            m_shortPending = false;
+            emit memoryShort();
+        }
+    }, Qt::QueuedConnection);
+}
@@ -1,6 +1,6 @@
 #include "networkmanager.h"
-#include <QHttpMultiPart>
-#include <QHttpPart>
+#include "uploadstream.h"
+#include "networktransport.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QSettings>
@@ -14,14 +14,16 @@ NetworkManager::NetworkManager(QObject *parent)
     : QObject(parent)
     , m_networkManager(nullptr)
     , m_timeout(30000) // 30 seconds default
+    , m_streamBufferSize(1024 * 1024) // 1MB read-ahead per transfer
     , m_isOnline(true)
 {
-    m_networkManager = new QNetworkAccessManager(this);
+    m_networkManager = NetworkTransport::instance();
     
     // Load settings
     QSettings settings;
     m_serverUrl = settings.value("network/serverUrl", "http://localhost:3000").toString();
     m_timeout = settings.value("network/timeout", 30000).toInt();
+    m_streamBufferSize = settings.value("upload/streamBufferSize", 1024 * 1024).toLongLong();
     
     // Connect network manager signals
     // Note: networkAccessibleChanged was removed in Qt6
@@ -145,41 +147,23 @@ QNetworkReply* NetworkManager::uploadFile(const QString &endpoint, const QString
     
     setupRequest(request, endpoint);
     
-    // Create multipart request
-    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
-    
-    // Add file part
-    QHttpPart filePart;
-    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/octet-stream"));
-    filePart.setHeader(QNetworkRequest::ContentDispositionHeader, 
-                      QVariant(QString("form-data; name=\"file\"; filename=\"%1\"").arg(fileInfo.fileName())));
-    
-    QFile file(filePath);
-    if (file.open(QIODevice::ReadOnly)) {
-        filePart.setBody(file.readAll());
-        file.close();
-    } else {
+    // Stream the file from disk instead of reading it into memory
+    UploadStream *stream = UploadStream::createMultipart(filePath, fileInfo.fileName(), metadata);
+    if (!stream) {
         QMutexLocker locker(&m_errorMutex);
         m_lastError = QString("Cannot open file: %1").arg(filePath);
         emit networkError(m_lastError);
-        delete multiPart;
         return nullptr;
     }
-    multiPart->append(filePart);
+    stream->setBufferSize(m_streamBufferSize);
+    stream->open(QIODevice::ReadOnly);
     
-    // Add metadata if provided
-    if (!metadata.isEmpty()) {
-        QHttpPart metadataPart;
-        metadataPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"metadata\""));
-        
-        QJsonDocument metadataDoc(metadata);
-        metadataPart.setBody(metadataDoc.toJson());
-        multiPart->append(metadataPart);
-    }
+    request.setHeader(QNetworkRequest::ContentTypeHeader, stream->contentType());
+    request.setHeader(QNetworkRequest::ContentLengthHeader, stream->size());
     
     // Send request
-    QNetworkReply *reply = m_networkManager->post(request, multiPart);
-    multiPart->setParent(reply); // Set parent for cleanup
+    QNetworkReply *reply = m_networkManager->post(request, stream);
+    stream->setParent(reply); // Set parent for cleanup
     
     trackRequest(reply, endpoint);
     
@@ -0,0 +1,124 @@
+#include "networktransport.h"
+#include <QCoreApplication>
+#include <QNetworkRequest>
+#include <QSettings>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+#include <QHttp1Configuration>
+#endif
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+
+// Idle keep-alive connections outlive this, so warming more often gains nothing
+const qint64 NetworkTransport::PREWARM_INTERVAL = 30000; // 30 seconds
+
+NetworkTransport* NetworkTransport::instance()
+{
+    // Owned by the application so it is torn down before Qt's networking is
+    static NetworkTransport *instance = new NetworkTransport(QCoreApplication::instance());
+    return instance;
+}
+
+NetworkTransport::NetworkTransport(QObject *parent)
+    : QNetworkAccessManager(parent)
+    , m_http2Allowed(true)
+    , m_maxConnectionsPerHost(6)
+    , m_prewarmConnections(3)
+{
+    QSettings settings;
+    m_http2Allowed = settings.value("network/http2", true).toBool();
+    m_maxConnectionsPerHost = qBound(1, settings.value("network/maxConnectionsPerHost", 6).toInt(), 32);
+    m_prewarmConnections = qBound(0, settings.value("network/prewarmConnections",
+        settings.value("upload/maxConcurrent", 3)).toInt(), m_maxConnectionsPerHost);
+
+#if QT_CONFIG(ssl)
+    // Resume TLS sessions instead of doing a full handshake per connection.
+    // Kept to this transport's requests; the process-wide default is left alone
+    m_sslConfiguration = QSslConfiguration::defaultConfiguration();
+    m_sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionTickets, false);
+    m_sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionSharing, false);
+    m_sslConfiguration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+#endif
+}
+
+NetworkTransport::~NetworkTransport()
+{
+}
+
+void NetworkTransport::prewarm(const QUrl &serverUrl)
+{
+    if (!serverUrl.isValid() || serverUrl.host().isEmpty() || m_prewarmConnections == 0) {
+        return;
+    }
+
+    bool secure = serverUrl.scheme() == "https";
+    quint16 port = static_cast<quint16>(serverUrl.port(secure ? 443 : 80));
+    QString origin = QString("%1://%2:%3").arg(serverUrl.scheme(), serverUrl.host()).arg(port);
+
+    auto last = m_prewarmed.find(origin);
+    if (last != m_prewarmed.end() && !last->hasExpired(PREWARM_INTERVAL)) {
+        return;
+    }
+    m_prewarmed[origin].start();
+
+    // Over HTTP/2 one connection carries every request; otherwise open one per upload slot
+#if QT_CONFIG(ssl)
+    if (secure) {
+        QSslConfiguration ssl = m_sslConfiguration;
+        if (m_http2Allowed) {
+            ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                         QSslConfiguration::NextProtocolHttp1_1});
+        }
+        int connections = m_http2Allowed ? 1 : m_prewarmConnections;
+        for (int i = 0; i < connections; ++i) {
+            connectToHostEncrypted(serverUrl.host(), port, ssl);
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < m_prewarmConnections; ++i) {
+        connectToHost(serverUrl.host(), port);
+    }
+}
+
+bool NetworkTransport::isHttp2Allowed() const
+{
+    return m_http2Allowed;
+}
+
+int NetworkTransport::maxConnectionsPerHost() const
+{
+    return m_maxConnectionsPerHost;
+}
+
+int NetworkTransport::prewarmConnections() const
+{
+    return m_prewarmConnections;
+}
+
+QNetworkReply* NetworkTransport::createRequest(Operation op, const QNetworkRequest &originalRequest,
+                                               QIODevice *outgoingData)
+{
+    QNetworkRequest request(originalRequest);
+
+    // Settings the caller put on the request win over the transport policy
+#if QT_CONFIG(ssl)
+    if (request.url().scheme() == "https"
+        && request.sslConfiguration() == QSslConfiguration::defaultConfiguration()) {
+        request.setSslConfiguration(m_sslConfiguration);
+    }
+#endif
+    // HTTP/2 is only negotiated through TLS ALPN; plain http stays on HTTP/1.1
+    if (!request.attribute(QNetworkRequest::Http2AllowedAttribute).isValid()) {
+        request.setAttribute(QNetworkRequest::Http2AllowedAttribute, m_http2Allowed);
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    if (request.http1Configuration() == QHttp1Configuration()) {
+        QHttp1Configuration http1;
+        http1.setNumberOfConnectionsPerHost(m_maxConnectionsPerHost);
+        request.setHttp1Configuration(http1);
+    }
+#endif
+
+    return QNetworkAccessManager::createRequest(op, request, outgoingData);
+}
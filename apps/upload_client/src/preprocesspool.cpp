@@ -0,0 +1,235 @@
+#include "preprocesspool.h"
+#include "hashcache.h"
+#include "memorybudget.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QThread>
+
+const qint64 PreprocessPool::DEFAULT_MAX_BYTES_AHEAD = 2LL * 1024 * 1024 * 1024; // 2GB
+const qint64 PreprocessPool::MAP_WINDOW_SIZE = 64 * 1024 * 1024; // 64MB
+const qint64 PreprocessPool::READ_BLOCK_SIZE = 4 * 1024 * 1024; // 4MB
+
+PreprocessPool* PreprocessPool::instance()
+{
+    static PreprocessPool instance;
+    return &instance;
+}
+
+PreprocessPool::PreprocessPool(QObject *parent)
+    : QObject(parent)
+    , m_bytesAhead(0)
+    , m_maxBytesAhead(DEFAULT_MAX_BYTES_AHEAD)
+{
+    qRegisterMetaType<PreprocessResult>("PreprocessResult");
+
+    // Workers use the cache; constructing it first keeps it alive until they are done
+    HashCache::instance();
+
+    QSettings settings;
+    setThreadCount(settings.value("preprocess/threads", QThread::idealThreadCount()).toInt());
+    setMaxBytesAhead(settings.value("preprocess/maxBytesAhead", DEFAULT_MAX_BYTES_AHEAD).toLongLong());
+
+    connect(MemoryBudget::instance(), &MemoryBudget::memoryAvailable, this, &PreprocessPool::dispatch);
+}
+
+PreprocessPool::~PreprocessPool()
+{
+    m_waiting.clear();
+    m_waitingSizes.clear();
+    m_pool.waitForDone();
+}
+
+void PreprocessPool::submit(const QString &filePath, bool urgent, qint64 fileSize)
+{
+    // Finished earlier and still held for upload: answer from the stored result
+    auto done = m_results.constFind(filePath);
+    if (done != m_results.constEnd()) {
+        PreprocessResult result = done.value();
+        QMetaObject::invokeMethod(this, [this, result]() {
+            emit fileProcessed(result);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (m_running.contains(filePath)) {
+        return;
+    }
+
+    auto waiting = m_waitingSizes.find(filePath);
+    if (urgent) {
+        qint64 size = fileSize;
+        if (waiting != m_waitingSizes.end()) {
+            size = waiting.value();
+            m_waitingSizes.erase(waiting); // its queue entry is skipped later
+        }
+        MemoryBudget::instance()->acquire(READ_BLOCK_SIZE);
+        start(filePath, size >= 0 ? size : QFileInfo(filePath).size());
+        return;
+    }
+
+    if (waiting == m_waitingSizes.end()) {
+        m_waitingSizes.insert(filePath, fileSize >= 0 ? fileSize : QFileInfo(filePath).size());
+        m_waiting.enqueue(filePath);
+    }
+    dispatch();
+}
+
+void PreprocessPool::release(const QString &filePath)
+{
+    m_waitingSizes.remove(filePath);
+    m_results.remove(filePath);
+
+    auto it = m_admitted.find(filePath);
+    if (it != m_admitted.end()) {
+        m_bytesAhead -= it.value();
+        m_admitted.erase(it);
+    }
+
+    dispatch();
+}
+
+void PreprocessPool::setMaxBytesAhead(qint64 bytes)
+{
+    m_maxBytesAhead = qMax<qint64>(READ_BLOCK_SIZE, bytes);
+    dispatch();
+}
+
+qint64 PreprocessPool::maxBytesAhead() const
+{
+    return m_maxBytesAhead;
+}
+
+qint64 PreprocessPool::bytesAhead() const
+{
+    return m_bytesAhead;
+}
+
+void PreprocessPool::setThreadCount(int threads)
+{
+    m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+int PreprocessPool::threadCount() const
+{
+    return m_pool.maxThreadCount();
+}
+
+QByteArray PreprocessPool::hashFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Blake2b_256);
+    const qint64 size = file.size();
+    qint64 offset = 0;
+
+    // Map a window at a time so huge files never pin their whole size in address space
+    while (offset < size) {
+        qint64 length = qMin(MAP_WINDOW_SIZE, size - offset);
+        uchar *data = file.map(offset, length);
+        if (!data) {
+            break; // e.g. network filesystems; finish with plain reads
+        }
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(data), length));
+        file.unmap(data);
+        offset += length;
+    }
+
+    if (offset < size) {
+        if (!file.seek(offset)) {
+            return QByteArray();
+        }
+        QByteArray buffer(READ_BLOCK_SIZE, Qt::Uninitialized);
+        qint64 got;
+        while ((got = file.read(buffer.data(), buffer.size())) > 0) {
+            hash.addData(QByteArrayView(buffer.constData(), got));
+            offset += got;
+        }
+        if (got < 0) {
+            return QByteArray();
+        }
+    }
+
+    return hash.result().toHex();
+}
+
+PreprocessResult PreprocessPool::process(const QString &filePath)
+{
+    PreprocessResult result;
+    result.filePath = filePath;
+    result.fileSize = QFileInfo(filePath).size();
+
+    // A few KB of headers; cheaper than a cache of its own
+    result.mediaInfo = MediaProbe::probe(filePath);
+
+    HashCache *cache = HashCache::instance();
+    result.contentHash = cache->cachedHash(filePath);
+    if (!result.contentHash.isEmpty()) {
+        return result;
+    }
+
+    QByteArray keyBefore = HashCache::fileKey(filePath);
+    result.contentHash = hashFile(filePath);
+
+    // Only cache if the file did not change while it was being read
+    if (!result.contentHash.isEmpty() && !keyBefore.isEmpty() &&
+        keyBefore == HashCache::fileKey(filePath)) {
+        cache->insert(keyBefore, result.contentHash);
+    }
+    return result;
+}
+
+void PreprocessPool::start(const QString &filePath, qint64 size)
+{
+    if (!m_admitted.contains(filePath)) {
+        m_admitted.insert(filePath, size);
+        m_bytesAhead += size;
+    }
+    m_running.insert(filePath);
+
+    m_pool.start([this, filePath]() {
+        PreprocessResult result = process(filePath);
+        QMetaObject::invokeMethod(this, [this, result]() {
+            onJobFinished(result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void PreprocessPool::dispatch()
+{
+    while (!m_waiting.isEmpty()) {
+        auto waiting = m_waitingSizes.constFind(m_waiting.head());
+        if (waiting == m_waitingSizes.constEnd()) {
+            m_waiting.dequeue(); // released or started urgently since
+            continue;
+        }
+        qint64 size = waiting.value();
+
+        // A file bigger than the whole budget still goes through once nothing else is ahead
+        if (m_bytesAhead > 0 && m_bytesAhead + size > m_maxBytesAhead) {
+            break;
+        }
+        if (!MemoryBudget::instance()->tryAcquire(READ_BLOCK_SIZE)) {
+            break;
+        }
+        m_waitingSizes.erase(waiting);
+        start(m_waiting.dequeue(), size);
+    }
+}
+
+void PreprocessPool::onJobFinished(const PreprocessResult &result)
+{
+    m_running.remove(result.filePath);
+    MemoryBudget::instance()->release(READ_BLOCK_SIZE);
+
+    // Released while running means the caller no longer needs it held
+    if (m_admitted.contains(result.filePath)) {
+        m_results.insert(result.filePath, result);
+    }
+
+    emit fileProcessed(result);
+}
@@ -0,0 +1,223 @@
+#include "readaheadpool.h"
+#include "memorybudget.h"
+#include <QFile>
+#include <QSettings>
+
+const qint64 ReadAheadPool::DEFAULT_BLOCK_SIZE = 256 * 1024; // 256KB
+const qint64 ReadAheadPool::DEFAULT_MEMORY_LIMIT = 64 * 1024 * 1024; // 64MB
+
+ReadAheadPool* ReadAheadPool::instance()
+{
+    static ReadAheadPool instance;
+    return &instance;
+}
+
+ReadAheadPool::ReadAheadPool(QObject *parent)
+    : QObject(parent)
+    , m_nextTicket(1)
+    , m_buffersInUse(0)
+    , m_maxBuffers(1)
+    , m_blockSize(DEFAULT_BLOCK_SIZE)
+{
+    QSettings settings;
+    m_blockSize = qBound<qint64>(4096, settings.value("upload/readBlockSize", DEFAULT_BLOCK_SIZE).toLongLong(),
+                                 16 * 1024 * 1024);
+    qint64 memory = settings.value("upload/readAheadMemory", DEFAULT_MEMORY_LIMIT).toLongLong();
+    m_maxBuffers = static_cast<int>(qBound<qint64>(2, memory / m_blockSize, 4096));
+
+    // Disk reads do not scale with cores; a couple in flight keep a drive busy
+    m_pool.setMaxThreadCount(qBound(1, settings.value("upload/readThreads", 2).toInt(), 16));
+
+    connect(MemoryBudget::instance(), &MemoryBudget::memoryShort, this, &ReadAheadPool::onMemoryShort);
+}
+
+ReadAheadPool::~ReadAheadPool()
+{
+    m_pool.waitForDone();
+}
+
+qint64 ReadAheadPool::blockSize() const
+{
+    return m_blockSize;
+}
+
+qint64 ReadAheadPool::memoryLimit() const
+{
+    return m_maxBuffers * m_blockSize;
+}
+
+bool ReadAheadPool::fetch(const QString &filePath, qint64 offset, bool urgent)
+{
+    Key key(filePath, offset);
+    if (m_inFlight.contains(key) || m_ready.contains(key)) {
+        return true;
+    }
+
+    QByteArray buffer;
+    if (!acquireBuffer(urgent, &buffer)) {
+        return false;
+    }
+
+    quint64 ticket = m_nextTicket++;
+    m_inFlight.insert(key, ticket);
+
+    qint64 blockSize = m_blockSize;
+    // Moved rather than copied, so the worker never detaches the buffer
+    m_pool.start([this, key, ticket, buffer = std::move(buffer), blockSize]() mutable {
+        buffer.resize(blockSize);
+        bool failed = !readBlock(key.first, key.second, buffer);
+        QMetaObject::invokeMethod(this, [this, key, ticket, buffer = std::move(buffer), failed]() {
+            onBlockRead(key, ticket, buffer, failed);
+        }, Qt::QueuedConnection);
+    });
+    return true;
+}
+
+void ReadAheadPool::prefetch(const QString &filePath, qint64 offset, qint64 length)
+{
+    for (qint64 pos = offset - offset % m_blockSize; pos < offset + length; pos += m_blockSize) {
+        // Later blocks would not fit either
+        if (!fetch(filePath, pos)) {
+            return;
+        }
+    }
+}
+
+ReadAheadPool::BlockState ReadAheadPool::take(const QString &filePath, qint64 offset, QByteArray *data)
+{
+    Key key(filePath, offset);
+    if (m_inFlight.contains(key)) {
+        return Pending;
+    }
+
+    auto it = m_ready.find(key);
+    if (it == m_ready.end()) {
+        return Missing;
+    }
+
+    bool failed = it->failed;
+    if (failed) {
+        recycle(it->data);
+    } else {
+        *data = std::move(it->data);
+    }
+    m_ready.erase(it);
+    m_readyOrder.removeOne(key);
+    return failed ? Failed : Ready;
+}
+
+void ReadAheadPool::recycle(QByteArray &buffer)
+{
+    if (buffer.capacity() == 0) {
+        return;
+    }
+
+    m_buffersInUse = qMax(0, m_buffersInUse - 1);
+    if (buffer.capacity() >= m_blockSize && m_free.size() + m_buffersInUse < m_maxBuffers) {
+        buffer.resize(0);
+        m_free.append(std::move(buffer));
+    } else {
+        MemoryBudget::instance()->release(m_blockSize);
+    }
+    buffer = QByteArray();
+}
+
+void ReadAheadPool::drop(const QString &filePath)
+{
+    // Reads still running come back to onBlockRead() and are recycled there
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end();) {
+        if (it.key().first == filePath) {
+            it = m_inFlight.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = m_ready.begin(); it != m_ready.end();) {
+        if (it.key().first == filePath) {
+            m_readyOrder.removeOne(it.key());
+            recycle(it->data);
+            it = m_ready.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool ReadAheadPool::readBlock(const QString &filePath, qint64 offset, QByteArray &buffer)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered) || !file.seek(offset)) {
+        buffer.resize(0);
+        return false;
+    }
+
+    // Short at the end of the file; empty past it
+    qint64 got = file.read(buffer.data(), buffer.size());
+    buffer.resize(qMax<qint64>(0, got));
+    return got >= 0;
+}
+
+bool ReadAheadPool::acquireBuffer(bool urgent, QByteArray *buffer)
+{
+    if (!m_free.isEmpty()) {
+        *buffer = m_free.takeLast();
+        m_buffersInUse++;
+        return true;
+    }
+    MemoryBudget *budget = MemoryBudget::instance();
+    if (m_buffersInUse < m_maxBuffers && budget->tryAcquire(m_blockSize)) {
+        buffer->reserve(m_blockSize);
+        m_buffersInUse++;
+        return true;
+    }
+    if (!urgent) {
+        return false;
+    }
+
+    // A stream is waiting on this block: take the buffer of the oldest one
+    // nobody has claimed, or go over budget rather than stall the upload
+    if (!m_readyOrder.isEmpty()) {
+        Key oldest = m_readyOrder.takeFirst();
+        *buffer = std::move(m_ready[oldest].data);
+        m_ready.remove(oldest);
+        return true;
+    }
+    budget->acquire(m_blockSize);
+    buffer->reserve(m_blockSize);
+    m_buffersInUse++;
+    return true;
+}
+
+void ReadAheadPool::onMemoryShort()
+{
+    // Spare buffers first; failing that, the oldest block nobody has claimed
+    // yet, which a stream can read again when it gets there
+    if (!m_free.isEmpty()) {
+        MemoryBudget::instance()->release(m_free.size() * m_blockSize);
+        m_free.clear();
+    } else if (!m_readyOrder.isEmpty()) {
+        m_ready.remove(m_readyOrder.takeFirst());
+        m_buffersInUse = qMax(0, m_buffersInUse - 1);
+        MemoryBudget::instance()->release(m_blockSize);
+    }
+}
+
+void ReadAheadPool::onBlockRead(const Key &key, quint64 ticket, const QByteArray &buffer, bool failed)
+{
+    auto it = m_inFlight.find(key);
+    if (it == m_inFlight.end() || it.value() != ticket) {
+        // Dropped while it was being read
+        QByteArray stale = buffer;
+        recycle(stale);
+        return;
+    }
+    m_inFlight.erase(it);
+
+    Block block;
+    block.data = buffer;
+    block.failed = failed;
+    m_ready.insert(key, block);
+    m_readyOrder.append(key);
+    emit blockReady(key.first, key.second);
+}
@@ -0,0 +1,207 @@
+#include "retrypolicy.h"
+#include <QDateTime>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+#include <QSettings>
+
+// A server asking for longer than this is treated as asking for this long
+const qint64 RetryPolicy::MAX_RETRY_AFTER = 10 * 60 * 1000; // 10 minutes
+
+RetryPolicy* RetryPolicy::instance()
+{
+    static RetryPolicy instance;
+    return &instance;
+}
+
+RetryPolicy::RetryPolicy()
+    : m_baseDelay(1000)
+    , m_maxDelay(60000)
+    , m_failureThreshold(5)
+    , m_openTime(30000)
+    , m_maxOpenTime(300000)
+{
+    QSettings settings;
+    m_baseDelay = qBound<qint64>(10, settings.value("network/retryBaseDelay", 1000).toLongLong(), 60000);
+    m_maxDelay = qMax(m_baseDelay, settings.value("network/retryMaxDelay", 60000).toLongLong());
+    m_failureThreshold = qMax(1, settings.value("network/circuitFailureThreshold", 5).toInt());
+    m_openTime = qMax<qint64>(1000, settings.value("network/circuitOpenTime", 30000).toLongLong());
+    m_maxOpenTime = qMax(m_openTime, settings.value("network/circuitMaxOpenTime", 300000).toLongLong());
+}
+
+RequestFailure RetryPolicy::classify(const QNetworkReply *reply)
+{
+    RequestFailure failure;
+    if (reply->error() == QNetworkReply::NoError) {
+        failure.kind = RequestFailure::None;
+        return failure;
+    }
+
+    failure.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (failure.httpStatus > 0) {
+        switch (failure.httpStatus) {
+        case 429:
+        case 503:
+            failure.kind = RequestFailure::Throttled;
+            failure.retryAfter = parseRetryAfter(reply->rawHeader("Retry-After"));
+            break;
+        case 401: // a new token may arrive through login in the meantime
+        case 408:
+        case 425:
+        case 500:
+        case 502:
+        case 504:
+            failure.kind = RequestFailure::Transient;
+            break;
+        default:
+            // Anything else the server rejected on purpose
+            failure.kind = RequestFailure::Fatal;
+            break;
+        }
+        return failure;
+    }
+
+    switch (reply->error()) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::OperationCanceledError: // transfer timeouts surface as cancels
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyNotFoundError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::ProtocolFailure:
+    case QNetworkReply::UnknownNetworkError:
+    case QNetworkReply::UnknownProxyError:
+        failure.kind = RequestFailure::Transient;
+        break;
+    default:
+        // TLS, redirect and unsupported-protocol errors do not fix themselves
+        failure.kind = RequestFailure::Fatal;
+        break;
+    }
+    return failure;
+}
+
+RequestFailure RetryPolicy::record(const QNetworkReply *reply)
+{
+    RequestFailure failure = classify(reply);
+    Circuit &circuit = m_circuits[hostKey(reply->url())];
+
+    if (!isHostFailure(failure)) {
+        // The host answered: whatever was wrong, it is up
+        circuit = Circuit();
+        return failure;
+    }
+
+    if (circuit.state == HalfOpen) {
+        // The probe failed; stay away longer this time
+        open(circuit, qMin(m_maxOpenTime, circuit.openTime * 2));
+    } else if (failure.kind == RequestFailure::Throttled && failure.retryAfter > 0) {
+        // The server said when to come back; hold everything until then
+        open(circuit, qMin(failure.retryAfter, MAX_RETRY_AFTER));
+    } else if (circuit.state == Closed && ++circuit.failures >= m_failureThreshold) {
+        open(circuit, m_openTime);
+    }
+    return failure;
+}
+
+qint64 RetryPolicy::retryDelay(const RequestFailure &failure, int attempt, const QUrl &url) const
+{
+    qint64 delay = 0;
+    if (failure.retryAfter >= 0) {
+        // Spread out the clients that were all told the same time
+        delay = qMin(failure.retryAfter, MAX_RETRY_AFTER) +
+                QRandomGenerator::global()->bounded(m_baseDelay + 1);
+    } else {
+        int exponent = qBound(0, attempt - 1, 30);
+        qint64 ceiling = qMin(m_maxDelay, m_baseDelay << exponent);
+        delay = QRandomGenerator::global()->bounded(ceiling + 1);
+    }
+    return qMax(delay, blockedFor(url));
+}
+
+bool RetryPolicy::allowRequest(const QUrl &url)
+{
+    auto it = m_circuits.find(hostKey(url));
+    if (it == m_circuits.end() || it->state == Closed) {
+        return true;
+    }
+
+    if (it->state == Open) {
+        if (!it->since.hasExpired(it->openTime)) {
+            return false;
+        }
+        it->state = HalfOpen;
+        it->probing = false;
+    }
+
+    // One probe at a time; one that never reports back is given up on after openTime
+    if (it->probing && !it->since.hasExpired(it->openTime)) {
+        return false;
+    }
+    it->probing = true;
+    it->since.start();
+    return true;
+}
+
+qint64 RetryPolicy::blockedFor(const QUrl &url) const
+{
+    auto it = m_circuits.constFind(hostKey(url));
+    if (it == m_circuits.constEnd() || it->state == Closed ||
+        (it->state == HalfOpen && !it->probing)) {
+        return 0;
+    }
+    return qMax<qint64>(0, it->openTime - it->since.elapsed());
+}
+
+QString RetryPolicy::hostKey(const QUrl &url)
+{
+    bool secure = url.scheme() == "https";
+    return QString("%1://%2:%3").arg(url.scheme(), url.host()).arg(url.port(secure ? 443 : 80));
+}
+
+qint64 RetryPolicy::parseRetryAfter(const QByteArray &value)
+{
+    // Either delay-seconds or an HTTP date
+    QByteArray trimmed = value.trimmed();
+    if (trimmed.isEmpty()) {
+        return -1;
+    }
+
+    bool ok = false;
+    qint64 seconds = trimmed.toLongLong(&ok);
+    if (ok) {
+        return seconds >= 0 ? seconds * 1000 : -1;
+    }
+
+    QDateTime date = QDateTime::fromString(QString::fromLatin1(trimmed), Qt::RFC2822Date);
+    if (!date.isValid()) {
+        return -1;
+    }
+    return qMax<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(date));
+}
+
+bool RetryPolicy::isHostFailure(const RequestFailure &failure)
+{
+    if (failure.kind == RequestFailure::Throttled) {
+        return true;
+    }
+    if (failure.kind != RequestFailure::Transient) {
+        return false;
+    }
+    // 401, 408 and 425 come from a host that is up and answering
+    return failure.httpStatus == 0 || failure.httpStatus == 500 ||
+           failure.httpStatus == 502 || failure.httpStatus == 504;
+}
+
+void RetryPolicy::open(Circuit &circuit, qint64 openTime)
+{
+    circuit.state = Open;
+    circuit.failures = 0;
+    circuit.openTime = qMax<qint64>(1, openTime);
+    circuit.probing = false;
+    circuit.since.start();
+}
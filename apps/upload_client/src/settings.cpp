@@ -8,6 +8,8 @@
 const QString Settings::DEFAULT_SERVER_URL = "http://localhost:3000";
 const int Settings::DEFAULT_MAX_CONCURRENT_UPLOADS = 3;
 const int Settings::DEFAULT_CHUNK_SIZE = 1024 * 1024; // 1MB
+const qint64 Settings::DEFAULT_STREAM_BUFFER_SIZE = 1024 * 1024; // 1MB
+const qint64 Settings::DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024; // 256MB
 const int Settings::DEFAULT_MAX_RETRIES = 3;
 const int Settings::DEFAULT_SYNC_INTERVAL = 300000; // 5 minutes
 const int Settings::DEFAULT_NETWORK_TIMEOUT = 30000; // 30 seconds
@@ -115,6 +117,28 @@ void Settings::setChunkSize(int size)
     emit settingsChanged("upload", "chunkSize", size);
 }
 
+qint64 Settings::getStreamBufferSize() const
+{
+    return m_settings->value("upload/streamBufferSize", DEFAULT_STREAM_BUFFER_SIZE).toLongLong();
+}
+
+void Settings::setStreamBufferSize(qint64 size)
+{
+    m_settings->setValue("upload/streamBufferSize", size);
+    emit settingsChanged("upload", "streamBufferSize", size);
+}
+
+qint64 Settings::getMemoryBudget() const
+{
+    return m_settings->value("upload/memoryBudget", DEFAULT_MEMORY_BUDGET).toLongLong();
+}
+
+void Settings::setMemoryBudget(qint64 bytes)
+{
+    m_settings->setValue("upload/memoryBudget", bytes);
+    emit settingsChanged("upload", "memoryBudget", bytes);
+}
+
 int Settings::getMaxRetries() const
 {
     return m_settings->value("upload/maxRetries", DEFAULT_MAX_RETRIES).toInt();
@@ -126,6 +150,17 @@ void Settings::setMaxRetries(int retries)
     emit settingsChanged("upload", "maxRetries", retries);
 }
 
+bool Settings::getDedupeEnabled() const
+{
+    return m_settings->value("upload/dedupe", true).toBool();
+}
+
+void Settings::setDedupeEnabled(bool enabled)
+{
+    m_settings->setValue("upload/dedupe", enabled);
+    emit settingsChanged("upload", "dedupe", enabled);
+}
+
 QString Settings::getUploadServerUrl() const
 {
     return m_settings->value("upload/serverUrl", DEFAULT_SERVER_URL).toString();
@@ -221,6 +256,17 @@ void Settings::setNetworkServerUrl(const QString &url)
     emit settingsChanged("network", "serverUrl", url);
 }
 
+qint64 Settings::getBandwidthLimit() const
+{
+    return m_settings->value("network/bandwidthLimit", 0).toLongLong();
+}
+
+void Settings::setBandwidthLimit(qint64 bytesPerSecond)
+{
+    m_settings->setValue("network/bandwidthLimit", bytesPerSecond);
+    emit settingsChanged("network", "bandwidthLimit", bytesPerSecond);
+}
+
 // UI settings
 QSize Settings::getWindowSize() const
 {
@@ -0,0 +1,48 @@
+#include "storagequota.h"
+
+StorageQuota::StorageQuota()
+    : m_remaining(-1)
+    , m_reserved(0)
+{
+}
+
+void StorageQuota::setRemaining(qint64 bytes)
+{
+    m_remaining = qMax<qint64>(0, bytes);
+    m_reserved = 0;
+}
+
+void StorageQuota::clear()
+{
+    m_remaining = -1;
+    m_reserved = 0;
+}
+
+bool StorageQuota::isKnown() const
+{
+    return m_remaining >= 0;
+}
+
+qint64 StorageQuota::remaining() const
+{
+    return isKnown() ? m_remaining - m_reserved : -1;
+}
+
+qint64 StorageQuota::reserved() const
+{
+    return m_reserved;
+}
+
+bool StorageQuota::reserve(qint64 bytes)
+{
+    if (isKnown() && bytes > remaining()) {
+        return false;
+    }
+    m_reserved += bytes;
+    return true;
+}
+
+void StorageQuota::release(qint64 bytes)
+{
+    m_reserved = qMax<qint64>(0, m_reserved - bytes);
+}
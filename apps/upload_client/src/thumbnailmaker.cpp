@@ -0,0 +1,218 @@
+#include "thumbnailmaker.h"
+#include "memorybudget.h"
+#include "networktransport.h"
+#include "retrypolicy.h"
+#include <QBuffer>
+#include <QFileInfo>
+#include <QHttpMultiPart>
+#include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QPainter>
+#include <QSettings>
+#include <QThread>
+#include <algorithm>
+
+const int ThumbnailMaker::MAX_THUMBNAILS = 4;
+
+ThumbnailMaker* ThumbnailMaker::instance()
+{
+    static ThumbnailMaker instance;
+    return &instance;
+}
+
+ThumbnailMaker::ThumbnailMaker(QObject *parent)
+    : QObject(parent)
+    , m_quality(85)
+    , m_enabled(true)
+    , m_supported(true)
+{
+    const QList<QByteArray> formats = QImageReader::supportedImageFormats();
+    for (const QByteArray &format : formats) {
+        m_suffixes.insert(QString::fromLatin1(format).toLower());
+    }
+
+    // Decoding shares the CPU with hashing and compression
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+
+    QSettings settings;
+    m_enabled = settings.value("upload/thumbnails", true).toBool();
+    QList<int> sizes;
+    const QStringList sizeList = settings.value("upload/thumbnailSizes", QStringList{"1024", "320"}).toStringList();
+    for (const QString &size : sizeList) {
+        sizes.append(size.trimmed().toInt());
+    }
+    setSizes(sizes);
+    setQuality(settings.value("upload/thumbnailQuality", 85).toInt());
+
+    connect(MemoryBudget::instance(), &MemoryBudget::memoryAvailable, this, &ThumbnailMaker::dispatch);
+}
+
+ThumbnailMaker::~ThumbnailMaker()
+{
+    m_waiting.clear();
+    m_pool.waitForDone();
+}
+
+bool ThumbnailMaker::isCandidate(const QString &filePath) const
+{
+    return m_enabled && m_supported && !m_sizes.isEmpty() &&
+           m_suffixes.contains(QFileInfo(filePath).suffix().toLower());
+}
+
+void ThumbnailMaker::attach(const QString &filePath, const QUrl &url, const QString &authToken)
+{
+    m_waiting.enqueue(Job{filePath, url, authToken});
+    dispatch();
+}
+
+void ThumbnailMaker::setSizes(const QList<int> &sizes)
+{
+    m_sizes.clear();
+    for (int size : sizes) {
+        if (size >= 16 && size <= 4096 && !m_sizes.contains(size)) {
+            m_sizes.append(size);
+        }
+    }
+    std::sort(m_sizes.begin(), m_sizes.end(), std::greater<int>());
+    while (m_sizes.size() > MAX_THUMBNAILS) {
+        m_sizes.removeLast();
+    }
+}
+
+QList<int> ThumbnailMaker::sizes() const
+{
+    return m_sizes;
+}
+
+void ThumbnailMaker::setQuality(int quality)
+{
+    m_quality = qBound(1, quality, 100);
+}
+
+int ThumbnailMaker::quality() const
+{
+    return m_quality;
+}
+
+QList<QByteArray> ThumbnailMaker::makeThumbnails(const QString &filePath, const QList<int> &sizes, int quality)
+{
+    QList<QByteArray> thumbnails;
+    if (sizes.isEmpty()) {
+        return thumbnails;
+    }
+
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+
+    // The bound is square, so it holds before and after EXIF rotation
+    const int largest = sizes.first();
+    QSize size = reader.size();
+    if (size.isValid() && (size.width() > largest || size.height() > largest)) {
+        reader.setScaledSize(size.scaled(largest, largest, Qt::KeepAspectRatio));
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return thumbnails;
+    }
+
+    // JPEG has no alpha; transparent areas would otherwise turn black
+    if (image.hasAlphaChannel()) {
+        QImage flat(image.size(), QImage::Format_RGB32);
+        flat.fill(Qt::white);
+        QPainter painter(&flat);
+        painter.drawImage(0, 0, image);
+        painter.end();
+        image = flat;
+    }
+
+    for (int edge : sizes) {
+        if (image.width() > edge || image.height() > edge) {
+            image = image.scaled(edge, edge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        } else if (!thumbnails.isEmpty()) {
+            continue; // the image is already this small; the previous one is the same
+        }
+
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "jpeg");
+        writer.setQuality(quality);
+        if (!writer.write(image)) {
+            return QList<QByteArray>();
+        }
+        thumbnails.append(data);
+    }
+    return thumbnails;
+}
+
+qint64 ThumbnailMaker::jobMemory() const
+{
+    // Decoded image plus its scaled copy, 4 bytes a pixel
+    qint64 edge = m_sizes.isEmpty() ? 0 : m_sizes.first();
+    return 2 * 4 * edge * edge;
+}
+
+void ThumbnailMaker::dispatch()
+{
+    while (!m_waiting.isEmpty() && MemoryBudget::instance()->tryAcquire(jobMemory())) {
+        start(m_waiting.dequeue());
+    }
+}
+
+void ThumbnailMaker::start(const Job &job)
+{
+    const qint64 memory = jobMemory();
+    const QList<int> sizes = m_sizes;
+    const int quality = m_quality;
+
+    m_pool.start([this, job, memory, sizes, quality]() {
+        QList<QByteArray> thumbnails = makeThumbnails(job.filePath, sizes, quality);
+        QMetaObject::invokeMethod(this, [this, job, memory, thumbnails]() {
+            MemoryBudget::instance()->release(memory);
+            send(job, thumbnails);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailMaker::send(const Job &job, const QList<QByteArray> &thumbnails)
+{
+    // Not worth waiting for a server that is down; the media just goes without
+    if (thumbnails.isEmpty() || !m_supported || !RetryPolicy::instance()->allowRequest(job.url)) {
+        return;
+    }
+
+    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    for (int i = 0; i < thumbnails.size(); ++i) {
+        QHttpPart part;
+        part.setHeader(QNetworkRequest::ContentTypeHeader, "image/jpeg");
+        part.setHeader(QNetworkRequest::ContentDispositionHeader,
+                       QString("form-data; name=\"thumbnails\"; filename=\"thumb_%1.jpg\"").arg(i));
+        part.setBody(thumbnails.at(i));
+        multiPart->append(part);
+    }
+
+    QNetworkRequest request(job.url);
+    if (!job.authToken.isEmpty()) {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(job.authToken).toUtf8());
+    }
+
+    QNetworkReply *reply = NetworkTransport::instance()->post(request, multiPart);
+    multiPart->setParent(reply);
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        RetryPolicy::instance()->record(reply);
+
+        // 501, or a 404 for the route rather than the media: the server has no endpoint
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        QString message = QJsonDocument::fromJson(reply->readAll()).object().value("message").toString();
+        if (status == 501 || (status == 404 && message != "Media not found")) {
+            m_supported = false;
+        }
+    });
+}
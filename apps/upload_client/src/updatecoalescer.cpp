@@ -0,0 +1,85 @@
+#include "updatecoalescer.h"
+#include <algorithm>
+
+const int UpdateCoalescer::DEFAULT_INTERVAL = 33; // ~30 updates per second
+
+UpdateCoalescer::UpdateCoalescer(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<ItemUpdateBatch>("ItemUpdateBatch");
+
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(DEFAULT_INTERVAL);
+    connect(&m_timer, &QTimer::timeout, this, &UpdateCoalescer::flush);
+}
+
+void UpdateCoalescer::setInterval(int msec)
+{
+    m_timer.setInterval(qMax(0, msec));
+}
+
+int UpdateCoalescer::interval() const
+{
+    return m_timer.interval();
+}
+
+void UpdateCoalescer::setProgress(quint64 key, int progress)
+{
+    pending(key).progress = progress;
+}
+
+void UpdateCoalescer::setStatus(quint64 key, const QString &status)
+{
+    pending(key).status = status;
+}
+
+void UpdateCoalescer::reset()
+{
+    m_timer.stop();
+    m_pending.clear();
+}
+
+void UpdateCoalescer::flush()
+{
+    m_timer.stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    ItemUpdateBatch batch;
+    batch.items = m_pending.values();
+    m_pending.clear();
+    std::sort(batch.items.begin(), batch.items.end(), [](const ItemUpdate &a, const ItemUpdate &b) {
+        return a.key < b.key;
+    });
+
+    // Views repaint whole runs of rows at once, so hand them contiguous ranges
+    quint64 first = batch.items.first().key;
+    quint64 last = first;
+    for (int i = 1; i < batch.items.size(); ++i) {
+        quint64 key = batch.items.at(i).key;
+        if (key != last + 1) {
+            batch.ranges.append(qMakePair(first, last));
+            first = key;
+        }
+        last = key;
+    }
+    batch.ranges.append(qMakePair(first, last));
+
+    emit batchReady(batch);
+}
+
+ItemUpdate& UpdateCoalescer::pending(quint64 key)
+{
+    // The first change after a publish starts the clock for the next one
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+
+    auto it = m_pending.find(key);
+    if (it == m_pending.end()) {
+        it = m_pending.insert(key, ItemUpdate());
+        it->key = key;
+    }
+    return it.value();
+}
@@ -0,0 +1,290 @@
+#include "uploadjournal.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+const int UploadJournal::DEFAULT_FLUSH_INTERVAL = 1000; // 1 second
+const qint64 UploadJournal::COMPACT_MIN_RECORDS = 1024;
+
+UploadJournal::UploadJournal(const QString &journalPath, QObject *parent)
+    : QObject(parent)
+    , m_journalPath(journalPath)
+    , m_nextSequence(0)
+    , m_recordsOnDisk(0)
+{
+    QDir().mkpath(QFileInfo(journalPath).absolutePath());
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(DEFAULT_FLUSH_INTERVAL);
+    connect(&m_flushTimer, &QTimer::timeout, this, &UploadJournal::flush);
+}
+
+UploadJournal::~UploadJournal()
+{
+    flush();
+}
+
+QList<JournalEntry> UploadJournal::replay()
+{
+    m_entries.clear();
+    m_pending.clear();
+    m_pendingState.clear();
+    m_nextSequence = 0;
+
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    QFile file(m_journalPath);
+    if (file.open(QIODevice::ReadOnly)) {
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine().trimmed();
+            if (line.isEmpty()) {
+                continue;
+            }
+
+            QJsonParseError error;
+            QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+            if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+                // Torn write from a crash; everything before it is still valid
+                continue;
+            }
+            apply(doc.object());
+        }
+        file.close();
+    }
+
+    // Start from a clean file so a torn tail cannot merge with new records
+    compact();
+
+    QList<JournalEntry> entries = m_entries.values();
+    std::sort(entries.begin(), entries.end(), [](const JournalEntry &a, const JournalEntry &b) {
+        return a.sequence < b.sequence;
+    });
+    return entries;
+}
+
+void UploadJournal::recordAdded(const QString &filePath, qint64 fileSize, qint64 lastModified)
+{
+    QJsonObject record;
+    record["op"] = "add";
+    record["path"] = filePath;
+    record["size"] = fileSize;
+    record["mtime"] = lastModified;
+    append(record);
+}
+
+void UploadJournal::recordState(const QString &filePath, const QString &status,
+                                const QString &uploadId, qint64 uploadedBytes)
+{
+    QJsonObject record;
+    record["op"] = "state";
+    record["path"] = filePath;
+    record["status"] = status;
+    record["uploadId"] = uploadId;
+    record["offset"] = uploadedBytes;
+    append(record);
+}
+
+void UploadJournal::recordPriority(const QString &filePath, int priority)
+{
+    QJsonObject record;
+    record["op"] = "priority";
+    record["path"] = filePath;
+    record["priority"] = priority;
+    append(record);
+}
+
+void UploadJournal::recordRemoved(const QString &filePath)
+{
+    QJsonObject record;
+    record["op"] = "remove";
+    record["path"] = filePath;
+    append(record);
+}
+
+void UploadJournal::recordCleared()
+{
+    QJsonObject record;
+    record["op"] = "clear";
+    append(record);
+}
+
+void UploadJournal::setFlushInterval(int msec)
+{
+    m_flushTimer.setInterval(qMax(0, msec));
+}
+
+QString UploadJournal::journalPath() const
+{
+    return m_journalPath;
+}
+
+void UploadJournal::flush()
+{
+    m_flushTimer.stop();
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    if (!openForAppend()) {
+        return;
+    }
+
+    QByteArray batch;
+    for (const QJsonObject &record : m_pending) {
+        batch += QJsonDocument(record).toJson(QJsonDocument::Compact);
+        batch += '\n';
+    }
+
+    // One write per batch keeps the upload path free of disk I/O
+    m_file.write(batch);
+    m_file.flush();
+#ifdef Q_OS_UNIX
+    ::fsync(m_file.handle());
+#endif
+
+    m_recordsOnDisk += m_pending.size();
+    m_pending.clear();
+    m_pendingState.clear();
+
+    if (m_recordsOnDisk > qMax<qint64>(COMPACT_MIN_RECORDS, 4 * m_entries.size())) {
+        compact();
+    }
+}
+
+void UploadJournal::compact()
+{
+    m_flushTimer.stop();
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    QList<JournalEntry> entries = m_entries.values();
+    std::sort(entries.begin(), entries.end(), [](const JournalEntry &a, const JournalEntry &b) {
+        return a.sequence < b.sequence;
+    });
+
+    // Pending records are already folded into m_entries
+    QSaveFile file(m_journalPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    for (const JournalEntry &entry : entries) {
+        QJsonObject record;
+        record["op"] = "entry";
+        record["path"] = entry.filePath;
+        record["size"] = entry.fileSize;
+        record["mtime"] = entry.lastModified;
+        record["status"] = entry.status;
+        record["uploadId"] = entry.uploadId;
+        record["offset"] = entry.uploadedBytes;
+        record["priority"] = entry.priority;
+        file.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+        file.write("\n");
+    }
+
+    // Atomic replace: a crash here leaves either the old or the new journal
+    if (file.commit()) {
+        m_pending.clear();
+        m_pendingState.clear();
+        m_recordsOnDisk = entries.size();
+    }
+}
+
+void UploadJournal::append(const QJsonObject &record)
+{
+    apply(record);
+
+    const QString op = record.value("op").toString();
+    const QString path = record.value("path").toString();
+
+    if (op == "state") {
+        int index = m_pendingState.value(path, -1);
+        if (index >= 0) {
+            m_pending[index] = record;
+        } else {
+            m_pendingState.insert(path, m_pending.size());
+            m_pending.append(record);
+        }
+    } else {
+        if (op == "clear") {
+            m_pendingState.clear();
+        } else {
+            m_pendingState.remove(path);
+        }
+        m_pending.append(record);
+    }
+
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void UploadJournal::apply(const QJsonObject &record)
+{
+    const QString op = record.value("op").toString();
+    const QString path = record.value("path").toString();
+
+    if (op == "clear") {
+        m_entries.clear();
+        return;
+    }
+
+    if (op == "remove") {
+        m_entries.remove(path);
+        return;
+    }
+
+    if (op == "add" || op == "entry") {
+        JournalEntry entry;
+        entry.filePath = path;
+        entry.fileSize = record.value("size").toVariant().toLongLong();
+        entry.lastModified = record.value("mtime").toVariant().toLongLong();
+        entry.status = record.value("status").toString("Pending");
+        entry.sequence = m_entries.contains(path) ? m_entries.value(path).sequence : m_nextSequence++;
+        if (op == "entry") {
+            entry.uploadId = record.value("uploadId").toString();
+            entry.uploadedBytes = record.value("offset").toVariant().toLongLong();
+            entry.priority = record.value("priority").toInt();
+        } else if (m_entries.contains(path)) {
+            entry.priority = m_entries.value(path).priority; // re-added after a change on disk
+        }
+        m_entries.insert(path, entry);
+        return;
+    }
+
+    if (op == "state") {
+        auto it = m_entries.find(path);
+        if (it != m_entries.end()) {
+            it->status = record.value("status").toString();
+            it->uploadId = record.value("uploadId").toString();
+            it->uploadedBytes = record.value("offset").toVariant().toLongLong();
+        }
+        return;
+    }
+
+    if (op == "priority") {
+        auto it = m_entries.find(path);
+        if (it != m_entries.end()) {
+            it->priority = record.value("priority").toInt();
+        }
+    }
+}
+
+bool UploadJournal::openForAppend()
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+
+    m_file.setFileName(m_journalPath);
+    return m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
@@ -1,8 +1,12 @@
 #include "uploadmanager.h"
+#include "uploadstream.h"
+#include "uploadjournal.h"
+#include "preprocesspool.h"
+#include "networktransport.h"
+#include "readaheadpool.h"
+#include "thumbnailmaker.h"
 #include <QDir>
 #include <QDirIterator>
-#include <QHttpMultiPart>
-#include <QHttpPart>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -10,40 +14,145 @@
 #include <QApplication>
 #include <QStandardPaths>
 #include <QFileDialog>
+#include <QMimeDatabase>
+#include <QDateTime>
+#include <QLocale>
+#include <QSet>
+#include <QtEndian>
+
+// Must not exceed the server's per-chunk limit
+static const qint64 MIN_CHUNK_SIZE = 64 * 1024;
+static const qint64 MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+
+// Must not exceed the server's batch limits (UploadMediaBatchUseCase)
+static const int MAX_BATCH_FILES = 500;
+static const qint64 MAX_BATCH_FILE_SIZE = 16 * 1024 * 1024;
+static const qint64 MAX_BATCH_BYTES = 256 * 1024 * 1024;
+static const int BATCH_LINGER = 200; // ms an item waits for others to join its batch
+
+// Part URLs signed per request, and how long one must still be valid to be used
+static const int PRESIGN_BATCH = 32;
+static const qint64 PART_URL_MARGIN = 60000;
 
 UploadManager::UploadManager(QObject *parent)
     : QObject(parent)
-    , m_currentReply(nullptr)
-    , m_currentIndex(-1)
     , m_isUploading(false)
     , m_isPaused(false)
+    , m_scheduledRetries(0)
+    , m_queueGeneration(0)
+    , m_journal(nullptr)
+    , m_updates(nullptr)
+    , m_resumeOnAuth(false)
+    , m_encoder(nullptr)
+    , m_batchBufferBytes(0)
+    , m_batchTimer(nullptr)
+    , m_batchDue(false)
+    , m_circuitTimer(nullptr)
+    , m_quotaReply(nullptr)
+    , m_heldFiles(0)
+    , m_heldBytes(0)
+    , m_totalBytes(0)
+    , m_sentBytes(0)
+    , m_completedBytes(0)
+    , m_overallProgress(0)
     , m_maxConcurrentUploads(3)
     , m_chunkSize(1024 * 1024) // 1MB chunks
+    , m_streamBufferSize(1024 * 1024) // 1MB read-ahead per transfer
     , m_maxRetries(3)
-    , m_currentRetries(0)
+    , m_dedupeEnabled(true)
+    , m_compressionEnabled(true)
+    , m_directUploads(true)
+    , m_partConcurrency(4)
+    , m_batchEnabled(true)
+    , m_quotaEnabled(true)
+    , m_batchMinFiles(8)
+    , m_batchMaxFiles(200)
+    , m_batchMaxBytes(32 * 1024 * 1024)
+    , m_batchMaxFileSize(1024 * 1024)
 {
-    m_networkManager = new QNetworkAccessManager(this);
-    m_retryTimer = new QTimer(this);
-    m_retryTimer->setSingleShot(true);
+    m_networkManager = NetworkTransport::instance();
+    m_updates = new UpdateCoalescer(this);
+    connect(m_updates, &UpdateCoalescer::batchReady, this, &UploadManager::itemsChanged);
+    
+    m_encoder = new ChunkEncoder(this);
+    connect(m_encoder, &ChunkEncoder::chunkEncoded, this, &UploadManager::onChunkEncoded);
     
-    connect(m_retryTimer, &QTimer::timeout, this, &UploadManager::processNextUpload);
+    m_batchTimer = new QTimer(this);
+    m_batchTimer->setSingleShot(true);
+    m_batchTimer->setInterval(BATCH_LINGER);
+    connect(m_batchTimer, &QTimer::timeout, this, &UploadManager::onBatchTimeout);
+    
+    m_circuitTimer = new QTimer(this);
+    m_circuitTimer->setSingleShot(true);
+    connect(m_circuitTimer, &QTimer::timeout, this, &UploadManager::processNextUpload);
     
     // Load settings
     QSettings settings;
     m_serverUrl = settings.value("upload/serverUrl", "http://localhost:3000").toString();
-    m_maxConcurrentUploads = settings.value("upload/maxConcurrent", 3).toInt();
-    m_chunkSize = settings.value("upload/chunkSize", 1024 * 1024).toInt();
+    m_maxConcurrentUploads = qMax(1, settings.value("upload/maxConcurrent", 3).toInt());
+    m_chunkSize = qBound(MIN_CHUNK_SIZE, settings.value("upload/chunkSize", 1024 * 1024).toLongLong(), MAX_CHUNK_SIZE);
+    
+    // chunkSize is where sizing starts; it then follows measured throughput and RTT
+    if (settings.value("upload/adaptiveChunkSize", true).toBool()) {
+        qint64 minChunk = qBound(MIN_CHUNK_SIZE, settings.value("upload/minChunkSize", 256 * 1024).toLongLong(), MAX_CHUNK_SIZE);
+        qint64 maxChunk = qBound(MIN_CHUNK_SIZE, settings.value("upload/maxChunkSize", MAX_CHUNK_SIZE).toLongLong(), MAX_CHUNK_SIZE);
+        m_chunkSizer.setBounds(minChunk, maxChunk);
+        m_chunkSizer.setTargetDuration(settings.value("upload/chunkTargetTime", 2000).toInt());
+    } else {
+        m_chunkSizer.setBounds(m_chunkSize, m_chunkSize);
+    }
+    m_chunkSizer.setChunkSize(m_chunkSize);
+    m_streamBufferSize = settings.value("upload/streamBufferSize", 1024 * 1024).toLongLong();
     m_maxRetries = settings.value("upload/maxRetries", 3).toInt();
+    m_dedupeEnabled = settings.value("upload/dedupe", true).toBool();
+    m_compressionEnabled = settings.value("upload/compression", true).toBool();
+    m_encoder->setLevel(settings.value("upload/compressionLevel", 1).toInt());
+    m_encoder->setExtensions(settings.value("upload/compressExtensions",
+        QStringList{".wav", ".aif", ".aiff", ".bmp", ".tif", ".tiff"}).toStringList());
+    m_directUploads = settings.value("upload/directToStorage", true).toBool();
+    m_partConcurrency = qBound(1, settings.value("upload/partConcurrency", 4).toInt(), 16);
+    m_batchEnabled = settings.value("upload/batchEnabled", true).toBool();
+    m_batchMinFiles = qMax(2, settings.value("upload/batchMinFiles", 8).toInt());
+    m_batchMaxFiles = qBound(m_batchMinFiles, settings.value("upload/batchMaxFiles", 200).toInt(), MAX_BATCH_FILES);
+    m_batchMaxBytes = qBound<qint64>(1, settings.value("upload/batchMaxBytes", 32 * 1024 * 1024).toLongLong(), MAX_BATCH_BYTES);
+    m_batchMaxFileSize = qBound<qint64>(0, settings.value("upload/batchMaxFileSize", 1024 * 1024).toLongLong(), MAX_BATCH_FILE_SIZE);
+    m_quotaEnabled = settings.value("upload/quotaCheck", true).toBool();
+    m_updates->setInterval(settings.value("ui/updateInterval", 33).toInt());
+    
+    m_scheduler.setSmallFileThreshold(settings.value("upload/smallFileThreshold", 16 * 1024 * 1024).toLongLong());
+    m_scheduler.setLargeFileDelay(settings.value("upload/largeFileDelay", 120000).toLongLong());
+    m_scheduler.setPriorityStep(settings.value("upload/priorityStep", 600000).toLongLong());
+    
+    connect(PreprocessPool::instance(), &PreprocessPool::fileProcessed, this, &UploadManager::onFileProcessed);
+    
+    // Restore whatever was queued when the app last stopped
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    m_journal = new UploadJournal(dataPath + "/upload-journal.jsonl", this);
+    m_journal->setFlushInterval(settings.value("upload/journalFlushInterval", 1000).toInt());
+    restoreFromJournal();
 }
 
 UploadManager::~UploadManager()
 {
-    clearQueue();
+    // Keep the journal intact so the queue is restored on next start
+    m_isUploading = false;
+    abortActiveUploads();
+    m_journal->flush();
 }
 
 void UploadManager::setAuthToken(const QString &token)
 {
     m_authToken = token;
+    
+    // Have connections ready before the first upload asks for one
+    if (!m_authToken.isEmpty()) {
+        NetworkTransport::instance()->prewarm(QUrl(m_serverUrl));
+    }
+    
+    if (m_resumeOnAuth && !m_authToken.isEmpty()) {
+        m_resumeOnAuth = false;
+        startUpload();
+    }
 }
 
 void UploadManager::setServerUrl(const QString &url)
@@ -55,33 +164,54 @@ void UploadManager::setServerUrl(const QString &url)
     settings.setValue("upload/serverUrl", url);
 }
 
-void UploadManager::addFile(const QString &filePath)
+void UploadManager::addFile(const QString &filePath, int priority)
 {
-    QMutexLocker locker(&m_queueMutex);
-    
-    QFileInfo fileInfo(filePath);
-    if (!fileInfo.exists() || !fileInfo.isFile()) {
-        emit uploadError(QString("File does not exist: %1").arg(filePath));
-        return;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        
+        QFileInfo fileInfo(filePath);
+        if (!fileInfo.exists() || !fileInfo.isFile()) {
+            emit uploadError(QString("File does not exist: %1").arg(filePath));
+            return;
+        }
+        
+        UploadItem item(filePath);
+        item.priority = priority;
+        enqueueItem(item);
+        
+        m_updates->setStatus(m_uploadQueue.size() - 1, "Added to queue");
     }
     
-    UploadItem item(filePath);
-    m_uploadQueue.enqueue(item);
-    
-    emit itemStatusChanged(m_uploadQueue.size() - 1, "Added to queue");
+    // Files added mid-batch join the running pool
+    if (m_isUploading && !m_quotaReply) {
+        enqueuePending(m_uploadQueue.size() - 1);
+        reportHeldBack();
+        processNextUpload();
+    }
 }
 
 void UploadManager::addFolder(const QString &folderPath)
 {
-    QMutexLocker locker(&m_queueMutex);
-    
-    QDir dir(folderPath);
-    if (!dir.exists()) {
-        emit uploadError(QString("Folder does not exist: %1").arg(folderPath));
-        return;
+    int firstNewIndex = m_uploadQueue.size();
+    {
+        QMutexLocker locker(&m_queueMutex);
+        
+        QDir dir(folderPath);
+        if (!dir.exists()) {
+            emit uploadError(QString("Folder does not exist: %1").arg(folderPath));
+            return;
+        }
+        
+        scanFolder(folderPath);
     }
     
-    scanFolder(folderPath);
+    if (m_isUploading && !m_quotaReply) {
+        for (int i = firstNewIndex; i < m_uploadQueue.size(); ++i) {
+            enqueuePending(i);
+        }
+        reportHeldBack();
+        processNextUpload();
+    }
 }
 
 void UploadManager::startUpload()
@@ -92,18 +222,120 @@ void UploadManager::startUpload()
     
     m_isUploading = true;
     m_isPaused = false;
-    m_currentIndex = 0;
-    m_currentRetries = 0;
+    m_scheduler.clear();
+    emit uploadProgress(m_overallProgress);
     
-    emit uploadProgress(0);
+    // Nothing is in flight between runs, so the server's figure covers every
+    // upload so far; the queue is planned against it before a byte is sent
+    for (UploadItem &item : m_uploadQueue) {
+        item.reservedBytes = 0;
+    }
+    if (m_quotaEnabled && !m_authToken.isEmpty()) {
+        fetchQuota();
+    } else {
+        m_quota.clear();
+        queuePending();
+    }
+}
+
+void UploadManager::queuePending()
+{
+    for (int i = 0; i < m_uploadQueue.size(); ++i) {
+        const QString &status = m_uploadQueue[i].status;
+        if (status != "Completed" && status != "Failed") {
+            m_uploadQueue[i].retries = 0;
+            enqueuePending(i);
+        }
+    }
+    
+    reportHeldBack();
     processNextUpload();
 }
 
+void UploadManager::fetchQuota()
+{
+    m_quotaReply = m_networkManager->get(createApiRequest("/api/v1/storage/stats"));
+    QNetworkReply *reply = m_quotaReply;
+    quint64 generation = m_queueGeneration;
+    
+    connect(reply, &QNetworkReply::finished, this, [this, reply, generation]() {
+        reply->deleteLater();
+        RetryPolicy::instance()->record(reply);
+        if (m_quotaReply == reply) {
+            m_quotaReply = nullptr;
+        }
+        if (generation != m_queueGeneration || !m_isUploading) {
+            return; // cleared meanwhile
+        }
+        
+        // Without a figure (an older server, or the request failed) the server alone decides
+        QJsonObject stats = QJsonDocument::fromJson(reply->readAll()).object().value("data").toObject();
+        if (reply->error() == QNetworkReply::NoError && stats.contains("remainingSpace")) {
+            m_quota.setRemaining(stats.value("remainingSpace").toVariant().toLongLong());
+        } else {
+            m_quota.clear();
+        }
+        queuePending();
+    });
+}
+
+bool UploadManager::reserveQuota(int index)
+{
+    UploadItem &item = m_uploadQueue[index];
+    if (item.reservedBytes > 0 || item.fileSize <= 0) {
+        return true; // held since it was planned, e.g. coming back for a retry
+    }
+    
+    if (!m_quota.reserve(item.fileSize)) {
+        // Kept in the queue; the next run checks it against a fresh figure
+        updateItemStatus(index, "Not enough storage");
+        m_heldFiles++;
+        m_heldBytes += item.fileSize;
+        return false;
+    }
+    item.reservedBytes = item.fileSize;
+    return true;
+}
+
+void UploadManager::reportHeldBack()
+{
+    if (m_heldFiles == 0) {
+        return;
+    }
+    
+    QLocale locale;
+    emit uploadError(QString("%1 file(s) held back: they need %2, but only %3 of storage is left")
+                     .arg(m_heldFiles)
+                     .arg(locale.formattedDataSize(m_heldBytes))
+                     .arg(locale.formattedDataSize(qMax<qint64>(0, m_quota.remaining()))));
+    m_heldFiles = 0;
+    m_heldBytes = 0;
+}
+
 void UploadManager::pauseUpload()
 {
+    if (!m_isUploading || m_isPaused) {
+        return;
+    }
+    
     m_isPaused = true;
-    if (m_currentReply) {
-        m_currentReply->abort();
+    
+    // Files still waiting for a batch go back unsent
+    const QList<int> buffered = m_batchBuffer;
+    returnBatchItems(buffered, true);
+    
+    // Aborted transfers are put back at the front of the pending queue by onUploadFinished
+    QList<QNetworkReply*> replies = m_activeUploads.keys();
+    replies += m_activeBatches.keys();
+    replies += m_activeParts.keys();
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+    }
+    
+    // Items whose parts were all waiting on a retry have no reply to abort
+    const QList<int> partItems = m_partUploads.keys();
+    for (int index : partItems) {
+        settleParts(index);
     }
 }
 
@@ -117,31 +349,52 @@ void UploadManager::resumeUpload()
 
 void UploadManager::clearQueue()
 {
+    // Stop the pool first so aborted replies are not re-queued
+    m_isUploading = false;
+    m_isPaused = false;
+    abortActiveUploads();
+    
     QMutexLocker locker(&m_queueMutex);
     
-    // Stop current upload
-    if (m_currentReply) {
-        m_currentReply->abort();
-        m_currentReply = nullptr;
+    for (int i = 0; i < m_uploadQueue.size(); ++i) {
+        releasePreprocessed(i);
     }
     
     // Clear queue
-    while (!m_uploadQueue.isEmpty()) {
-        UploadItem item = m_uploadQueue.dequeue();
-        if (item.file) {
-            item.file->close();
-            delete item.file;
-        }
-    }
-    
-    m_isUploading = false;
-    m_isPaused = false;
-    m_currentIndex = -1;
-    m_currentRetries = 0;
+    m_updates->reset();
+    m_uploadQueue.clear();
+    m_scheduler.clear();
+    m_hashingItems.clear();
+    m_encodingItems.clear();
+    m_chunkSizers.clear();
+    m_batchBuffer.clear();
+    m_batchBufferBytes = 0;
+    m_batchTimer->stop();
+    m_batchDue = false;
+    m_circuitTimer->stop();
+    m_totalBytes = 0;
+    m_sentBytes = 0;
+    m_completedBytes = 0;
+    m_overallProgress = 0;
+    m_scheduledRetries = 0;
+    m_resumeOnAuth = false;
+    m_journal->recordCleared();
     
     emit uploadProgress(0);
 }
 
+void UploadManager::setItemPriority(int index, int priority)
+{
+    if (index < 0 || index >= m_uploadQueue.size()) {
+        return;
+    }
+    
+    UploadItem &item = m_uploadQueue[index];
+    item.priority = priority;
+    m_scheduler.setPriority(index, item.fileSize, priority);
+    m_journal->recordPriority(item.filePath, priority);
+}
+
 QList<UploadItem> UploadManager::getQueue() const
 {
     QMutexLocker locker(const_cast<QMutex*>(&m_queueMutex));
@@ -153,211 +406,1420 @@ bool UploadManager::isUploading() const
     return m_isUploading;
 }
 
+qint64 UploadManager::totalBytes() const
+{
+    return m_totalBytes;
+}
+
+qint64 UploadManager::transferredBytes() const
+{
+    return m_completedBytes + m_sentBytes;
+}
+
+ChunkStats UploadManager::chunkStats() const
+{
+    return m_chunkSizer.stats();
+}
+
 void UploadManager::processNextUpload()
 {
     if (m_isPaused || !m_isUploading) {
         return;
     }
     
-    QMutexLocker locker(&m_queueMutex);
+    // Fill every free slot in the pool. Batched items take no slot until
+    // their batch is sent, so small files are gathered while slots are free.
+    // Nothing new goes out while the server's circuit is open.
+    while (activeSlots() < m_maxConcurrentUploads) {
+        if ((batchReady() || !m_scheduler.isEmpty()) &&
+            !RetryPolicy::instance()->allowRequest(QUrl(m_serverUrl))) {
+            qint64 wait = RetryPolicy::instance()->blockedFor(QUrl(m_serverUrl));
+            if (!m_circuitTimer->isActive()) {
+                m_circuitTimer->start(static_cast<int>(qBound<qint64>(100, wait, 60000)));
+            }
+            break;
+        }
+        if (batchReady()) {
+            flushBatch();
+        } else if (!m_scheduler.isEmpty()) {
+            startItemUpload(m_scheduler.takeNext());
+        } else {
+            break;
+        }
+    }
+    
+    prefetchNext();
+    finishIfIdle();
+}
+
+void UploadManager::onUploadProgress(qint64 bytesSent, qint64 bytesTotal)
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    auto batch = m_activeBatches.find(reply);
+    if (batch != m_activeBatches.end()) {
+        // Files go out in body order: finish the ones passed, then the current one
+        while (batch->sentCursor < batch->indices.size()) {
+            int cursor = batch->sentCursor;
+            qint64 fileSent = bytesSent - batch->offsets.at(cursor);
+            setItemSentBytes(batch->indices.at(cursor), fileSent);
+            if (fileSent < batch->sizes.at(cursor)) {
+                break;
+            }
+            batch->sentCursor++;
+        }
+        return;
+    }
     
-    if (m_uploadQueue.isEmpty()) {
-        m_isUploading = false;
-        m_currentIndex = -1;
-        emit uploadFinished();
+    auto part = m_activeParts.constFind(reply);
+    if (part != m_activeParts.constEnd()) {
+        auto state = m_partUploads.find(part->index);
+        if (state != m_partUploads.end() && state->inFlight.contains(part->partNumber)) {
+            state->inFlight[part->partNumber] = bytesSent;
+            qint64 sent = state->doneBytes;
+            for (auto it = state->inFlight.constBegin(); it != state->inFlight.constEnd(); ++it) {
+                sent += it.value();
+            }
+            setItemSentBytes(part->index, sent);
+        }
         return;
     }
     
-    if (m_currentIndex >= m_uploadQueue.size()) {
-        m_isUploading = false;
-        m_currentIndex = -1;
-        emit uploadFinished();
+    int index = m_activeUploads.value(reply, -1);
+    if (index < 0 || index >= m_uploadQueue.size() || bytesTotal <= 0) {
         return;
     }
     
-    UploadItem &item = m_uploadQueue[m_currentIndex];
+    const UploadItem &item = m_uploadQueue[index];
+    if (bytesSent == bytesTotal) {
+        auto timing = m_chunkTimings.find(reply);
+        if (timing != m_chunkTimings.end() && timing->sentMsec < 0) {
+            timing->sentMsec = timing->timer.elapsed();
+        }
+    }
     
-    // Check if file still exists
-    if (!QFile::exists(item.filePath)) {
-        updateItemStatus(m_currentIndex, "File not found");
-        m_currentIndex++;
-        processNextUpload();
+    if (item.phase == UploadPhase::Multipart) {
+        // Scale out the multipart framing so only file bytes are counted
+        setItemSentBytes(index, item.fileSize * bytesSent / bytesTotal);
+    } else if (item.phase == UploadPhase::SendChunk) {
+        // Compressed chunks carry fewer bytes than they cover in the file
+        qint64 chunkBytes = m_chunkTimings.value(reply).bytes;
+        setItemSentBytes(index, item.uploadedBytes + chunkBytes * bytesSent / bytesTotal);
+    }
+}
+
+void UploadManager::onUploadFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (m_activeBatches.contains(reply)) {
+        onBatchFinished(reply);
+        return;
+    }
+    if (m_activeParts.contains(reply)) {
+        onPartFinished(reply);
+        return;
+    }
+    if (!reply || !m_activeUploads.contains(reply)) {
         return;
     }
     
-    // Open file
-    if (!item.file) {
-        item.file = new QFile(item.filePath);
-        if (!item.file->open(QIODevice::ReadOnly)) {
-            updateItemStatus(m_currentIndex, "Cannot open file");
-            m_currentIndex++;
-            processNextUpload();
+    int index = m_activeUploads.take(reply);
+    reply->deleteLater();
+    
+    if (index < 0 || index >= m_uploadQueue.size()) {
+        return;
+    }
+    
+    UploadItem &item = m_uploadQueue[index];
+    QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+    int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    
+    // Aborts from pause say nothing about the link
+    RequestFailure failure;
+    if (!(m_isPaused && reply->error() == QNetworkReply::OperationCanceledError)) {
+        recordChunkResult(reply, item, reply->error() == QNetworkReply::NoError);
+        failure = RetryPolicy::instance()->record(reply);
+    }
+    m_chunkTimings.remove(reply);
+    
+    if (reply->error() == QNetworkReply::NoError && advanceUpload(item, response)) {
+        journalItemState(index);
+        if (item.phase == UploadPhase::Multipart && isBatchable(item)) {
+            // Not on the server yet; join a batch and give up the slot
+            addToBatch(index);
+            QTimer::singleShot(0, this, &UploadManager::processNextUpload);
+            return;
+        }
+        
+        if (item.phase == UploadPhase::SendChunk && shouldCompress(item)) {
+            // Keeps the slot while a worker compresses the chunk
+            startChunkEncode(index);
+            return;
+        }
+        
+        if (item.phase == UploadPhase::SendParts) {
+            // The slot passes to the parallel part transfers
+            startParts(index);
+            return;
+        }
+        
+        // Next step of the same upload keeps the slot
+        QNetworkReply *next = createPhaseRequest(item);
+        if (next) {
+            m_activeUploads.insert(next, index);
             return;
         }
+        updateItemStatus(index, "Cannot open file");
+        releasePreprocessed(index);
+    } else if (reply->error() == QNetworkReply::NoError) {
+        completeItem(index, response.value("media").toObject());
+    } else if (m_isPaused && reply->error() == QNetworkReply::OperationCanceledError) {
+        // Paused: resume this item first once the pool restarts. A chunked
+        // upload keeps its session and continues from the acknowledged offset.
+        updateItemStatus(index, "Paused");
+        setItemSentBytes(index, item.uploadId.isEmpty() ? 0 : item.uploadedBytes);
+        m_scheduler.enqueueFront(index);
+    } else if (item.phase == UploadPhase::DedupeCheck) {
+        // A failed lookup only costs the saving; upload the file normally
+        item.dedupeChecked = true;
+        m_scheduler.enqueueFront(index);
+    } else if (item.phase == UploadPhase::CreateSession && httpStatus == 501 && m_directUploads) {
+        // Server has no object storage to send to; stage through it instead
+        m_directUploads = false;
+        m_scheduler.enqueueFront(index);
+    } else if (item.phase == UploadPhase::SendChunk && item.compressChunks &&
+               (httpStatus == 400 || httpStatus == 415)) {
+        // Server cannot decode the chunk; send the rest of this file as is,
+        // and nothing compressed at all if it does not know the coding
+        if (httpStatus == 415) {
+            m_compressionEnabled = false;
+        }
+        item.compressChunks = false;
+        m_scheduler.enqueueFront(index);
+    } else if (httpStatus == 409 && item.phase == UploadPhase::SendChunk &&
+               response.contains("receivedBytes")) {
+        // Server holds a different offset than we assumed; continue from its view
+        item.uploadedBytes = response.value("receivedBytes").toVariant().toLongLong();
+        journalItemState(index);
+        setItemSentBytes(index, item.uploadedBytes);
+        m_scheduler.enqueueFront(index);
+    } else {
+        retryItem(index, failure);
     }
     
-    updateItemStatus(m_currentIndex, "Uploading...");
-    createMultipartRequest(item);
+    // Process next upload
+    QTimer::singleShot(0, this, &UploadManager::processNextUpload);
 }
 
-void UploadManager::onUploadProgress(qint64 bytesSent, qint64 bytesTotal)
+void UploadManager::retryItem(int index, const RequestFailure &failure)
 {
-    if (m_currentIndex >= 0 && m_currentIndex < m_uploadQueue.size()) {
-        int progress = static_cast<int>((bytesSent * 100) / bytesTotal);
-        updateItemProgress(m_currentIndex, progress);
+    UploadItem &item = m_uploadQueue[index];
+    
+    // Session expired or was removed; a fresh one may well succeed
+    bool sessionLost = failure.httpStatus == 404 && !item.uploadId.isEmpty();
+    if ((failure.isRetryable() || sessionLost) && item.retries < m_maxRetries) {
+        // Upload failed, retry this item after a delay without blocking the other slots
+        item.retries++;
+        if (sessionLost) {
+            clearSession(item);
+        }
+        setItemSentBytes(index, item.uploadedBytes);
+        updateItemStatus(index, QString("Retrying... (%1/%2)").arg(item.retries).arg(m_maxRetries));
         
-        // Calculate overall progress
-        int totalProgress = 0;
-        for (int i = 0; i < m_uploadQueue.size(); ++i) {
-            if (i < m_currentIndex) {
-                totalProgress += 100;
-            } else if (i == m_currentIndex) {
-                totalProgress += progress;
+        m_scheduledRetries++;
+        quint64 generation = m_queueGeneration;
+        qint64 delay = RetryPolicy::instance()->retryDelay(failure, item.retries, QUrl(m_serverUrl));
+        QTimer::singleShot(static_cast<int>(delay), this, [this, index, generation]() {
+            if (generation != m_queueGeneration) {
+                return;
             }
-        }
-        totalProgress /= m_uploadQueue.size();
-        emit uploadProgress(totalProgress);
+            m_scheduledRetries--;
+            enqueuePending(index);
+            processNextUpload();
+        });
+    } else {
+        updateItemStatus(index, "Failed");
+        m_chunkSizers.remove(item.filePath);
+        releasePreprocessed(index);
     }
 }
 
-void UploadManager::onUploadFinished()
+void UploadManager::onNetworkError(QNetworkReply::NetworkError error)
+{
+    Q_UNUSED(error);
+    
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (reply && !m_isPaused && (m_activeUploads.contains(reply) || m_activeBatches.contains(reply) ||
+                                 m_activeParts.contains(reply))) {
+        emit uploadError(QString("Network error: %1").arg(reply->errorString()));
+    }
+}
+
+void UploadManager::onFileProcessed(const PreprocessResult &result)
 {
-    if (!m_currentReply) {
+    // Prefetched results are picked up when the item reaches a slot
+    const QList<int> indices = m_hashingItems.values(result.filePath);
+    if (indices.isEmpty()) {
         return;
     }
+    m_hashingItems.remove(result.filePath);
     
-    if (m_currentReply->error() == QNetworkReply::NoError) {
-        // Upload successful
-        if (m_currentIndex >= 0 && m_currentIndex < m_uploadQueue.size()) {
-            updateItemStatus(m_currentIndex, "Completed");
-            updateItemProgress(m_currentIndex, 100);
-            
-            // Close and cleanup file
-            UploadItem &item = m_uploadQueue[m_currentIndex];
-            if (item.file) {
-                item.file->close();
-                delete item.file;
-                item.file = nullptr;
-            }
+    for (int index : indices) {
+        if (index < 0 || index >= m_uploadQueue.size()) {
+            continue;
         }
         
-        m_currentRetries = 0;
-        m_currentIndex++;
+        UploadItem &item = m_uploadQueue[index];
+        item.contentHash = result.contentHash;
+        item.mediaInfo = result.mediaInfo;
+        item.mediaProbed = true;
+        if (item.contentHash.isEmpty()) {
+            item.dedupeChecked = true; // unreadable now; the upload itself reports the error
+        }
         
-        // Process next upload
-        QTimer::singleShot(100, this, &UploadManager::processNextUpload);
-    } else {
-        // Upload failed
-        if (m_currentRetries < m_maxRetries) {
-            m_currentRetries++;
-            updateItemStatus(m_currentIndex, QString("Retrying... (%1/%2)").arg(m_currentRetries).arg(m_maxRetries));
-            
-            // Retry after delay
-            m_retryTimer->start(2000 * m_currentRetries); // Exponential backoff
-        } else {
-            updateItemStatus(m_currentIndex, "Failed");
-            m_currentRetries = 0;
-            m_currentIndex++;
-            
-            // Process next upload
-            QTimer::singleShot(100, this, &UploadManager::processNextUpload);
+        if (m_isPaused) {
+            updateItemStatus(index, "Paused");
+            m_scheduler.enqueueFront(index);
+        } else if (m_isUploading) {
+            m_scheduler.enqueueFront(index);
         }
     }
     
-    m_currentReply->deleteLater();
-    m_currentReply = nullptr;
+    processNextUpload();
 }
 
-void UploadManager::onNetworkError(QNetworkReply::NetworkError error)
+void UploadManager::onChunkEncoded(const EncodedChunk &chunk)
 {
-    if (m_currentReply) {
-        emit uploadError(QString("Network error: %1").arg(m_currentReply->errorString()));
+    int index = m_encodingItems.value(chunk.filePath, -1);
+    if (index < 0 || index >= m_uploadQueue.size()) {
+        return;
+    }
+    m_encodingItems.remove(chunk.filePath);
+    
+    UploadItem &item = m_uploadQueue[index];
+    if (!item.compressionProbed) {
+        item.compressionProbed = true;
+        item.compressChunks = chunk.compressible;
     }
+    
+    if (m_isPaused) {
+        updateItemStatus(index, "Paused");
+        setItemSentBytes(index, item.uploadedBytes);
+        m_scheduler.enqueueFront(index);
+        processNextUpload();
+        return;
+    }
+    if (!m_isUploading) {
+        return;
+    }
+    
+    // Not worth sending compressed, or the offset moved on; either way the
+    // request is built from the file as usual
+    bool usable = !chunk.readFailed && !chunk.data.isEmpty() && chunk.offset == item.uploadedBytes;
+    QNetworkReply *reply = createChunkRequest(item, usable ? &chunk : nullptr);
+    if (!reply) {
+        updateItemStatus(index, "Cannot open file");
+        releasePreprocessed(index);
+        processNextUpload();
+        return;
+    }
+    m_activeUploads.insert(reply, index);
 }
 
-void UploadManager::scanFolder(const QString &folderPath)
+void UploadManager::onBatchTimeout()
 {
-    QDirIterator it(folderPath, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-    
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QFileInfo fileInfo(filePath);
+    m_batchDue = true;
+    processNextUpload();
+}
+
+void UploadManager::enqueuePending(int index)
+{
+    if (index >= 0 && index < m_uploadQueue.size() && reserveQuota(index)) {
+        const UploadItem &item = m_uploadQueue[index];
+        m_scheduler.enqueue(index, item.fileSize, item.priority);
         
-        // Only add media files
-        QStringList mediaExtensions = {".mp4", ".avi", ".mov", ".mkv", ".mp3", ".wav", ".flac", ".jpg", ".jpeg", ".png", ".gif", ".bmp"};
-        if (mediaExtensions.contains(fileInfo.suffix().toLower())) {
-            UploadItem item(filePath);
-            m_uploadQueue.enqueue(item);
+        // Start hashing ahead of the upload slots; the pool bounds how far ahead
+        if (needsHash(item)) {
+            PreprocessPool::instance()->submit(item.filePath, false, item.fileSize);
         }
     }
 }
 
-void UploadManager::createMultipartRequest(const UploadItem &item)
+void UploadManager::prefetchNext()
 {
-    if (!item.file || !item.file->isOpen()) {
+    int index = m_scheduler.peekNext();
+    if (index < 0 || index >= m_uploadQueue.size()) {
         return;
     }
     
-    // Create multipart request
-    QHttpMultiPart *multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+    // Every slot is busy: read the start of the file that gets the next one,
+    // from where its stream will begin. A file still to be hashed is read by
+    // the hasher first, which warms the disk cache anyway.
+    const UploadItem &item = m_uploadQueue[index];
+    if (needsHash(item) || item.uploadedBytes >= item.fileSize) {
+        return;
+    }
+    ReadAheadPool::instance()->prefetch(item.filePath, item.uploadedBytes,
+                                        qMin(m_streamBufferSize, item.fileSize - item.uploadedBytes));
+}
+
+bool UploadManager::needsHash(const UploadItem &item) const
+{
+    return m_dedupeEnabled && !item.dedupeChecked && item.uploadId.isEmpty() &&
+           item.contentHash.isEmpty();
+}
+
+void UploadManager::releasePreprocessed(int index)
+{
+    if (index >= 0 && index < m_uploadQueue.size()) {
+        // Whatever the outcome, the item stops holding quota; a completed one has handed it on
+        m_quota.release(m_uploadQueue[index].reservedBytes);
+        m_uploadQueue[index].reservedBytes = 0;
+        PreprocessPool::instance()->release(m_uploadQueue[index].filePath);
+        ReadAheadPool::instance()->drop(m_uploadQueue[index].filePath);
+    }
+}
+
+bool UploadManager::startItemUpload(int index)
+{
+    if (index < 0 || index >= m_uploadQueue.size()) {
+        return false;
+    }
     
-    // Add file part
-    QHttpPart filePart;
-    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("application/octet-stream"));
-    filePart.setHeader(QNetworkRequest::ContentDispositionHeader, 
-                      QVariant(QString("form-data; name=\"file\"; filename=\"%1\"").arg(item.fileName)));
+    UploadItem &item = m_uploadQueue[index];
     
-    // Read file data
-    QByteArray fileData = item.file->readAll();
-    filePart.setBody(fileData);
-    multiPart->append(filePart);
+    // Check if file still exists
+    if (!QFile::exists(item.filePath)) {
+        updateItemStatus(index, "File not found");
+        releasePreprocessed(index);
+        return false;
+    }
     
-    // Add metadata
-    QHttpPart metadataPart;
-    metadataPart.setHeader(QNetworkRequest::ContentDispositionHeader, QVariant("form-data; name=\"metadata\""));
+    // Hashing reads the media headers too; every other path reads them here, a few KB
+    if (!item.mediaProbed && !needsHash(item)) {
+        item.mediaInfo = MediaProbe::probe(item.filePath);
+        item.mediaProbed = true;
+    }
     
-    QJsonObject metadata;
-    metadata["fileName"] = item.fileName;
-    metadata["fileSize"] = static_cast<qint64>(item.fileSize);
-    metadata["originalPath"] = item.filePath;
+    // Hash first so the server can tell us it already has this content
+    if (m_dedupeEnabled && !item.dedupeChecked && item.uploadId.isEmpty()) {
+        if (item.contentHash.isEmpty()) {
+            item.phase = UploadPhase::Hashing;
+            m_hashingItems.insert(item.filePath, index);
+            updateItemStatus(index, "Hashing...");
+            PreprocessPool::instance()->submit(item.filePath, true, item.fileSize);
+            return true;
+        }
+        item.phase = UploadPhase::DedupeCheck;
+    } else if (isBatchable(item)) {
+        addToBatch(index);
+        return true;
+    } else if (!isChunked(item)) {
+        item.phase = UploadPhase::Multipart;
+    } else if (item.uploadId.isEmpty()) {
+        item.phase = UploadPhase::CreateSession;
+    } else {
+        // An existing session is resumed from whatever offset the server acknowledged
+        item.phase = UploadPhase::QueryOffset;
+    }
     
-    QJsonDocument metadataDoc(metadata);
-    metadataPart.setBody(metadataDoc.toJson());
-    multiPart->append(metadataPart);
+    QNetworkReply *reply = createPhaseRequest(item);
+    if (!reply) {
+        updateItemStatus(index, "Cannot open file");
+        releasePreprocessed(index);
+        return false;
+    }
     
-    // Create request
-    QUrl uploadUrl(m_serverUrl);
-    uploadUrl.setPath("/api/v1/media/upload");
+    m_activeUploads.insert(reply, index);
+    updateItemStatus(index, "Uploading...");
+    return true;
+}
+
+void UploadManager::completeItem(int index, const QJsonObject &media)
+{
+    UploadItem &item = m_uploadQueue[index];
+    item.retries = 0;
+    clearSession(item);
+    updateItemStatus(index, "Completed");
     
-    QNetworkRequest request(uploadUrl);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "multipart/form-data");
+    // The server now counts the file against the quota, so its reservation
+    // stays taken; a duplicate sent nothing and gives its space back
+    if (item.phase != UploadPhase::DedupeCheck) {
+        item.reservedBytes = 0;
+    }
+    markItemCompleted(index);
+    m_journal->recordRemoved(item.filePath);
+    m_chunkSizers.remove(item.filePath);
+    releasePreprocessed(index);
     
-    if (!m_authToken.isEmpty()) {
-        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_authToken).toUtf8());
+    // Images get thumbnails made here, so the server never decodes them
+    QString mediaId = media.value("id").toString();
+    if (!mediaId.isEmpty() && media.value("thumbnails").toArray().isEmpty() &&
+        ThumbnailMaker::instance()->isCandidate(item.filePath)) {
+        QUrl thumbnailsUrl(m_serverUrl);
+        thumbnailsUrl.setPath(QString("/api/v1/media/%1/thumbnails").arg(mediaId));
+        ThumbnailMaker::instance()->attach(item.filePath, thumbnailsUrl, m_authToken);
+    }
+}
+
+int UploadManager::activeSlots() const
+{
+    return m_activeUploads.size() + m_hashingItems.size() + m_encodingItems.size() +
+           m_activeBatches.size() + m_partUploads.size();
+}
+
+bool UploadManager::isBatchable(const UploadItem &item) const
+{
+    if (!m_batchEnabled || !item.batchable || item.fileSize > m_batchMaxFileSize ||
+        isChunked(item) || !item.uploadId.isEmpty()) {
+        return false;
     }
     
-    // Send request
-    m_currentReply = m_networkManager->post(request, multiPart);
-    multiPart->setParent(m_currentReply); // Set parent for cleanup
+    // The server rejects a whole batch over one entry it does not accept
+    QString mimeType = QMimeDatabase().mimeTypeForFile(item.filePath, QMimeDatabase::MatchExtension).name();
+    return mimeType.startsWith("image/") || mimeType.startsWith("video/") || mimeType.startsWith("audio/");
+}
+
+void UploadManager::addToBatch(int index)
+{
+    UploadItem &item = m_uploadQueue[index];
+    item.phase = UploadPhase::Batched;
+    m_batchBuffer.append(index);
+    m_batchBufferBytes += item.fileSize;
+    updateItemStatus(index, "Uploading...");
     
-    connect(m_currentReply, &QNetworkReply::uploadProgress, this, &UploadManager::onUploadProgress);
-    connect(m_currentReply, &QNetworkReply::finished, this, &UploadManager::onUploadFinished);
-    connect(m_currentReply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
-            this, &UploadManager::onNetworkError);
+    if (!m_batchTimer->isActive() && !m_batchDue) {
+        m_batchTimer->start();
+    }
 }
 
-void UploadManager::updateItemProgress(int index, int progress)
+bool UploadManager::batchReady() const
 {
-    if (index >= 0 && index < m_uploadQueue.size()) {
-        m_uploadQueue[index].progress = progress;
-        emit itemProgressChanged(index, progress);
+    if (m_batchBuffer.isEmpty()) {
+        return false;
     }
+    
+    // Send once full, once the oldest file has waited long enough for a
+    // worthwhile batch, or once nothing else could still join
+    bool full = m_batchBuffer.size() >= m_batchMaxFiles || m_batchBufferBytes >= m_batchMaxBytes;
+    bool drained = m_scheduler.isEmpty() && m_hashingItems.isEmpty() && m_activeUploads.isEmpty();
+    return full || drained || (m_batchDue && m_batchBuffer.size() >= m_batchMinFiles);
 }
 
-void UploadManager::updateItemStatus(int index, const QString &status)
+void UploadManager::flushBatch()
 {
-    if (index >= 0 && index < m_uploadQueue.size()) {
-        m_uploadQueue[index].status = status;
-        emit itemStatusChanged(index, status);
+    // Take the oldest files that fit within the count and size limits
+    QList<int> indices;
+    qint64 bytes = 0;
+    while (!m_batchBuffer.isEmpty() && indices.size() < m_batchMaxFiles) {
+        qint64 size = m_uploadQueue[m_batchBuffer.first()].fileSize;
+        if (!indices.isEmpty() && bytes + size > m_batchMaxBytes) {
+            break;
+        }
+        bytes += size;
+        indices.append(m_batchBuffer.takeFirst());
+    }
+    m_batchBufferBytes -= bytes;
+    
+    m_batchTimer->stop();
+    m_batchDue = false;
+    if (!m_batchBuffer.isEmpty()) {
+        m_batchTimer->start();
+    }
+    
+    // Too few files to be worth a batch; send them one by one
+    if (indices.size() < m_batchMinFiles) {
+        returnBatchItems(indices, false);
+        return;
+    }
+    
+    // Body: [uint32 big-endian manifest length][manifest JSON][file 1]...[file N]
+    UploadBatch batch;
+    QJsonArray files;
+    QMimeDatabase mimeDatabase;
+    qint64 offset = 0;
+    for (int index : indices) {
+        const UploadItem &item = m_uploadQueue[index];
+        QFileInfo info(item.filePath);
+        if (!info.exists() || !info.isFile()) {
+            updateItemStatus(index, "File not found");
+            releasePreprocessed(index);
+            continue;
+        }
+        
+        QJsonObject file;
+        file["name"] = item.fileName;
+        file["size"] = info.size();
+        file["mimeType"] = mimeDatabase.mimeTypeForFile(item.filePath, QMimeDatabase::MatchExtension).name();
+        if (!item.contentHash.isEmpty()) {
+            file["contentHash"] = QString::fromLatin1(item.contentHash);
+        }
+        if (item.mediaInfo.durationMs > 0) {
+            file["duration"] = item.mediaInfo.durationSeconds();
+        }
+        files.append(file);
+        
+        batch.indices.append(index);
+        batch.offsets.append(offset);
+        batch.sizes.append(info.size());
+        offset += info.size();
+    }
+    if (batch.indices.isEmpty()) {
+        return;
+    }
+    
+    QJsonObject manifestObject;
+    manifestObject["files"] = files;
+    QByteArray manifest = QJsonDocument(manifestObject).toJson(QJsonDocument::Compact);
+    QByteArray header(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(manifest.size()), header.data());
+    
+    UploadStream *stream = new UploadStream();
+    stream->appendData(header + manifest);
+    for (int i = 0; i < batch.indices.size(); ++i) {
+        const UploadItem &item = m_uploadQueue[batch.indices.at(i)];
+        if (!stream->appendFile(item.filePath, 0, batch.sizes.at(i))) {
+            delete stream;
+            returnBatchItems(batch.indices, false);
+            return;
+        }
+    }
+    
+    // Offsets so far are relative to the first file
+    qint64 headerSize = header.size() + manifest.size();
+    for (qint64 &fileOffset : batch.offsets) {
+        fileOffset += headerSize;
+    }
+    stream->setBufferSize(m_streamBufferSize);
+    stream->open(QIODevice::ReadOnly);
+    
+    QNetworkRequest request = createApiRequest("/api/v1/media/upload-batch");
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/vnd.media-bundle");
+    request.setHeader(QNetworkRequest::ContentLengthHeader, stream->size());
+    
+    QNetworkReply *reply = m_networkManager->post(request, stream);
+    stream->setParent(reply);
+    connectReply(reply);
+    m_activeBatches.insert(reply, batch);
+}
+
+void UploadManager::returnBatchItems(const QList<int> &indices, bool batchable)
+{
+    // In reverse so the front of the queue keeps their original order
+    for (int i = indices.size() - 1; i >= 0; --i) {
+        int index = indices.at(i);
+        UploadItem &item = m_uploadQueue[index];
+        item.batchable = item.batchable && batchable;
+        m_batchBuffer.removeOne(index);
+        if (m_isPaused) {
+            updateItemStatus(index, "Paused");
+        }
+        setItemSentBytes(index, 0);
+        m_scheduler.enqueueFront(index);
+    }
+    
+    m_batchBufferBytes = 0;
+    for (int index : m_batchBuffer) {
+        m_batchBufferBytes += m_uploadQueue[index].fileSize;
+    }
+    if (m_batchBuffer.isEmpty()) {
+        m_batchTimer->stop();
+        m_batchDue = false;
+    }
+}
+
+void UploadManager::onBatchFinished(QNetworkReply *reply)
+{
+    UploadBatch batch = m_activeBatches.take(reply);
+    reply->deleteLater();
+    
+    QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+    int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    RequestFailure failure;
+    if (!(m_isPaused && reply->error() == QNetworkReply::OperationCanceledError)) {
+        failure = RetryPolicy::instance()->record(reply);
+    }
+    
+    if (reply->error() == QNetworkReply::NoError || (httpStatus == 500 && response.contains("results"))) {
+        // Each file reports on its own; failed ones are retried as single uploads
+        QList<int> failed;
+        QHash<int, QJsonObject> results;
+        const QJsonArray array = response.value("results").toArray();
+        for (const QJsonValue &value : array) {
+            QJsonObject result = value.toObject();
+            results.insert(result.value("index").toInt(-1), result);
+        }
+        for (int i = 0; i < batch.indices.size(); ++i) {
+            if (results.value(i).value("success").toBool()) {
+                completeItem(batch.indices.at(i), results.value(i).value("media").toObject());
+            } else {
+                failed.append(batch.indices.at(i));
+            }
+        }
+        returnBatchItems(failed, false);
+    } else if (m_isPaused && reply->error() == QNetworkReply::OperationCanceledError) {
+        returnBatchItems(batch.indices, true);
+    } else if (httpStatus >= 400 && httpStatus < 500 && httpStatus != 401 && httpStatus != 429) {
+        // The server cannot take this batch; a server without the endpoint never will
+        if (httpStatus == 404 || httpStatus == 415) {
+            m_batchEnabled = false;
+        }
+        returnBatchItems(batch.indices, false);
+    } else {
+        // Transient failure: retry the whole batch after a delay, counting it against every file
+        QList<int> retry;
+        for (int index : batch.indices) {
+            UploadItem &item = m_uploadQueue[index];
+            setItemSentBytes(index, 0);
+            if (failure.isRetryable() && item.retries < m_maxRetries) {
+                item.retries++;
+                updateItemStatus(index, QString("Retrying... (%1/%2)").arg(item.retries).arg(m_maxRetries));
+                retry.append(index);
+            } else {
+                updateItemStatus(index, "Failed");
+                releasePreprocessed(index);
+            }
+        }
+        
+        if (!retry.isEmpty()) {
+            qint64 delay = RetryPolicy::instance()->retryDelay(failure, m_uploadQueue[retry.first()].retries,
+                                                               QUrl(m_serverUrl));
+            m_scheduledRetries++;
+            quint64 generation = m_queueGeneration;
+            QTimer::singleShot(static_cast<int>(delay), this, [this, retry, generation]() {
+                if (generation != m_queueGeneration) {
+                    return;
+                }
+                m_scheduledRetries--;
+                for (int index : retry) {
+                    enqueuePending(index);
+                }
+                processNextUpload();
+            });
+        }
+    }
+    
+    QTimer::singleShot(0, this, &UploadManager::processNextUpload);
+}
+
+void UploadManager::startParts(int index)
+{
+    UploadItem &item = m_uploadQueue[index];
+    PartUpload &state = m_partUploads[index];
+    state = PartUpload();
+    for (auto it = item.partsDone.constBegin(); it != item.partsDone.constEnd(); ++it) {
+        state.doneBytes += partLength(item, *it);
+    }
+    setItemSentBytes(index, state.doneBytes);
+    pumpParts(index);
+}
+
+void UploadManager::pumpParts(int index)
+{
+    auto state = m_partUploads.find(index);
+    if (state == m_partUploads.end() || m_isPaused || state->failed) {
+        return;
+    }
+    UploadItem &item = m_uploadQueue[index];
+    
+    // A URL close to expiry could lapse while its part is on the wire
+    if (!item.partUrls.isEmpty() &&
+        item.partUrlsExpiry - QDateTime::currentMSecsSinceEpoch() < PART_URL_MARGIN) {
+        item.partUrls.clear();
+    }
+    
+    // Lowest missing parts first, so the journaled offset keeps moving
+    QList<int> unsignedParts;
+    int count = partCount(item);
+    for (int part = nextPartNumber(item); part <= count; ++part) {
+        if (item.partsDone.contains(part) || state->inFlight.contains(part) || state->waiting.contains(part)) {
+            continue;
+        }
+        if (state->inFlight.size() >= m_partConcurrency || unsignedParts.size() >= PRESIGN_BATCH) {
+            break;
+        }
+        if (!item.partUrls.contains(part)) {
+            unsignedParts.append(part);
+            continue;
+        }
+        
+        QNetworkReply *reply = createPartRequest(item, part);
+        if (!reply) {
+            updateItemStatus(index, "Cannot open file");
+            failParts(index, RequestFailure());
+            return;
+        }
+        state->inFlight.insert(part, 0);
+        m_activeParts.insert(reply, PartTransfer{index, part});
+    }
+    
+    if (!unsignedParts.isEmpty() && !state->presigning) {
+        state->presigning = true;
+        m_activeParts.insert(createPresignRequest(item, unsignedParts), PartTransfer{index, 0});
+    }
+}
+
+void UploadManager::onPartFinished(QNetworkReply *reply)
+{
+    PartTransfer transfer = m_activeParts.take(reply);
+    reply->deleteLater();
+    
+    auto state = m_partUploads.find(transfer.index);
+    if (state == m_partUploads.end()) {
+        return;
+    }
+    
+    int index = transfer.index;
+    UploadItem &item = m_uploadQueue[index];
+    
+    // Aborted by pause or by a sibling giving up; nothing to learn from it
+    bool aborted = reply->error() == QNetworkReply::OperationCanceledError && (m_isPaused || state->failed);
+    RequestFailure failure;
+    if (!aborted) {
+        failure = RetryPolicy::instance()->record(reply);
+    }
+    
+    if (transfer.partNumber == 0) {
+        state->presigning = false;
+        if (reply->error() == QNetworkReply::NoError) {
+            QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+            const QJsonArray parts = response.value("parts").toArray();
+            if (parts.isEmpty()) {
+                failParts(index, RequestFailure());
+                return;
+            }
+            for (const QJsonValue &value : parts) {
+                QJsonObject part = value.toObject();
+                item.partUrls.insert(part.value("partNumber").toInt(), QUrl(part.value("url").toString()));
+            }
+            
+            // One expiry covers every URL held, so keep the earliest
+            QDateTime expiresAt = QDateTime::fromString(response.value("expiresAt").toString(), Qt::ISODateWithMs);
+            qint64 expiry = expiresAt.isValid() ? expiresAt.toMSecsSinceEpoch() : 0;
+            item.partUrlsExpiry = item.partUrls.size() > parts.size() ? qMin(item.partUrlsExpiry, expiry) : expiry;
+            // Storage is usually another host than the API
+            NetworkTransport::instance()->prewarm(item.partUrls.constBegin().value());
+        } else if (!aborted) {
+            // No part can go out without a URL; the item retries as a whole
+            failParts(index, failure);
+            return;
+        }
+    } else {
+        state->inFlight.remove(transfer.partNumber);
+        if (reply->error() == QNetworkReply::NoError) {
+            item.partsDone.insert(transfer.partNumber);
+            item.partUrls.remove(transfer.partNumber);
+            state->retries.remove(transfer.partNumber);
+            state->doneBytes += partLength(item, transfer.partNumber);
+            while (item.partsDone.contains(nextPartNumber(item)) && item.uploadedBytes < item.fileSize) {
+                item.uploadedBytes = qMin(item.fileSize, item.uploadedBytes + item.partSize);
+            }
+            item.retries = 0; // progress was made, so earlier failures no longer count
+            journalItemState(index);
+        } else if (!aborted) {
+            if (failure.httpStatus == 403) {
+                // Storage refused the signature, most likely expired; sign the remaining parts again
+                item.partUrls.clear();
+                failure.kind = RequestFailure::Transient;
+            }
+            int attempts = ++state->retries[transfer.partNumber];
+            if (!failure.isRetryable() || attempts > m_maxRetries) {
+                failParts(index, failure);
+                return;
+            }
+            
+            // Only this part waits; the others keep their connections busy
+            state->waiting.insert(transfer.partNumber);
+            quint64 generation = m_queueGeneration;
+            int partNumber = transfer.partNumber;
+            qint64 delay = RetryPolicy::instance()->retryDelay(failure, attempts, reply->url());
+            QTimer::singleShot(static_cast<int>(delay), this, [this, index, partNumber, generation]() {
+                if (generation == m_queueGeneration) {
+                    retryPart(index, partNumber);
+                }
+            });
+        }
+        
+        qint64 sent = state->doneBytes;
+        for (auto it = state->inFlight.constBegin(); it != state->inFlight.constEnd(); ++it) {
+            sent += it.value();
+        }
+        setItemSentBytes(index, sent);
+    }
+    
+    pumpParts(index);
+    settleParts(index);
+}
+
+void UploadManager::retryPart(int index, int partNumber)
+{
+    auto state = m_partUploads.find(index);
+    if (state == m_partUploads.end()) {
+        return;
+    }
+    state->waiting.remove(partNumber);
+    pumpParts(index);
+}
+
+void UploadManager::failParts(int index, const RequestFailure &failure)
+{
+    auto state = m_partUploads.find(index);
+    if (state == m_partUploads.end()) {
+        return;
+    }
+    state->failed = true;
+    state->failure = failure;
+    
+    // Aborted replies finish right away and come back through onPartFinished()
+    QList<QNetworkReply*> replies;
+    for (auto it = m_activeParts.constBegin(); it != m_activeParts.constEnd(); ++it) {
+        if (it->index == index) {
+            replies.append(it.key());
+        }
+    }
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+    }
+    settleParts(index);
+}
+
+void UploadManager::settleParts(int index)
+{
+    auto state = m_partUploads.find(index);
+    if (state == m_partUploads.end() || !state->inFlight.isEmpty() || state->presigning) {
+        return;
+    }
+    
+    UploadItem &item = m_uploadQueue[index];
+    if (state->failed) {
+        RequestFailure failure = state->failure;
+        m_partUploads.erase(state);
+        retryItem(index, failure);
+    } else if (m_isPaused) {
+        // Parts storage already holds are found again through the session on resume
+        qint64 doneBytes = state->doneBytes;
+        m_partUploads.erase(state);
+        updateItemStatus(index, "Paused");
+        setItemSentBytes(index, doneBytes);
+        m_scheduler.enqueueFront(index);
+    } else if (item.partsDone.size() >= partCount(item)) {
+        // Every part is in storage; the slot moves on to the commit
+        m_partUploads.erase(state);
+        item.phase = UploadPhase::CompleteSession;
+        m_activeUploads.insert(createPhaseRequest(item), index);
+        return;
+    } else {
+        return;
+    }
+    QTimer::singleShot(0, this, &UploadManager::processNextUpload);
+}
+
+void UploadManager::finishIfIdle()
+{
+    if (!m_isUploading || m_quotaReply || !m_activeUploads.isEmpty() || !m_hashingItems.isEmpty() ||
+        !m_encodingItems.isEmpty() || !m_activeBatches.isEmpty() || !m_partUploads.isEmpty() ||
+        !m_batchBuffer.isEmpty() || !m_scheduler.isEmpty() || m_scheduledRetries > 0) {
+        return;
+    }
+    
+    m_isUploading = false;
+    emit uploadFinished();
+}
+
+void UploadManager::scanFolder(const QString &folderPath)
+{
+    QDirIterator it(folderPath, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    
+    while (it.hasNext()) {
+        QString filePath = it.next();
+        QFileInfo fileInfo(filePath);
+        
+        // Only add media files
+        QStringList mediaExtensions = {".mp4", ".avi", ".mov", ".mkv", ".mp3", ".wav", ".flac", ".jpg", ".jpeg", ".png", ".gif", ".bmp"};
+        if (mediaExtensions.contains(fileInfo.suffix().toLower())) {
+            enqueueItem(UploadItem(filePath));
+        }
+    }
+}
+
+QNetworkReply* UploadManager::createMultipartRequest(const UploadItem &item)
+{
+    QJsonObject metadata;
+    metadata["fileName"] = item.fileName;
+    metadata["fileSize"] = static_cast<qint64>(item.fileSize);
+    metadata["originalPath"] = item.filePath;
+    const QJsonObject media = item.mediaInfo.toJson();
+    for (auto it = media.constBegin(); it != media.constEnd(); ++it) {
+        metadata.insert(it.key(), it.value());
+    }
+    
+    QHash<QString, QString> fields;
+    if (!item.contentHash.isEmpty()) {
+        fields.insert("contentHash", QString::fromLatin1(item.contentHash));
+    }
+    if (item.mediaInfo.durationMs > 0) {
+        fields.insert("duration", QString::number(item.mediaInfo.durationSeconds(), 'f', 3));
+    }
+    
+    // Stream the file from disk instead of reading it into memory
+    UploadStream *stream = UploadStream::createMultipart(item.filePath, item.fileName, metadata, fields);
+    if (!stream) {
+        return nullptr;
+    }
+    stream->setBufferSize(m_streamBufferSize);
+    stream->open(QIODevice::ReadOnly);
+    
+    // Create request
+    QNetworkRequest request = createApiRequest("/api/v1/media/upload");
+    request.setHeader(QNetworkRequest::ContentTypeHeader, stream->contentType());
+    request.setHeader(QNetworkRequest::ContentLengthHeader, stream->size());
+    
+    // Send request
+    QNetworkReply *reply = m_networkManager->post(request, stream);
+    stream->setParent(reply); // Set parent for cleanup
+    
+    connectReply(reply);
+    return reply;
+}
+
+QNetworkReply* UploadManager::createPhaseRequest(const UploadItem &item)
+{
+    const QString sessionPath = QString("/api/v1/media/uploads/%1").arg(item.uploadId);
+    QNetworkReply *reply = nullptr;
+    
+    switch (item.phase) {
+    case UploadPhase::Hashing:
+    case UploadPhase::Batched:
+    case UploadPhase::SendParts: // several requests at once, see pumpParts()
+        return nullptr;
+    case UploadPhase::DedupeCheck: {
+        QJsonObject body;
+        body["contentHash"] = QString::fromLatin1(item.contentHash);
+        body["fileSize"] = static_cast<qint64>(item.fileSize);
+        
+        QNetworkRequest request = createApiRequest("/api/v1/media/dedupe-check");
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        reply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+        break;
+    }
+    case UploadPhase::Multipart:
+        return createMultipartRequest(item);
+    case UploadPhase::SendChunk:
+        return createChunkRequest(item);
+    case UploadPhase::CreateSession: {
+        QJsonObject body;
+        body["fileName"] = item.fileName;
+        body["fileSize"] = static_cast<qint64>(item.fileSize);
+        body["mimeType"] = QMimeDatabase().mimeTypeForFile(item.filePath).name();
+        if (!item.contentHash.isEmpty()) {
+            body["contentHash"] = QString::fromLatin1(item.contentHash);
+        }
+        if (m_directUploads) {
+            // Servers without direct support ignore this and stage the chunks
+            body["mode"] = "direct";
+        }
+        
+        QNetworkRequest request = createApiRequest("/api/v1/media/uploads");
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        reply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+        break;
+    }
+    case UploadPhase::QueryOffset:
+        reply = m_networkManager->get(createApiRequest(sessionPath));
+        break;
+    case UploadPhase::CompleteSession: {
+        QJsonObject body;
+        if (item.mediaInfo.durationMs > 0) {
+            body["duration"] = item.mediaInfo.durationSeconds();
+        }
+        
+        QNetworkRequest request = createApiRequest(sessionPath + "/complete");
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+        reply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+        break;
+    }
+    }
+    
+    if (reply) {
+        connectReply(reply);
+    }
+    return reply;
+}
+
+QNetworkReply* UploadManager::createChunkRequest(const UploadItem &item, const EncodedChunk *encoded)
+{
+    // Each chunk streams its own file range; nothing before uploadedBytes is re-sent
+    UploadStream *stream = new UploadStream();
+    qint64 length = 0;
+    if (encoded) {
+        length = encoded->length;
+        stream->appendData(encoded->data, true);
+    } else {
+        length = nextChunkLength(item);
+        if (!stream->appendFile(item.filePath, item.uploadedBytes, length)) {
+            delete stream;
+            return nullptr;
+        }
+    }
+    stream->setBufferSize(m_streamBufferSize);
+    stream->open(QIODevice::ReadOnly);
+    
+    QNetworkRequest request = createApiRequest(
+        QString("/api/v1/media/uploads/%1/chunks").arg(item.uploadId));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, stream->contentType());
+    request.setHeader(QNetworkRequest::ContentLengthHeader, stream->size());
+    request.setRawHeader("Upload-Offset", QByteArray::number(item.uploadedBytes));
+    if (encoded) {
+        // Offsets stay in file bytes; the server inflates before staging
+        request.setRawHeader("Content-Encoding", "deflate");
+    }
+    
+    QNetworkReply *reply = m_networkManager->put(request, stream);
+    stream->setParent(reply);
+    
+    ChunkTiming &timing = m_chunkTimings[reply];
+    timing.bytes = length;
+    timing.timer.start();
+    
+    connectReply(reply);
+    return reply;
+}
+
+QNetworkReply* UploadManager::createPresignRequest(const UploadItem &item, const QList<int> &partNumbers)
+{
+    QJsonArray parts;
+    for (int part : partNumbers) {
+        parts.append(part);
+    }
+    QJsonObject body;
+    body["partNumbers"] = parts;
+    
+    QNetworkRequest request = createApiRequest(QString("/api/v1/media/uploads/%1/parts").arg(item.uploadId));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    QNetworkReply *reply = m_networkManager->post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+    connectReply(reply);
+    return reply;
+}
+
+QNetworkReply* UploadManager::createPartRequest(const UploadItem &item, int partNumber)
+{
+    QUrl url = item.partUrls.value(partNumber);
+    qint64 offset = (partNumber - 1) * item.partSize;
+    qint64 length = partLength(item, partNumber);
+    UploadStream *stream = new UploadStream();
+    if (!url.isValid() || length <= 0 || !stream->appendFile(item.filePath, offset, length)) {
+        delete stream;
+        return nullptr;
+    }
+    stream->setBufferSize(m_streamBufferSize);
+    stream->open(QIODevice::ReadOnly);
+    
+    // The signature is the authorization; storage would reject our bearer token
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/octet-stream");
+    request.setHeader(QNetworkRequest::ContentLengthHeader, stream->size());
+    
+    QNetworkReply *reply = m_networkManager->put(request, stream);
+    stream->setParent(reply);
+    
+    connectReply(reply);
+    return reply;
+}
+
+int UploadManager::nextPartNumber(const UploadItem &item) const
+{
+    return item.partSize > 0 ? static_cast<int>(item.uploadedBytes / item.partSize) + 1 : 1;
+}
+
+int UploadManager::partCount(const UploadItem &item) const
+{
+    return item.partSize > 0 ? static_cast<int>((item.fileSize + item.partSize - 1) / item.partSize) : 0;
+}
+
+qint64 UploadManager::partLength(const UploadItem &item, int partNumber) const
+{
+    return qBound<qint64>(0, item.fileSize - (partNumber - 1) * item.partSize, item.partSize);
+}
+
+void UploadManager::clearSession(UploadItem &item)
+{
+    item.uploadId.clear();
+    item.uploadedBytes = 0;
+    item.direct = false;
+    item.partSize = 0;
+    item.partsDone.clear();
+    item.partUrls.clear();
+    item.partUrlsExpiry = 0;
+}
+
+qint64 UploadManager::nextChunkLength(const UploadItem &item)
+{
+    qint64 length = qMin(chunkSizerFor(item.filePath).chunkSize(), item.fileSize - item.uploadedBytes);
+    if (shouldCompress(item)) {
+        length = qMin(length, m_encoder->maxChunkSize());
+    }
+    return length;
+}
+
+bool UploadManager::shouldCompress(const UploadItem &item) const
+{
+    return m_compressionEnabled && (!item.compressionProbed || item.compressChunks) &&
+           m_encoder->isCandidate(item.filePath);
+}
+
+void UploadManager::startChunkEncode(int index)
+{
+    UploadItem &item = m_uploadQueue[index];
+    m_encodingItems.insert(item.filePath, index);
+    m_encoder->encode(item.filePath, item.uploadedBytes, nextChunkLength(item), !item.compressionProbed);
+}
+
+QNetworkRequest UploadManager::createApiRequest(const QString &path) const
+{
+    QUrl url(m_serverUrl);
+    url.setPath(path);
+    
+    QNetworkRequest request(url);
+    if (!m_authToken.isEmpty()) {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_authToken).toUtf8());
+    }
+    return request;
+}
+
+void UploadManager::connectReply(QNetworkReply *reply)
+{
+    connect(reply, &QNetworkReply::uploadProgress, this, &UploadManager::onUploadProgress);
+    connect(reply, &QNetworkReply::finished, this, &UploadManager::onUploadFinished);
+    connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
+            this, &UploadManager::onNetworkError);
+}
+
+bool UploadManager::isChunked(const UploadItem &item) const
+{
+    // Small files fit in one request; a session would only add round trips
+    return item.fileSize > m_chunkSize;
+}
+
+bool UploadManager::advanceUpload(UploadItem &item, const QJsonObject &response)
+{
+    switch (item.phase) {
+    case UploadPhase::DedupeCheck:
+        item.dedupeChecked = true;
+        if (response.value("exists").toBool()) {
+            return false; // server already has it; nothing to send
+        }
+        item.phase = isChunked(item) ? UploadPhase::CreateSession : UploadPhase::Multipart;
+        return true;
+    case UploadPhase::Hashing:
+    case UploadPhase::Multipart:
+    case UploadPhase::Batched:
+    case UploadPhase::SendParts:
+    case UploadPhase::CompleteSession:
+        return false;
+    case UploadPhase::CreateSession:
+    case UploadPhase::QueryOffset: {
+        QJsonObject session = response.value("session").toObject();
+        if (session.value("status").toString() != "active") {
+            // Expired or already finished on the server: open a new session
+            clearSession(item);
+            item.phase = UploadPhase::CreateSession;
+            return true;
+        }
+        item.uploadId = session.value("id").toString();
+        item.direct = session.value("mode").toString() == "direct";
+        if (!item.direct) {
+            item.uploadedBytes = session.value("receivedBytes").toVariant().toLongLong();
+            break;
+        }
+        
+        // Parts finish in any order; only the ones storage is missing are sent
+        item.partSize = session.value("partSize").toVariant().toLongLong();
+        if (item.partSize <= 0) {
+            clearSession(item);
+            item.phase = UploadPhase::CreateSession;
+            return true;
+        }
+        item.partsDone.clear();
+        for (const QJsonValue &part : session.value("uploadedParts").toArray()) {
+            item.partsDone.insert(part.toObject().value("partNumber").toInt());
+        }
+        item.uploadedBytes = 0;
+        while (item.partsDone.contains(nextPartNumber(item)) && item.uploadedBytes < item.fileSize) {
+            item.uploadedBytes = qMin(item.fileSize, item.uploadedBytes + item.partSize);
+        }
+        break;
+    }
+    case UploadPhase::SendChunk:
+        item.uploadedBytes = response.value("receivedBytes").toVariant().toLongLong();
+        item.retries = 0; // progress was made, so earlier failures no longer count
+        break;
+    }
+    
+    if (item.uploadedBytes >= item.fileSize) {
+        item.phase = UploadPhase::CompleteSession;
+    } else if (item.direct) {
+        item.phase = UploadPhase::SendParts;
+    } else {
+        item.phase = UploadPhase::SendChunk;
+    }
+    return true;
+}
+
+ChunkSizer& UploadManager::chunkSizerFor(const QString &filePath)
+{
+    auto it = m_chunkSizers.find(filePath);
+    if (it == m_chunkSizers.end()) {
+        it = m_chunkSizers.insert(filePath, m_chunkSizer);
+    }
+    return it.value();
+}
+
+void UploadManager::recordChunkResult(QNetworkReply *reply, const UploadItem &item, bool acknowledged)
+{
+    auto timing = m_chunkTimings.constFind(reply);
+    if (timing == m_chunkTimings.constEnd() || item.phase != UploadPhase::SendChunk) {
+        return;
+    }
+    
+    ChunkSizer &sizer = chunkSizerFor(item.filePath);
+    if (acknowledged) {
+        // "Sent" means handed to the socket, so the ack time also covers draining its buffer
+        qint64 total = timing->timer.elapsed();
+        qint64 sent = timing->sentMsec >= 0 ? timing->sentMsec : total;
+        sizer.addSample(timing->bytes, sent, total - sent);
+    } else {
+        sizer.addFailure();
+    }
+    
+    // New transfers start from the most recent view of the link
+    m_chunkSizer = sizer;
+    emit chunkStatsChanged(m_chunkSizer.stats());
+}
+
+void UploadManager::updateItemProgress(int index, int progress)
+{
+    if (index >= 0 && index < m_uploadQueue.size() && m_uploadQueue[index].progress != progress) {
+        m_uploadQueue[index].progress = progress;
+        m_updates->setProgress(index, progress);
+    }
+}
+
+void UploadManager::setItemSentBytes(int index, qint64 bytes)
+{
+    UploadItem &item = m_uploadQueue[index];
+    bytes = qBound<qint64>(0, bytes, item.fileSize);
+    m_sentBytes += bytes - item.sentBytes;
+    item.sentBytes = bytes;
+    
+    updateItemProgress(index, item.fileSize > 0 ? static_cast<int>((bytes * 100) / item.fileSize) : 0);
+    updateOverallProgress();
+}
+
+void UploadManager::markItemCompleted(int index)
+{
+    UploadItem &item = m_uploadQueue[index];
+    m_sentBytes -= item.sentBytes;
+    item.sentBytes = 0;
+    m_completedBytes += item.fileSize;
+    
+    updateItemProgress(index, 100);
+    updateOverallProgress();
+}
+
+void UploadManager::updateOverallProgress()
+{
+    int progress = m_totalBytes > 0
+        ? static_cast<int>(((m_completedBytes + m_sentBytes) * 100) / m_totalBytes)
+        : 0;
+    if (progress != m_overallProgress) {
+        m_overallProgress = progress;
+        emit uploadProgress(progress);
+    }
+}
+
+void UploadManager::updateItemStatus(int index, const QString &status)
+{
+    if (index >= 0 && index < m_uploadQueue.size()) {
+        m_uploadQueue[index].status = status;
+        journalItemState(index);
+        m_updates->setStatus(index, status);
+    }
+}
+
+void UploadManager::enqueueItem(const UploadItem &item)
+{
+    m_uploadQueue.enqueue(item);
+    m_totalBytes += item.fileSize;
+    
+    QFileInfo info(item.filePath);
+    m_journal->recordAdded(item.filePath, item.fileSize, info.lastModified().toMSecsSinceEpoch());
+    if (item.priority != 0) {
+        m_journal->recordPriority(item.filePath, item.priority);
+    }
+}
+
+void UploadManager::restoreFromJournal()
+{
+    const QList<JournalEntry> entries = m_journal->replay();
+    
+    for (const JournalEntry &entry : entries) {
+        QFileInfo info(entry.filePath);
+        if (!info.exists() || !info.isFile()) {
+            m_journal->recordRemoved(entry.filePath);
+            continue;
+        }
+        
+        UploadItem item(entry.filePath);
+        item.priority = entry.priority;
+        bool unchanged = info.size() == entry.fileSize &&
+                         info.lastModified().toMSecsSinceEpoch() == entry.lastModified;
+        
+        if (unchanged && !entry.uploadId.isEmpty()) {
+            // The server is asked for the real offset before the next chunk is sent
+            item.uploadId = entry.uploadId;
+            item.uploadedBytes = qBound<qint64>(0, entry.uploadedBytes, item.fileSize);
+            item.sentBytes = item.uploadedBytes;
+            item.progress = item.fileSize > 0 ? static_cast<int>((item.uploadedBytes * 100) / item.fileSize) : 0;
+        } else if (!unchanged) {
+            m_journal->recordAdded(entry.filePath, info.size(), info.lastModified().toMSecsSinceEpoch());
+        }
+        
+        // Anything that was mid-transfer resumes on its own once we are signed in
+        if (entry.status == "Uploading..." || entry.status == "Hashing..." ||
+            entry.status.startsWith("Retrying")) {
+            m_resumeOnAuth = true;
+        }
+        
+        item.status = item.uploadId.isEmpty() ? "Pending" : "Paused";
+        m_uploadQueue.enqueue(item);
+        m_totalBytes += item.fileSize;
+        m_sentBytes += item.sentBytes;
+    }
+    
+    updateOverallProgress();
+}
+
+void UploadManager::journalItemState(int index)
+{
+    const UploadItem &item = m_uploadQueue[index];
+    m_journal->recordState(item.filePath, item.status, item.uploadId, item.uploadedBytes);
+}
+
+void UploadManager::abortActiveUploads()
+{
+    m_queueGeneration++;
+    
+    QList<QNetworkReply*> replies = m_activeUploads.keys();
+    replies += m_activeBatches.keys();
+    replies += m_activeParts.keys();
+    m_activeUploads.clear();
+    m_activeBatches.clear();
+    m_activeParts.clear();
+    m_partUploads.clear();
+    m_encodingItems.clear();
+    m_chunkTimings.clear();
+    for (QNetworkReply *reply : replies) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
     }
 }
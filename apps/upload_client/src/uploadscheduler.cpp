@@ -0,0 +1,132 @@
+#include "uploadscheduler.h"
+#include <QtGlobal>
+
+UploadScheduler::UploadScheduler()
+    : m_smallFileThreshold(16 * 1024 * 1024) // 16MB
+    , m_largeFileDelay(120000) // 2 minutes
+    , m_priorityStep(600000) // 10 minutes
+{
+    m_clock.start();
+}
+
+void UploadScheduler::setSmallFileThreshold(qint64 bytes)
+{
+    m_smallFileThreshold = qMax<qint64>(0, bytes);
+}
+
+qint64 UploadScheduler::smallFileThreshold() const
+{
+    return m_smallFileThreshold;
+}
+
+void UploadScheduler::setLargeFileDelay(qint64 msec)
+{
+    m_largeFileDelay = qMax<qint64>(0, msec);
+}
+
+qint64 UploadScheduler::largeFileDelay() const
+{
+    return m_largeFileDelay;
+}
+
+void UploadScheduler::setPriorityStep(qint64 msec)
+{
+    m_priorityStep = qMax<qint64>(0, msec);
+}
+
+qint64 UploadScheduler::priorityStep() const
+{
+    return m_priorityStep;
+}
+
+void UploadScheduler::enqueue(int index, qint64 fileSize, int priority)
+{
+    qint64 now = m_clock.elapsed();
+    m_enqueuedAt.insert(index, now);
+
+    qint64 laneDelay = fileSize > m_smallFileThreshold ? m_largeFileDelay : 0;
+    insert(index, now + laneDelay - priority * m_priorityStep);
+}
+
+void UploadScheduler::enqueueFront(int index)
+{
+    remove(index);
+    qint64 front = m_order.empty() ? m_clock.elapsed() : m_order.begin()->first;
+    m_enqueuedAt.insert(index, m_clock.elapsed());
+    insert(index, front - 1);
+}
+
+void UploadScheduler::setPriority(int index, qint64 fileSize, int priority)
+{
+    auto it = m_enqueuedAt.constFind(index);
+    if (it == m_enqueuedAt.constEnd()) {
+        return;
+    }
+
+    // Keep the original enqueue time so the time already waited still counts
+    qint64 laneDelay = fileSize > m_smallFileThreshold ? m_largeFileDelay : 0;
+    insert(index, it.value() + laneDelay - priority * m_priorityStep);
+}
+
+void UploadScheduler::remove(int index)
+{
+    auto it = m_deadlines.find(index);
+    if (it == m_deadlines.end()) {
+        return;
+    }
+    m_order.erase(Key(it.value(), index));
+    m_deadlines.erase(it);
+    m_enqueuedAt.remove(index);
+}
+
+int UploadScheduler::takeNext()
+{
+    if (m_order.empty()) {
+        return -1;
+    }
+
+    int index = m_order.begin()->second;
+    m_order.erase(m_order.begin());
+    m_deadlines.remove(index);
+    m_enqueuedAt.remove(index);
+    return index;
+}
+
+int UploadScheduler::peekNext() const
+{
+    return m_order.empty() ? -1 : m_order.begin()->second;
+}
+
+bool UploadScheduler::contains(int index) const
+{
+    return m_deadlines.contains(index);
+}
+
+bool UploadScheduler::isEmpty() const
+{
+    return m_order.empty();
+}
+
+int UploadScheduler::size() const
+{
+    return static_cast<int>(m_order.size());
+}
+
+void UploadScheduler::clear()
+{
+    m_order.clear();
+    m_deadlines.clear();
+    m_enqueuedAt.clear();
+}
+
+void UploadScheduler::insert(int index, qint64 deadline)
+{
+    auto it = m_deadlines.find(index);
+    if (it != m_deadlines.end()) {
+        m_order.erase(Key(it.value(), index));
+        it.value() = deadline;
+    } else {
+        m_deadlines.insert(index, deadline);
+    }
+    m_order.insert(Key(deadline, index));
+}
@@ -0,0 +1,354 @@
+#include "uploadstream.h"
+#include "bandwidthlimiter.h"
+#include "memorybudget.h"
+#include "readaheadpool.h"
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <cstring>
+
+const qint64 UploadStream::DEFAULT_BUFFER_SIZE = 1024 * 1024; // 1MB
+
+UploadStream::UploadStream(QObject *parent)
+    : QIODevice(parent)
+    , m_size(0)
+    , m_position(0)
+    , m_budgetedBytes(0)
+    , m_fileSegment(-1)
+    , m_bufferStart(0)
+    , m_bufferSize(DEFAULT_BUFFER_SIZE)
+    , m_waitingOffset(-1)
+{
+    connect(ReadAheadPool::instance(), &ReadAheadPool::blockReady, this, &UploadStream::onBlockReady);
+}
+
+UploadStream::~UploadStream()
+{
+    close();
+    MemoryBudget::instance()->release(m_budgetedBytes);
+}
+
+void UploadStream::appendData(const QByteArray &data, bool budgeted)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+    if (budgeted) {
+        MemoryBudget::instance()->acquire(data.size());
+        m_budgetedBytes += data.size();
+    }
+
+    Segment segment;
+    segment.data = data;
+    segment.length = data.size();
+    segment.start = m_size;
+    m_segments.append(segment);
+    m_size += segment.length;
+}
+
+bool UploadStream::appendFile(const QString &filePath, qint64 offset, qint64 length)
+{
+    QFileInfo fileInfo(filePath);
+    if (!fileInfo.exists() || !fileInfo.isFile() || !fileInfo.isReadable()) {
+        m_errorFilePath = filePath;
+        return false;
+    }
+
+    qint64 available = fileInfo.size() - offset;
+    if (offset < 0 || available < 0) {
+        m_errorFilePath = filePath;
+        return false;
+    }
+    if (length < 0 || length > available) {
+        length = available;
+    }
+
+    Segment segment;
+    segment.filePath = filePath;
+    segment.fileOffset = offset;
+    segment.fileSize = fileInfo.size();
+    segment.length = length;
+    segment.start = m_size;
+    m_segments.append(segment);
+    m_size += length;
+    return true;
+}
+
+void UploadStream::setBufferSize(qint64 size)
+{
+    m_bufferSize = qMax<qint64>(4096, size);
+}
+
+qint64 UploadStream::bufferSize() const
+{
+    return m_bufferSize;
+}
+
+QString UploadStream::errorFilePath() const
+{
+    return m_errorFilePath;
+}
+
+UploadStream* UploadStream::createMultipart(const QString &filePath, const QString &fileName,
+                                            const QJsonObject &metadata,
+                                            const QHash<QString, QString> &fields, QObject *parent)
+{
+    UploadStream *stream = new UploadStream(parent);
+    stream->m_boundary = "UploadClientBoundary" +
+        QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+
+    const QByteArray delimiter = "--" + stream->m_boundary + "\r\n";
+
+    // Metadata goes first so the server sees it before the file body arrives
+    if (!metadata.isEmpty()) {
+        QByteArray metadataPart = delimiter;
+        metadataPart += "Content-Disposition: form-data; name=\"metadata\"\r\n\r\n";
+        metadataPart += QJsonDocument(metadata).toJson(QJsonDocument::Compact);
+        metadataPart += "\r\n";
+        stream->appendData(metadataPart);
+    }
+
+    for (auto it = fields.cbegin(); it != fields.cend(); ++it) {
+        QByteArray fieldPart = delimiter;
+        fieldPart += QString("Content-Disposition: form-data; name=\"%1\"\r\n\r\n").arg(it.key()).toUtf8();
+        fieldPart += it.value().toUtf8();
+        fieldPart += "\r\n";
+        stream->appendData(fieldPart);
+    }
+
+    QByteArray fileHeader = delimiter;
+    fileHeader += "Content-Type: application/octet-stream\r\n";
+    fileHeader += QString("Content-Disposition: form-data; name=\"file\"; filename=\"%1\"\r\n\r\n")
+                      .arg(fileName).toUtf8();
+    stream->appendData(fileHeader);
+
+    if (!stream->appendFile(filePath)) {
+        delete stream;
+        return nullptr;
+    }
+
+    stream->appendData("\r\n--" + stream->m_boundary + "--\r\n");
+    return stream;
+}
+
+QByteArray UploadStream::boundary() const
+{
+    return m_boundary;
+}
+
+QByteArray UploadStream::contentType() const
+{
+    if (m_boundary.isEmpty()) {
+        return "application/octet-stream";
+    }
+    return "multipart/form-data; boundary=" + m_boundary;
+}
+
+bool UploadStream::open(OpenMode mode)
+{
+    if (mode & QIODevice::WriteOnly) {
+        return false;
+    }
+
+    // Our own read-ahead buffer replaces QIODevice's internal one
+    m_position = 0;
+    if (!QIODevice::open(mode | QIODevice::Unbuffered)) {
+        return false;
+    }
+
+    // The first file range is read while the headers in front of it go out
+    for (const Segment &segment : m_segments) {
+        if (!segment.filePath.isEmpty()) {
+            ReadAheadPool::instance()->prefetch(segment.filePath, segment.fileOffset,
+                                                qMin(m_bufferSize, segment.fileSize - segment.fileOffset));
+            break;
+        }
+    }
+    return true;
+}
+
+void UploadStream::close()
+{
+    BandwidthLimiter::instance()->release(this);
+
+    // Blocks prefetched past the current one stay in the pool for the next
+    // chunk of the same file
+    ReadAheadPool::instance()->recycle(m_buffer);
+    m_fileSegment = -1;
+    m_bufferStart = 0;
+    m_waitingOffset = -1;
+    m_position = 0;
+
+    QIODevice::close();
+}
+
+bool UploadStream::isSequential() const
+{
+    return false;
+}
+
+qint64 UploadStream::size() const
+{
+    return m_size;
+}
+
+bool UploadStream::seek(qint64 pos)
+{
+    if (pos < 0 || pos > m_size) {
+        return false;
+    }
+
+    QIODevice::seek(pos);
+    m_position = pos;
+    return true;
+}
+
+bool UploadStream::reset()
+{
+    return seek(0);
+}
+
+qint64 UploadStream::readData(char *data, qint64 maxSize)
+{
+    if (m_position >= m_size) {
+        return 0;
+    }
+
+    // Disk before bandwidth, so a body waiting for its next block holds no
+    // tokens; readyRead() follows once the block is read
+    int index = segmentAt(m_position);
+    const Segment &segment = m_segments.at(index);
+    qint64 segmentPos = m_position - segment.start;
+    const char *source = nullptr;
+    qint64 available = 0;
+
+    if (segment.filePath.isEmpty()) {
+        source = segment.data.constData() + segmentPos;
+        available = segment.length - segmentPos;
+    } else {
+        if (!isBuffered(index)) {
+            int loaded = loadBlock(index, segmentPos);
+            if (loaded <= 0) {
+                return loaded;
+            }
+        }
+        qint64 bufferPos = m_position - m_bufferStart;
+        source = m_buffer.constData() + bufferPos;
+        available = qMin(m_buffer.size() - bufferPos, segment.length - segmentPos);
+    }
+
+    qint64 chunk = qMin(maxSize, available);
+    BandwidthLimiter *limiter = BandwidthLimiter::instance();
+    if (limiter->isLimited()) {
+        // Returning nothing is how writes are paced; readyRead() follows the refill
+        chunk = limiter->acquire(this, chunk);
+        if (chunk == 0) {
+            return 0;
+        }
+    }
+
+    std::memcpy(data, source, chunk);
+    m_position += chunk;
+
+    if (m_position >= m_size) {
+        limiter->release(this);
+    }
+    return chunk;
+}
+
+qint64 UploadStream::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+int UploadStream::segmentAt(qint64 pos) const
+{
+    // Binary search over segment start offsets
+    int low = 0;
+    int high = m_segments.size() - 1;
+    while (low < high) {
+        int mid = (low + high + 1) / 2;
+        if (m_segments.at(mid).start <= pos) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+bool UploadStream::isBuffered(int index) const
+{
+    return m_fileSegment == index &&
+           m_position >= m_bufferStart &&
+           m_position < m_bufferStart + m_buffer.size();
+}
+
+int UploadStream::loadBlock(int index, qint64 segmentPos)
+{
+    const Segment &segment = m_segments.at(index);
+    ReadAheadPool *pool = ReadAheadPool::instance();
+
+    // Blocks sit at fixed places in the file, not in the range, so the next
+    // chunk of a file finds the block this one prefetched past its end even
+    // when the chunk boundary falls inside it
+    qint64 filePos = segment.fileOffset + segmentPos;
+    qint64 offset = filePos - filePos % pool->blockSize();
+
+    pool->recycle(m_buffer);
+    m_fileSegment = -1;
+
+    switch (pool->take(segment.filePath, offset, &m_buffer)) {
+    case ReadAheadPool::Ready:
+        break;
+    case ReadAheadPool::Failed:
+        m_errorFilePath = segment.filePath;
+        setErrorString(QString("Cannot read file: %1").arg(segment.filePath));
+        return -1;
+    case ReadAheadPool::Missing:
+        pool->fetch(segment.filePath, offset, true);
+        m_waitingOffset = offset;
+        return 0;
+    case ReadAheadPool::Pending:
+        m_waitingOffset = offset;
+        return 0;
+    }
+
+    m_waitingOffset = -1;
+    if (m_buffer.size() <= filePos - offset) {
+        // File shrank while streaming
+        pool->recycle(m_buffer);
+        m_errorFilePath = segment.filePath;
+        setErrorString(QString("Cannot read file: %1").arg(segment.filePath));
+        return -1;
+    }
+
+    m_fileSegment = index;
+    // Before the start of the range when the range starts mid-block
+    m_bufferStart = segment.start + (offset - segment.fileOffset);
+    prefetch(index, offset + m_buffer.size());
+    return 1;
+}
+
+void UploadStream::prefetch(int index, qint64 fileOffset)
+{
+    // Past the end of the range too: the next chunk of the file will want it
+    const Segment &segment = m_segments.at(index);
+    qint64 length = qMin(m_bufferSize, segment.fileSize - fileOffset);
+    if (length > 0) {
+        ReadAheadPool::instance()->prefetch(segment.filePath, fileOffset, length);
+    }
+}
+
+void UploadStream::onBlockReady(const QString &filePath, qint64 offset)
+{
+    if (offset != m_waitingOffset || !isOpen() || m_position >= m_size) {
+        return;
+    }
+    if (m_segments.at(segmentAt(m_position)).filePath == filePath) {
+        m_waitingOffset = -1;
+        emit readyRead();
+    }
+}